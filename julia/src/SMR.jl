@@ -1,19 +1,24 @@
 module SMR
 
-include("./SMRTypes.jl")
-
-using .SMRTypes
-
-export read_wavemark_channel, read_continuous_channel, read_event_channel,
-       read_marker_channel, read_channel_info, get_channel_type, channel_string,
-       get_read_function
-
 include("./helpers.jl")
 
 # ============================================================================ #
-# global constant path to libsmr shared object file
+# global constant path to libsmr shared object file (defined before SMRTypes,
+# which frees the buffers it takes ownership of through libsmr)
 const LIBSMR = @libpath("libsmr", @__DIR__, "..", "lib")
 
+include("./SMRTypes.jl")
+
+using .SMRTypes
+
+export read_wavemark_channel, read_continuous_channel, read_decimated_channel,
+       read_filtered_channel, read_snippets, read_epochs, read_realwave_channel,
+       read_event_channel, read_level_channel, read_marker_channel,
+       read_realmarker_channel, read_channel_info, get_channel_type, channel_string,
+       get_read_function, set_cache_size, clear_cache, cache_info, SMRFile,
+       read_channel, read_channels, lazy_channel, read_marker_timestamps,
+       set_open_flags
+
 # ============================================================================ #
 """
 `idx = get_channel_index(ifile, label)`
@@ -31,11 +36,15 @@ end
 # ============================================================================ #
 """
 `wmrk = read_wavemark_channel(ifile::String, idx::Integer)` *OR*\n
-`wmrk = read_wavemark_channel(ifile::String, label::String)`
+`wmrk = read_wavemark_channel(ifile::String, label::String)` *OR*\n
+`wmrk = read_wavemark_channel(ifile::String, idx::Integer, codes::AbstractVector{<:Integer})`
 ### Input:
 * ifile - the path to a .smr file
 * idx - an integer channel index
 * label - the channel label as a String
+* codes - only read the spikes whose unit code (`markers[1,:]`, as assigned by
+          the spike sorter) is one of these. records are filtered as the
+          channel is decoded, so the waveforms of other units are never copied
 
 ### Output:
 * wmrk - a SMRWMrkChannel type with fields:\n
@@ -69,6 +78,290 @@ function read_continuous_channel(ifile::String, label::String)
 end
 # ============================================================================ #
 """
+`cont = read_decimated_channel(ifile::String, idx::Integer, factor::Integer)` *OR*\n
+`cont = read_decimated_channel(ifile::String, label::String, factor::Integer)`
+Read a continuous channel low pass filtered and downsampled by `factor` (e.g. 25
+to go from 25 kHz to 1 kHz) without loading the full rate data.
+### Input:
+ * see `read_wavemark_channel`
+ * factor - integer downsampling factor, at most 12500
+
+### Output:
+* cont - a SMRContChannel type (see `read_continuous_channel`) with sampling
+         rate reduced by `factor`
+"""
+function read_decimated_channel(ifile::String, idx::Integer, factor::Integer)
+    if splitext(ifile)[2] != ".smr"
+        error("Input file is not an smr file")
+    end
+
+    ptr = ccall((:read_continuous_channel_decimated, LIBSMR),
+        Ptr{cSMRContChannel}, (Cstring, Cint, Cint), ifile, Cint(idx),
+        Cint(factor))
+
+    if ptr == C_NULL
+        error("call to read_continuous_channel_decimated failed")
+    end
+
+    out = SMRContChannel(unsafe_load(ptr))
+    ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+
+    return out
+end
+function read_decimated_channel(ifile::String, label::String, factor::Integer)
+    return read_decimated_channel(ifile, get_channel_index(ifile, label), factor)
+end
+# ============================================================================ #
+"""
+`filt = read_filtered_channel(ifile::String, idx::Integer; <kwargs>)` *OR*\n
+`filt = read_filtered_channel(ifile::String, label::String; <kwargs>)`
+Band-pass filter a continuous channel and / or detect threshold crossings of the
+filtered signal as the channel is read (the raw data is never loaded in full).
+### Input:
+ * see `read_wavemark_channel`
+ * low, high - filter corners in Hz (default 300 and 6000, <= 0 disables)
+ * order - Butterworth order of each corner (even, default 4)
+ * threshold - crossing threshold of the filtered signal in ADC units, negative
+               for downward crossings (default 0 = no detection)
+ * dead_time - minimum time between crossings in seconds (default 0.001)
+ * data - whether to return the filtered data (default true)
+
+### Output:
+* filt - a SMRFilteredChannel type with fields:\n
+            data: Nx1 Vector{Float32} of filtered samples (empty if !data)
+            sampling_rate: channel sampling rate in Hz
+            crossings: Vector{Float64} of threshold crossing times in seconds
+"""
+function read_filtered_channel(ifile::String, idx::Integer; low::Real=300.0,
+    high::Real=6000.0, order::Integer=4, threshold::Real=0.0,
+    dead_time::Real=0.001, data::Bool=true)
+
+    if splitext(ifile)[2] != ".smr"
+        error("Input file is not an smr file")
+    end
+
+    emit = (data ? 0x01 : 0x00) | (threshold != 0 ? 0x02 : 0x00)
+    cfg = Ref(cSMRFilterConfig(low, high, order, threshold, dead_time, emit))
+
+    ptr = ccall((:read_filtered_channel, LIBSMR), Ptr{cSMRFilteredChannel},
+        (Cstring, Cint, Ref{cSMRFilterConfig}), ifile, Cint(idx), cfg)
+
+    if ptr == C_NULL
+        error("call to read_filtered_channel failed")
+    end
+
+    out = SMRFilteredChannel(unsafe_load(ptr))
+    ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+
+    return out
+end
+function read_filtered_channel(ifile::String, label::String; kwargs...)
+    return read_filtered_channel(ifile, get_channel_index(ifile, label); kwargs...)
+end
+# ============================================================================ #
+"""
+`snip = read_snippets(ifile::String, idx::Integer, times::Vector{Float64}, pre::Real, post::Real)` *OR*\n
+`snip = read_snippets(ifile::String, label::String, times::Vector{Float64}, pre::Real, post::Real)`
+Extract the samples from `pre` seconds before to `post` seconds after each
+timestamp in `times` from a continuous channel, reading only the blocks that
+contain them.
+### Input:
+ * see `read_wavemark_channel`
+ * times - timestamps in seconds (e.g. from `read_event_channel`)
+ * pre, post - window around each timestamp in seconds
+
+### Output:
+* snip - a SMRWMrkChannel (see `read_wavemark_channel`), wavemarks[:,k] is the
+         snippet around times[k], samples outside of the recording are 0
+"""
+function read_snippets(ifile::String, idx::Integer, times::Vector{Float64},
+    pre::Real, post::Real)
+
+    if splitext(ifile)[2] != ".smr"
+        error("Input file is not an smr file")
+    end
+
+    ptr = ccall((:read_continuous_snippets, LIBSMR), Ptr{cSMRWMrkChannel},
+        (Cstring, Cint, Ptr{Float64}, UInt64, Float64, Float64), ifile,
+        Cint(idx), times, UInt64(length(times)), Float64(pre), Float64(post))
+
+    if ptr == C_NULL
+        error("call to read_continuous_snippets failed")
+    end
+
+    out = SMRWMrkChannel(unsafe_load(ptr))
+    ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+
+    return out
+end
+function read_snippets(ifile::String, label::String, times::Vector{Float64},
+    pre::Real, post::Real)
+    return read_snippets(ifile, get_channel_index(ifile, label), times, pre, post)
+end
+# ============================================================================ #
+"""
+`ep = read_epochs(ifile::String, idx::Vector{<:Integer}, triggers::Vector{Float64}, pre::Real, post::Real)`
+Extract the data from `pre` seconds before to `post` seconds after each trigger
+in `triggers` from several channels at once, the blocks of all channels are
+read in a single pass through the file.
+### Input:
+ * ifile - the path to a .smr file
+ * idx - integer channel indices (continuous, event, level or marker kinds)
+ * triggers - trigger times in seconds
+ * pre, post - window around each trigger in seconds
+
+### Output:
+* ep - a Vector{SMREpochChannel}, one per channel with fields:\n
+            data: for continuous channels a npt x ntrial Matrix{Int16} where
+                  sample round(pre * sampling_rate) + 1 is nearest the trigger,
+                  for wavemark channels the npt x nevent waveforms
+            offsets: ntrial + 1 Vector{UInt64}, the events of trial k are
+                     times[offsets[k]+1:offsets[k+1]]
+            times: event times relative to their trigger in seconds
+            markers: 4 x nevent Array{UInt8,2} of marker codes (marker kinds)
+"""
+function read_epochs(ifile::String, idx::Vector{<:Integer},
+    triggers::Vector{Float64}, pre::Real, post::Real)
+
+    if splitext(ifile)[2] != ".smr"
+        error("Input file is not an smr file")
+    end
+
+    channels = Vector{Cint}(idx)
+
+    ptr = ccall((:read_epochs, LIBSMR), Ptr{cSMREpochs},
+        (Cstring, Ptr{Cint}, Cint, Ptr{Float64}, UInt64, Float64, Float64),
+        ifile, channels, Cint(length(channels)), triggers,
+        UInt64(length(triggers)), Float64(pre), Float64(post))
+
+    if ptr == C_NULL
+        error("call to read_epochs failed")
+    end
+
+    ep = unsafe_load(ptr)
+    out = Vector{SMREpochChannel}(undef, ep.nchannel)
+
+    for k in 1:ep.nchannel
+        out[k] = SMREpochChannel(unsafe_load(ep.channels, k), ep.ntrial)
+    end
+
+    # the channels own their buffers now, only the containers are left
+    ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ep.channels)
+    ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ep.triggers)
+    ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+
+    return out
+end
+# ============================================================================ #
+mutable struct SMRChunks{T}
+    cursor::Ptr{cSMRCursor}
+    buffer::Vector{T}
+    nitem::Int
+    sampling_rate::Float64
+
+    function SMRChunks{T}(ptr::Ptr{cSMRCursor}) where T
+        c = unsafe_load(ptr)
+        self = new{T}(ptr, Vector{T}(undef, c.chunk), Int(c.length),
+            c.sampling_rate)
+        finalizer(close, self)
+        return self
+    end
+end
+
+function Base.close(itr::SMRChunks)
+    if itr.cursor != C_NULL
+        ccall((:close_channel_cursor, LIBSMR), Cvoid, (Ptr{cSMRCursor},),
+            itr.cursor)
+        itr.cursor = C_NULL
+    end
+    return nothing
+end
+
+Base.IteratorSize(::Type{<:SMRChunks}) = Base.HasLength()
+Base.length(itr::SMRChunks) = cld(itr.nitem, length(itr.buffer))
+Base.eltype(::Type{SMRChunks{T}}) where T =
+    SubArray{T,1,Vector{T},Tuple{UnitRange{Int}},true}
+
+function Base.iterate(itr::SMRChunks, started::Bool=false)
+    if itr.cursor == C_NULL
+        error("cursor is closed")
+    end
+
+    if !started
+        ccall((:rewind_channel_cursor, LIBSMR), Cvoid, (Ptr{cSMRCursor},),
+            itr.cursor)
+    end
+
+    n = ccall((:read_cursor_chunk, LIBSMR), Int64, (Ptr{cSMRCursor}, Ptr{Cvoid}),
+        itr.cursor, itr.buffer)
+
+    if n < 0
+        error("call to read_cursor_chunk failed")
+    end
+
+    return n > 0 ? (view(itr.buffer, 1:Int(n)), true) : nothing
+end
+# ============================================================================ #
+"""
+`itr = SMR.chunks(ifile::String, idx::Integer; chunk_size::Integer=1<<20)` *OR*\n
+`itr = SMR.chunks(ifile::String, label::String; chunk_size::Integer=1<<20)`
+Stream a continuous, realwave or event channel `chunk_size` items at a time,
+e.g. `for chunk in SMR.chunks(ifile, "Raw") ... end`, in constant memory.
+### Input:
+ * see `read_wavemark_channel`
+ * chunk_size - # of items per chunk (the last chunk may be shorter)
+
+### Output:
+* itr - an iterator over chunks, each a view of a single buffer that is reused
+        for every chunk (`copy` a chunk to keep it past the next iteration):\n
+            continuous channels: raw Int16 samples
+            realwave channels: Float32 samples
+            event channels: Float64 timestamps in seconds
+        the file stays open until `close(itr)` or garbage collection of `itr`,
+        `itr.sampling_rate` is the sampling rate of waveform channels
+"""
+function chunks(ifile::String, idx::Integer; chunk_size::Integer=1<<20)
+
+    if splitext(ifile)[2] != ".smr"
+        error("Input file is not an smr file")
+    end
+
+    ptr = ccall((:open_channel_cursor, LIBSMR), Ptr{cSMRCursor},
+        (Cstring, Cint, UInt64), ifile, Cint(idx), UInt64(chunk_size))
+
+    if ptr == C_NULL
+        error("call to open_channel_cursor failed")
+    end
+
+    kind = unsafe_load(ptr).kind
+
+    T = kind == 1 ? Int16 : kind == 9 ? Float32 : Float64
+
+    return SMRChunks{T}(ptr)
+end
+function chunks(ifile::String, label::String; kwargs...)
+    return chunks(ifile, get_channel_index(ifile, label); kwargs...)
+end
+# ============================================================================ #
+"""
+`rwav = read_realwave_channel(ifile::String, idx::Integer)` *OR*\n
+`rwav = read_realwave_channel(ifile::String, label::String)`
+### Input:
+ * see `read_wavemark_channel`
+
+### Output:
+* rwav - a SMRRealWaveChannel type with fields:\n
+            data: Nx1 Vector{Float32} of samples in physical units
+            sampling_rate: channel sampling rate in Hz
+"""
+function read_realwave_channel(ifile::String, idx::Integer)
+    @calllib(ifile, idx, "realwave", SMRRealWaveChannel)
+end
+function read_realwave_channel(ifile::String, label::String)
+    return read_realwave_channel(ifile, get_channel_index(ifile, label))
+end
+# ============================================================================ #
+"""
 `evt = read_event_channel(ifile::String, idx::Integer)` *OR*\n
 `evt = read_event_channel(ifile::String, label::String)`
 ### Input:
@@ -86,8 +379,28 @@ function read_event_channel(ifile::String, label::String)
 end
 # ============================================================================ #
 """
+`lvl = read_level_channel(ifile::String, idx::Integer)` *OR*\n
+`lvl = read_level_channel(ifile::String, label::String)`
+### Input:
+ * see `read_wavemark_channel`
+
+### Output:
+* lvl - a SMRLevelChannel type with fields:\n
+            start: Nx1 Vector{Float64} of interval start (rising edge) times
+            stop: Nx1 Vector{Float64} of interval end (falling edge) times
+            init_low: true if the channel level starts low
+"""
+function read_level_channel(ifile::String, idx::Integer)
+    @calllib(ifile, idx, "level", SMRLevelChannel)
+end
+function read_level_channel(ifile::String, label::String)
+    return read_level_channel(ifile, get_channel_index(ifile, label))
+end
+# ============================================================================ #
+"""
 `mrk = read_marker_channel(ifile::String, idx::Integer)` *OR*\n
-`mrk = read_marker_channel(ifile::String, label::String)`
+`mrk = read_marker_channel(ifile::String, label::String)` *OR*\n
+`mrk = read_marker_channel(ifile::String, idx::Integer, codes::AbstractVector{<:Integer})`
 ### Input:
  * see `read_wavemark_channel`
 
@@ -105,6 +418,355 @@ function read_marker_channel(ifile::String, label::String)
 end
 # ============================================================================ #
 """
+`rmrk = read_realmarker_channel(ifile::String, idx::Integer)` *OR*\n
+`rmrk = read_realmarker_channel(ifile::String, label::String)`
+### Input:
+ * see `read_wavemark_channel`
+
+### Output:
+* rmrk - a SMRRealMarkerChannel type with fields:\n
+            timestamps: Nx1 Vector{Float64} of marker timestamps in seconds
+            markers: 4xN Array{UInt8,2} of marker codes
+            data: MxN Array{Float32,2} of values attached to each marker
+"""
+function read_realmarker_channel(ifile::String, idx::Integer)
+    @calllib(ifile, idx, "realmarker", SMRRealMarkerChannel)
+end
+function read_realmarker_channel(ifile::String, label::String)
+    return read_realmarker_channel(ifile, get_channel_index(ifile, label))
+end
+# ============================================================================ #
+"""
+`h = SMRFile(ifile::String; index::Bool=false)`
+Open a handle to a .smr file whose headers and block tables are parsed once
+and reused by every `read_*_channel(h, idx)` / `read_channel(h, idx)` call,
+`index=true` loads (or creates) the `<ifile>.smridx` sidecar index.
+
+A handle must only be used by one task at a time, distinct handles (even of
+the same file) can be read from concurrently, see `read_channels`. The file is
+closed by `close(h)` or when `h` is garbage collected.
+"""
+mutable struct SMRFile
+    ptr::Ptr{Cvoid}
+    path::String
+
+    function SMRFile(ifile::String; index::Bool=false)
+        if splitext(ifile)[2] != ".smr"
+            error("Input file is not an smr file")
+        end
+
+        ptr = ccall((:open_smr_file, LIBSMR), Ptr{Cvoid}, (Cstring, Cint),
+            ifile, Cint(index ? 0x01 : 0x00))
+
+        if ptr == C_NULL
+            error("call to open_smr_file failed")
+        end
+
+        self = new(ptr, ifile)
+        finalizer(close, self)
+        return self
+    end
+end
+
+function Base.close(h::SMRFile)
+    if h.ptr != C_NULL
+        ccall((:close_smr_file, LIBSMR), Cvoid, (Ptr{Cvoid},), h.ptr)
+        h.ptr = C_NULL
+    end
+    return nothing
+end
+
+function handle_pointer(h::SMRFile)
+    if h.ptr == C_NULL
+        error("file " * h.path * " is closed")
+    end
+    return h.ptr
+end
+
+function get_channel_index(h::SMRFile, label::String)::Int64
+    return ccall((:channel_label_file_to_index, LIBSMR), Cint, (Ptr{Cvoid},
+        Cstring), handle_pointer(h), label)
+end
+
+function get_channel_type(h::SMRFile, idx::Integer)::Int64
+    return ccall((:get_channel_kind, LIBSMR), Cint, (Ptr{Cvoid}, Cint),
+        handle_pointer(h), Cint(idx))
+end
+
+# the handle based versions of the read_*_channel functions
+for (fname, chan_type, jtyp) in (
+        (:read_wavemark_channel, "wavemark", :SMRWMrkChannel),
+        (:read_continuous_channel, "continuous", :SMRContChannel),
+        (:read_realwave_channel, "realwave", :SMRRealWaveChannel),
+        (:read_event_channel, "event", :SMREventChannel),
+        (:read_level_channel, "level", :SMRLevelChannel),
+        (:read_marker_channel, "marker", :SMRMarkerChannel),
+        (:read_realmarker_channel, "realmarker", :SMRRealMarkerChannel))
+    @eval begin
+        function $fname(h::SMRFile, idx::Integer)
+            @calllib_file(h, idx, $chan_type, $jtyp)
+        end
+        function $fname(h::SMRFile, label::String)
+            return $fname(h, get_channel_index(h, label))
+        end
+    end
+end
+# ============================================================================ #
+# the unit code filtered versions of the wavemark / marker readers
+for (fname, fread, jtyp) in (
+        (:read_wavemark_channel, "read_wavemark_channel_codes_from_file", :SMRWMrkChannel),
+        (:read_marker_channel, "read_marker_channel_codes_from_file", :SMRMarkerChannel))
+    ctyp = Symbol("c", jtyp)
+    @eval begin
+        function $fname(h::SMRFile, idx::Integer, codes::AbstractVector{<:Integer})
+            c = Vector{UInt8}(codes)
+
+            ptr = ccall(($fread, LIBSMR), Ptr{$ctyp},
+                (Ptr{Cvoid}, Cint, Ptr{UInt8}, Cint), handle_pointer(h),
+                Cint(idx), c, Cint(length(c)))
+
+            if ptr == C_NULL
+                error("call to " * $fread * " failed")
+            end
+
+            out = $jtyp(unsafe_load(ptr))
+            ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+
+            return out
+        end
+        function $fname(h::SMRFile, label::String, codes::AbstractVector{<:Integer})
+            return $fname(h, get_channel_index(h, label), codes)
+        end
+        function $fname(ifile::String, idx::Union{Integer,String},
+            codes::AbstractVector{<:Integer})
+
+            h = SMRFile(ifile)
+            try
+                return $fname(h, idx, codes)
+            finally
+                close(h)
+            end
+        end
+    end
+end
+# ============================================================================ #
+"""
+`chan = read_channel(h::SMRFile, idx::Integer)` *OR*\n
+`chan = read_channel(h::SMRFile, label::String)`
+Read a channel of any kind through the `read_*_channel` function that
+`get_read_function` would choose for it.
+"""
+function read_channel(h::SMRFile, idx::Integer)
+    return kind_read_function(get_channel_type(h, idx), string(idx))(h, idx)
+end
+function read_channel(h::SMRFile, label::String)
+    return read_channel(h, get_channel_index(h, label))
+end
+# ============================================================================ #
+"""
+`out = read_channels(files::Vector{String}, channels::Vector; threads::Bool=true)`
+Read the same channels from many files, with `threads=true` the files are
+spread over `Threads.nthreads()` threads (start julia with e.g. `-t auto`), one
+task and `SMRFile` handle per file.
+### Input:
+ * files - paths to .smr files
+ * channels - integer channel indices and / or channel labels
+ * threads - false to read the files one after the other
+
+### Output:
+* out - a length(files) x length(channels) Matrix, out[k,j] is channel
+        channels[j] of files[k] as returned by `read_channel`
+"""
+function read_channels(files::Vector{String}, channels::Vector;
+    threads::Bool=true)
+
+    out = Matrix{Any}(undef, length(files), length(channels))
+
+    load = k -> begin
+        h = SMRFile(files[k])
+        try
+            for j in eachindex(channels)
+                out[k,j] = read_channel(h, channels[j])
+            end
+        finally
+            close(h)
+        end
+    end
+
+    if threads
+        @sync for k in eachindex(files)
+            Threads.@spawn load(k)
+        end
+    else
+        foreach(load, eachindex(files))
+    end
+
+    return out
+end
+# ============================================================================ #
+"""
+`chan = lazy_channel(ifile::String, idx::Integer; index::Bool=false)` *OR*\n
+`chan = lazy_channel(h::SMRFile, idx::Integer)` (or a label in place of `idx`)
+A marker kind channel (marker, wavemark, realmarker or text marker) whose
+fields are decoded one at a time on first access, e.g. `chan.timestamps` of a
+wavemark channel neither decodes nor allocates its waveforms. The block index
+of the channel is held by the underlying handle, so later fields don't have to
+walk the file again.
+### Input:
+ * see `read_wavemark_channel` / `SMRFile`
+
+### Output:
+* chan - a SMRLazyChannel with fields `length` (# of records), `kind` and the
+         fields of the matching SMR*Channel type:\n
+            wavemark: timestamps, markers, wavemarks
+            marker / text marker: timestamps, markers, text
+            realmarker: timestamps, markers, data
+         given a path the channel keeps its own handle open until `close(chan)`
+         or garbage collection
+"""
+mutable struct SMRLazyChannel
+    file::SMRFile
+    index::Int
+    kind::Int
+    length::Int
+    nextra::Int
+    fields::Dict{Symbol,Any}
+end
+
+function lazy_channel(h::SMRFile, idx::Integer)
+    nextra = ccall((:channel_extra_size, LIBSMR), Int64, (Ptr{Cvoid}, Cint),
+        handle_pointer(h), Cint(idx))
+
+    if nextra < 0
+        error("call to channel_extra_size failed")
+    end
+
+    nitem = ccall((:channel_item_count, LIBSMR), UInt64, (Ptr{Cvoid}, Cint),
+        handle_pointer(h), Cint(idx))
+
+    return SMRLazyChannel(h, idx, get_channel_type(h, idx), nitem, nextra,
+        Dict{Symbol,Any}())
+end
+function lazy_channel(h::SMRFile, label::String)
+    return lazy_channel(h, get_channel_index(h, label))
+end
+function lazy_channel(ifile::String, idx::Union{Integer,String}; index::Bool=false)
+    return lazy_channel(SMRFile(ifile, index=index), idx)
+end
+
+Base.close(chan::SMRLazyChannel) = close(getfield(chan, :file))
+
+# the decoded fields of each marker kind, the last one being the extra data
+function lazy_fields(kind::Integer)
+    if kind == 6
+        return (:timestamps, :markers, :wavemarks)
+    elseif kind == 7
+        return (:timestamps, :markers, :data)
+    else
+        return (:timestamps, :markers, :text)
+    end
+end
+
+function Base.propertynames(chan::SMRLazyChannel, private::Bool=false)
+    return (:index, :kind, :length, lazy_fields(getfield(chan, :kind))...)
+end
+
+function Base.getproperty(chan::SMRLazyChannel, name::Symbol)
+    if name in (:file, :index, :kind, :length, :nextra, :fields)
+        return getfield(chan, name)
+    end
+
+    return get!(() -> decode_field(chan, name), getfield(chan, :fields), name)
+end
+
+function decode_field(chan::SMRLazyChannel, name::Symbol)
+    n = getfield(chan, :length)
+    nextra = getfield(chan, :nextra)
+    kind = getfield(chan, :kind)
+
+    mrk = Ptr{UInt8}(C_NULL)
+    ext = Ptr{UInt8}(C_NULL)
+
+    if name == :timestamps
+        # only the ticks of each record are touched
+        return read_marker_timestamps(getfield(chan, :file), getfield(chan, :index))
+    elseif name == :markers
+        out = Matrix{UInt8}(undef, SMRTypes.MARKER_SIZE, n)
+        mrk = pointer(out)
+    elseif name == lazy_fields(kind)[end]
+        if name == :text && nextra == 0
+            # plain markers have no text
+            return fill("", n)
+        end
+
+        T = kind == 6 ? Int16 : kind == 7 ? Float32 : UInt8
+        out = Matrix{T}(undef, div(nextra, sizeof(T)), n)
+        ext = Ptr{UInt8}(pointer(out))
+    else
+        error("type SMRLazyChannel has no field " * string(name))
+    end
+
+    status = GC.@preserve out ccall((:read_marker_records_into, LIBSMR), Cint,
+        (Ptr{Cvoid}, Cint, Ptr{Float64}, Ptr{UInt8}, Ptr{UInt8}),
+        handle_pointer(getfield(chan, :file)), Cint(getfield(chan, :index)),
+        Ptr{Float64}(C_NULL), mrk, ext)
+
+    if status != 0
+        error("call to read_marker_records_into failed")
+    end
+
+    return name == :text ? SMRTypes.decode_marker_text(vec(out), n, nextra) : out
+end
+# ============================================================================ #
+"""
+`ts = read_marker_timestamps(ifile::String, idx::Integer; ticks::Bool=false)` *OR*\n
+`ts = read_marker_timestamps(h::SMRFile, idx::Integer; ticks::Bool=false)` (or a label in place of `idx`)
+Just the timestamps of a marker kind channel (marker, wavemark, realmarker or
+text marker), e.g. spike times for rate computations. Only the time of each
+record is read out of the file, the markers / waveforms next to it are
+skipped.
+### Input:
+ * see `read_wavemark_channel` / `SMRFile`
+ * ticks - true to return the raw Int32 clock ticks rather than seconds
+
+### Output:
+* ts - a Vector{Float64} of times in seconds (or a Vector{Int32} of ticks)
+"""
+function read_marker_timestamps(h::SMRFile, idx::Integer; ticks::Bool=false)
+    n = ccall((:channel_item_count, LIBSMR), UInt64, (Ptr{Cvoid}, Cint),
+        handle_pointer(h), Cint(idx))
+
+    if ticks
+        out = Vector{Int32}(undef, n)
+        status = ccall((:read_marker_ticks_into, LIBSMR), Cint,
+            (Ptr{Cvoid}, Cint, Ptr{Int32}), handle_pointer(h), Cint(idx), out)
+    else
+        out = Vector{Float64}(undef, n)
+        status = ccall((:read_marker_timestamps_into, LIBSMR), Cint,
+            (Ptr{Cvoid}, Cint, Ptr{Float64}), handle_pointer(h), Cint(idx), out)
+    end
+
+    if status != 0
+        error("failed to read the timestamps of channel " * string(idx))
+    end
+
+    return out
+end
+function read_marker_timestamps(h::SMRFile, label::String; kwargs...)
+    return read_marker_timestamps(h, get_channel_index(h, label); kwargs...)
+end
+function read_marker_timestamps(ifile::String, idx::Union{Integer,String};
+    kwargs...)
+
+    h = SMRFile(ifile)
+    try
+        return read_marker_timestamps(h, idx; kwargs...)
+    finally
+        close(h)
+    end
+end
+# ============================================================================ #
+"""
 `ifo = read_channel_info(ifile)`
 ### Input:
 * ifile - the path to a .smr file
@@ -146,6 +808,50 @@ function read_channel_info(ifile::String)
     return ifo
 end
 # ============================================================================ #
+"""
+`set_cache_size(nbyte::Integer)`
+Enable caching of decoded channels across `read_*_channel` calls within this
+process using at most `nbyte` bytes (least recently used channels are evicted
+first), 0 disables the cache. Without a call to `set_cache_size` the budget is
+taken from the environment variable `SMR_CACHE_MB`.
+
+**NOTE** while the cache is enabled `read_*_channel(ifile, ...)` returns a
+copy of the cached arrays, so the result can be modified in place as usual.
+"""
+function set_cache_size(nbyte::Integer)
+    ccall((:set_channel_cache_size, LIBSMR), Cvoid, (UInt64,), UInt64(nbyte))
+end
+# ============================================================================ #
+"""
+`set_open_flags(flags::Integer)`
+Set the `open_smr_file` flags (e.g. `0x08` to fetch blocks through io_uring on
+Linux) used by the path based readers (`read_*_channel(ifile, ...)`), 0 by
+default. Without a call to `set_open_flags` they are taken from the
+environment variable `SMR_OPEN_FLAGS`. Handles opened with `SMRFile` take their
+own flags.
+"""
+function set_open_flags(flags::Integer)
+    ccall((:set_default_open_flags, LIBSMR), Cvoid, (Cint,), Cint(flags))
+end
+# ============================================================================ #
+"""
+`clear_cache()`
+Drop all cached channels, the budget is left as is.
+"""
+function clear_cache()
+    ccall((:clear_channel_cache, LIBSMR), Cvoid, ())
+end
+# ============================================================================ #
+"""
+`ifo = cache_info()`
+### Output:
+* ifo - a cSMRCacheInfo with fields budget, nbyte (bytes in use), nentry, nhit,
+        nmiss and nevict
+"""
+function cache_info()
+    return ccall((:get_channel_cache_info, LIBSMR), cSMRCacheInfo, ())
+end
+# ============================================================================ #
 function get_channel_type(ifile::String, label::String)
     return get_channel_type(read_channel_info(ifile), label)
 end
@@ -164,7 +870,10 @@ function get_channel_type(ifo::Array{T}, label::String) where T<:SMRChannelInfo
 end
 # ============================================================================ #
 function get_read_function(ifile::String, label::String)
-    typ = get_channel_type(ifile, label)
+    return kind_read_function(get_channel_type(ifile, label), label)
+end
+# ============================================================================ #
+function kind_read_function(typ::Integer, label::String)
     if typ == 1
         f = read_continuous_channel
     elseif typ == 2
@@ -178,11 +887,11 @@ function get_read_function(ifile::String, label::String)
     elseif typ == 6
         f = read_wavemark_channel
     elseif typ == 7
-        f = read_marker_channel
+        f = read_realmarker_channel
     elseif typ == 8
         f = read_marker_channel
     elseif typ == 9
-        error("real wave channels are not yet supported!")
+        f = read_realwave_channel
     else
         error("Channel $(label) cannot be located")
     end
@@ -1,9 +1,13 @@
 module SMRTypes
 
 import Base: show
+import ..LIBSMR
 
 export cSMRWMrkChannel, SMRWMrkChannel, cSMRContChannel, SMRContChannel,
-       cSMREventChannel, SMREventChannel, cSMRMarkerChannel, SMRMarkerChannel,
+       cSMRRealWaveChannel, SMRRealWaveChannel, cSMREventChannel, SMREventChannel, cSMRMarkerChannel, SMRMarkerChannel,
+       cSMRLevelChannel, SMRLevelChannel, cSMRRealMarkerChannel, SMRRealMarkerChannel,
+       cSMRFilterConfig, cSMRFilteredChannel, SMRFilteredChannel, cSMREpochChannel,
+       cSMREpochs, SMREpochChannel, cSMRCacheInfo, cSMRCursor,
        cSMRChannelInfo, cSMRChannelInfoArray, SMRChannelInfo, show,
        channel_string
 
@@ -12,6 +16,52 @@ const MARKER_SIZE = UInt8(4)
 abstract type SMRCType end
 abstract type SMRType end
 
+# =========================================================================== #
+# the SMRType constructors take ownership of the buffers of the C struct they
+# are given (so the caller frees only the struct itself with free_buffer), the
+# buffers are wrapped without a copy and released through libsmr once the
+# wrapping array is garbage collected
+free_buffer(ptr::Ptr) = ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+
+function take_buffer(::Type{T}, ptr::Ptr, dims::Integer...) where T
+    d = map(Int, dims)
+
+    if ptr == C_NULL || prod(d) == 0
+        free_buffer(ptr)
+        return Array{T}(undef, d)
+    end
+
+    @static if VERSION >= v"1.11"
+        # arrays share their Memory (e.g. through reshape), so the Memory is
+        # what must outlive every view of the buffer
+        mem = unsafe_wrap(Memory{T}, Ptr{T}(ptr), (prod(d),), own=false)
+        finalizer(m -> free_buffer(pointer(m)), mem)
+        return Base.wrap(Array, mem, d)
+    else
+        ary = unsafe_wrap(Array, Ptr{T}(ptr), d, own=false)
+        finalizer(a -> free_buffer(pointer(a)), ary)
+        return ary
+    end
+end
+
+# =========================================================================== #
+# the text of marker channels is <npt> NUL padded bytes per marker
+function decode_marker_text(ary::AbstractVector{UInt8}, n::Integer, npt::Integer)
+    text = Vector{String}(undef, n)
+
+    for k = 1:n
+        isrt = ((k-1)*npt)+1
+        iend = k*npt
+        if all(x->x=='\0', ary[isrt:iend])
+            text[k] = ""
+        else
+            text[k] = strip(join(map(Char, ary[isrt:iend])), '\0')
+        end
+    end
+
+    return text
+end
+
 # =========================================================================== #
 struct cSMRWMrkChannel <: SMRCType
     length::UInt64
@@ -29,14 +79,11 @@ mutable struct SMRWMrkChannel <: SMRType
     function SMRWMrkChannel(x::cSMRWMrkChannel)
         self = new()
 
-        self.timestamps = Vector{Float64}(undef, x.length)
-        copyto!(self.timestamps, unsafe_wrap(Vector{Float64}, x.timestamps, x.length, own=false))
+        self.timestamps = take_buffer(Float64, x.timestamps, x.length)
 
-        self.markers = Matrix{UInt8}(undef, MARKER_SIZE, x.length)
-        copyto!(self.markers, unsafe_wrap(Vector{UInt8}, x.markers, x.length * MARKER_SIZE, own=false))
+        self.markers = take_buffer(UInt8, x.markers, MARKER_SIZE, x.length)
 
-        self.wavemarks = Matrix{Int16}(undef, x.npt, x.length)
-        copyto!(self.wavemarks, unsafe_wrap(Vector{Int16}, x.wavemarks, x.length * x.npt, own=false))
+        self.wavemarks = take_buffer(Int16, x.wavemarks, x.npt, x.length)
 
         return self
     end
@@ -55,11 +102,118 @@ mutable struct SMRContChannel <: SMRType
     function SMRContChannel(x::cSMRContChannel)
         self = new()
 
-        self.data = Vector{Int16}(undef, x.length)
-        copyto!(self.data, unsafe_wrap(Vector{Int16}, x.data, x.length, own=false))
+        self.data = take_buffer(Int16, x.data, x.length)
+
+        self.sampling_rate = x.sampling_rate
+
+        return self
+    end
+end
+# =========================================================================== #
+struct cSMRRealWaveChannel <: SMRCType
+    length::UInt64
+    sampling_rate::Float64
+    data::Ptr{Float32}
+end
+
+mutable struct SMRRealWaveChannel <: SMRType
+    data::Vector{Float32}
+    sampling_rate::Float64
+
+    function SMRRealWaveChannel(x::cSMRRealWaveChannel)
+        self = new()
+
+        self.data = take_buffer(Float32, x.data, x.length)
+
+        self.sampling_rate = x.sampling_rate
+
+        return self
+    end
+end
+# =========================================================================== #
+struct cSMRFilterConfig
+    low::Float64
+    high::Float64
+    order::Cint
+    threshold::Float64
+    dead_time::Float64
+    emit::Cint
+end
+
+struct cSMRFilteredChannel <: SMRCType
+    length::UInt64
+    sampling_rate::Float64
+    data::Ptr{Float32}
+    ncrossing::UInt64
+    crossings::Ptr{Float64}
+end
+
+mutable struct SMRFilteredChannel <: SMRType
+    data::Vector{Float32}
+    sampling_rate::Float64
+    crossings::Vector{Float64}
+
+    function SMRFilteredChannel(x::cSMRFilteredChannel)
+        self = new()
+
+        self.data = take_buffer(Float32, x.data, x.length)
+
+        self.sampling_rate = x.sampling_rate
+
+        self.crossings = take_buffer(Float64, x.crossings, x.ncrossing)
+
+        return self
+    end
+end
+# =========================================================================== #
+struct cSMREpochChannel <: SMRCType
+    index::Cint
+    kind::UInt8
+    sampling_rate::Float64
+    npt::UInt64
+    data::Ptr{Int16}
+    nevent::UInt64
+    offsets::Ptr{UInt64}
+    times::Ptr{Float64}
+    markers::Ptr{UInt8}
+end
+
+struct cSMREpochs <: SMRCType
+    ntrial::UInt64
+    pre::Float64
+    post::Float64
+    triggers::Ptr{Float64}
+    nchannel::Cint
+    channels::Ptr{cSMREpochChannel}
+end
 
+mutable struct SMREpochChannel <: SMRType
+    index::Int
+    kind::UInt8
+    sampling_rate::Float64
+    data::Matrix{Int16}
+    offsets::Vector{UInt64}
+    times::Vector{Float64}
+    markers::Matrix{UInt8}
+
+    function SMREpochChannel(x::cSMREpochChannel, ntrial::Integer)
+        self = new()
+
+        self.index = x.index
+        self.kind = x.kind
         self.sampling_rate = x.sampling_rate
 
+        # continuous channels have one column per trial, wavemarks one per event
+        ncol = x.kind == 1 ? ntrial : x.nevent
+        self.data = take_buffer(Int16, x.data, x.npt, ncol)
+
+        self.offsets = take_buffer(UInt64, x.offsets, x.offsets != C_NULL ? ntrial + 1 : 0)
+
+        self.times = take_buffer(Float64, x.times, x.nevent)
+
+        nmrk = x.markers != C_NULL ? x.nevent : 0
+        self.markers = take_buffer(UInt8, x.markers, MARKER_SIZE, nmrk)
+
         return self
     end
 end
@@ -75,8 +229,32 @@ mutable struct SMREventChannel <: SMRType
     function SMREventChannel(x::cSMREventChannel)
         self = new()
 
-        self.data = Vector{Float64}(undef, x.length)
-        copyto!(self.data, unsafe_wrap(Vector{Float64}, x.data, x.length, own=false))
+        self.data = take_buffer(Float64, x.data, x.length)
+
+        return self
+    end
+end
+# =========================================================================== #
+struct cSMRLevelChannel <: SMRCType
+    length::UInt64
+    init_low::UInt8
+    start::Ptr{Float64}
+    stop::Ptr{Float64}
+end
+
+mutable struct SMRLevelChannel <: SMRType
+    start::Vector{Float64}
+    stop::Vector{Float64}
+    init_low::Bool
+
+    function SMRLevelChannel(x::cSMRLevelChannel)
+        self = new()
+
+        self.start = take_buffer(Float64, x.start, x.length)
+
+        self.stop = take_buffer(Float64, x.stop, x.length)
+
+        self.init_low = x.init_low != 0
 
         return self
     end
@@ -98,24 +276,41 @@ mutable struct SMRMarkerChannel <: SMRType
     function SMRMarkerChannel(mrk::cSMRMarkerChannel)
         self = new()
 
-        self.timestamps = Vector{Float64}(undef, mrk.length)
-        copyto!(self.timestamps, unsafe_wrap(Vector{Float64}, mrk.timestamps, mrk.length, own=false))
-
-        self.markers = Matrix{UInt8}(undef, MARKER_SIZE, mrk.length)
-        copyto!(self.markers, unsafe_wrap(Vector{UInt8}, mrk.markers, mrk.length * MARKER_SIZE, own=false))
+        self.timestamps = take_buffer(Float64, mrk.timestamps, mrk.length)
 
-        self.text = Vector{String}(undef, mrk.length)
+        self.markers = take_buffer(UInt8, mrk.markers, MARKER_SIZE, mrk.length)
 
         ary = unsafe_wrap(Vector{UInt8}, mrk.text, mrk.length * mrk.npt, own=false)
-        for k = 1:mrk.length
-            isrt = ((k-1)*mrk.npt)+1
-            iend = k*mrk.npt
-            if all(x->x=='\0', ary[isrt:iend])
-                self.text[k] = ""
-            else
-                self.text[k] = strip(join(map(Char, ary[isrt:iend])), '\0')
-            end
-        end
+        self.text = decode_marker_text(ary, mrk.length, mrk.npt)
+
+        # the text is decoded into Strings so its buffer is not kept
+        free_buffer(mrk.text)
+
+        return self
+    end
+end
+# =========================================================================== #
+struct cSMRRealMarkerChannel <: SMRCType
+    length::UInt64
+    npt::UInt64
+    timestamps::Ptr{Float64}
+    markers::Ptr{UInt8}
+    data::Ptr{Float32}
+end
+
+mutable struct SMRRealMarkerChannel <: SMRType
+    timestamps::Vector{Float64}
+    markers::Matrix{UInt8}
+    data::Matrix{Float32}
+
+    function SMRRealMarkerChannel(x::cSMRRealMarkerChannel)
+        self = new()
+
+        self.timestamps = take_buffer(Float64, x.timestamps, x.length)
+
+        self.markers = take_buffer(UInt8, x.markers, MARKER_SIZE, x.length)
+
+        self.data = take_buffer(Float32, x.data, x.npt, x.length)
 
         return self
     end
@@ -133,6 +328,25 @@ struct cSMRChannelInfoArray <: SMRCType
     ifo::Ptr{Ptr{cSMRChannelInfo}}
 end
 
+struct cSMRCacheInfo <: SMRCType
+    budget::UInt64
+    nbyte::UInt64
+    nentry::UInt64
+    nhit::UInt64
+    nmiss::UInt64
+    nevict::UInt64
+end
+
+# the public leading fields of struct SMRCursor, the rest is private to libsmr
+struct cSMRCursor <: SMRCType
+    index::Cint
+    kind::UInt8
+    chunk::UInt64
+    length::UInt64
+    position::UInt64
+    sampling_rate::Float64
+end
+
 mutable struct SMRChannelInfo <: SMRType
     title::String
     index::Int
@@ -24,19 +24,45 @@ macro calllib(ifile, idx, chan_type, jtyp)#ctyp, jtyp)
     # jtyp = Symbol("SMR" * type_name * "Channel")
 
     fread = "read_" * chan_type * "_channel"
-    ffree = "free_" * chan_type * "_channel"
 
     return quote
         if splitext($(esc(ifile)))[2] != ".smr"
             error("Input file is not an smr file")
         end
 
+        # with the cache on the channel buffers are shared with the cache
+        # entry (and every other read of the channel), so the caller gets a
+        # private copy it is free to modify
+        cached = ccall((:get_channel_cache_info, LIBSMR), cSMRCacheInfo, ()).budget > 0
+
         ptr = ccall(($fread, LIBSMR), Ptr{$ctyp}, (Cstring, Cint),
             $(esc(ifile)), Cint($(esc(idx))))
 
+        if ptr != C_NULL
+            # the constructor takes ownership of the channel buffers,
+            # leaving just the struct to free
+            out = $jtyp(unsafe_load(ptr))
+            ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
+        else
+            error("call to " * string($fread) * " failed")
+        end
+        cached ? deepcopy(out) : out
+    end
+end
+# ============================================================================ #
+macro calllib_file(h, idx, chan_type, jtyp)
+
+    ctyp = Symbol("c", jtyp)
+
+    fread = "read_" * chan_type * "_channel_from_file"
+
+    return quote
+        ptr = ccall(($fread, LIBSMR), Ptr{$ctyp}, (Ptr{Cvoid}, Cint),
+            handle_pointer($(esc(h))), Cint($(esc(idx))))
+
         if ptr != C_NULL
             out = $jtyp(unsafe_load(ptr))
-            ccall(($ffree, LIBSMR), Cvoid, (Ptr{$ctyp},), ptr)
+            ccall((:free_buffer, LIBSMR), Cvoid, (Ptr{Cvoid},), ptr)
         else
             error("call to " * string($fread) * " failed")
         end
@@ -18,7 +18,8 @@ function build(varargin)
 mdir = fileparts(mfilename('fullpath'));
 idir = fileparts(mdir);
 
-files = {'smr_read_channel', 'smr_channel_info', 'smr_channel_fs'};
+files = {'smr_read_channel', 'smr_channel_info', 'smr_channel_fs', ...
+    'smr_read_epochs'};
 
 lib_file = fullfile(idir, 'smr.c');
 
@@ -4,7 +4,18 @@
 #include "smr.h"
 
 /* ========================================================================= */
-mxArray *get_continuous_channel(const char *ifile, int idx)\
+/* the class of continuous channel outputs of the SMR_FILL_* <type> */
+mxClassID fill_class(int type)
+{
+    switch (type)
+    {
+        case SMR_FILL_INT16:  return mxINT16_CLASS;
+        case SMR_FILL_SINGLE: return mxSINGLE_CLASS;
+        default:              return mxDOUBLE_CLASS;
+    }
+}
+/* ========================================================================= */
+mxArray *get_continuous_channel(const char *ifile, int idx, int type)\
 {
     mxArray *out;
 
@@ -13,6 +24,7 @@ mxArray *get_continuous_channel(const char *ifile, int idx)\
     struct SMRContChannel *chan = NULL;
 
     double *data_ptr, *fs_ptr;
+    float *single_ptr;
     double scale, offset;
     int fail = 1;
     long unsigned int k;
@@ -35,16 +47,33 @@ mxArray *get_continuous_channel(const char *ifile, int idx)\
 
     if ((chan = read_continuous_channel_from_header(fhdr, chdr)) != NULL)
     {
-        mxArray *data = mxCreateNumericMatrix(chan->length, 1, mxDOUBLE_CLASS, mxREAL);
+        mxArray *data = mxCreateNumericMatrix(chan->length, 1,
+            fill_class(type), mxREAL);
         mxArray *fs = mxCreateNumericMatrix(1, 1, mxDOUBLE_CLASS, mxREAL);
 
-        data_ptr = mxGetData(data);
-
         /* convert continuous data saved as int16 to voltage as
            volts = (data * (scale / 6553.6)) + offset */
-        for (k = 0; k < chan->length; ++k)
+        if (type == SMR_FILL_INT16)
         {
-            *(data_ptr++) = (chan->data[k] * scale) + offset;
+            memcpy(mxGetData(data), chan->data, (size_t) chan->length * sizeof (int16_t));
+        }
+        else if (type == SMR_FILL_SINGLE)
+        {
+            single_ptr = mxGetData(data);
+
+            for (k = 0; k < chan->length; ++k)
+            {
+                *(single_ptr++) = (float) ((chan->data[k] * scale) + offset);
+            }
+        }
+        else
+        {
+            data_ptr = mxGetData(data);
+
+            for (k = 0; k < chan->length; ++k)
+            {
+                *(data_ptr++) = (chan->data[k] * scale) + offset;
+            }
         }
 
         fs_ptr = mxGetPr(fs);
@@ -70,6 +99,37 @@ cleanup:
     return out;
 }
 /* ========================================================================= */
+mxArray *get_realwave_channel(const char *ifile, int idx)
+{
+    struct SMRRealWaveChannel *chan = NULL;
+    mxArray *out;
+
+    const char *fields[] = {"data", "sampling_rate"};
+    out = mxCreateStructMatrix(1, 1, 2, fields);
+
+    if ((chan = read_realwave_channel(ifile, idx)) != NULL)
+    {
+        /* real wave data is already in physical units, so no scaling is
+           applied and the samples are returned as single */
+        mxArray *data = mxCreateNumericMatrix(chan->length, 1, mxSINGLE_CLASS, mxREAL);
+        mxArray *fs = mxCreateNumericMatrix(1, 1, mxDOUBLE_CLASS, mxREAL);
+
+        memcpy(mxGetData(data), chan->data, (size_t) chan->length * sizeof (float));
+        *mxGetPr(fs) = chan->sampling_rate;
+
+        mxSetField(out, 0, "data", data);
+        mxSetField(out, 0, "sampling_rate", fs);
+
+        free_realwave_channel(chan);
+    }
+    else
+    {
+        mexPrintf("WARNING: failed to read channel [%d] from file %s\n", idx, ifile);
+    }
+
+    return out;
+}
+/* ========================================================================= */
 mxArray *get_wavemark_channel(const char *ifile, int idx)
 {
 
@@ -159,13 +219,209 @@ mxArray *get_marker_channel(const char *ifile, int idx)
     return out;
 }
 /* ========================================================================= */
+mxArray *get_realmarker_channel(const char *ifile, int idx)
+{
+    struct SMRRealMarkerChannel *chan = NULL;
+    mxArray *out, *ts, *mrk, *data;
+
+    const char *fields[] = {"timestamps", "markers", "data"};
+    out = mxCreateStructMatrix(1, 1, 3, fields);
+
+    if ((chan = read_realmarker_channel(ifile, idx)) != NULL)
+    {
+        ts = mxCreateNumericMatrix(chan->length, 1, mxDOUBLE_CLASS, mxREAL);
+        mrk = mxCreateNumericMatrix(MARKER_SIZE, chan->length, mxUINT8_CLASS, mxREAL);
+        data = mxCreateNumericMatrix(chan->npt, chan->length, mxSINGLE_CLASS, mxREAL);
+
+        memcpy(mxGetPr(ts), chan->timestamps, (size_t) chan->length * sizeof (double));
+        memcpy(mxGetData(mrk), chan->markers, (size_t) chan->length * MARKER_SIZE * sizeof (uint8_t));
+        memcpy(mxGetData(data), chan->data, (size_t) chan->length * chan->npt * sizeof (float));
+
+        mxSetField(out, 0, "timestamps", ts);
+        mxSetField(out, 0, "markers", mrk);
+        mxSetField(out, 0, "data", data);
+
+        free_realmarker_channel(chan);
+
+    }
+    else
+    {
+        mexPrintf("WARNING: failed to read channel [%d] from file %s\n", idx, ifile);
+    }
+
+    return out;
+}
+/* ========================================================================= */
+/* the fill_* functions below size their outputs from the block headers and
+   have libsmr decode straight into the mxArray storage, so no channel ever
+   exists twice in memory. the get_* functions above read through the channel
+   cache and are used instead when it is enabled (SMR_CACHE_MB) */
+void fill_failed(mxArray *ary, struct SMRFile *f, int idx)
+{
+    mxDestroyArray(ary);
+    mexPrintf("WARNING: failed to read channel [%d] from file %s\n", idx,
+        f->fhdr->filepath);
+}
+/* ========================================================================= */
+mxArray *fill_continuous_channel(struct SMRFile *f, int idx, int type)
+{
+    mxArray *out, *data;
+    uint64_t n = channel_item_count(f, idx);
+
+    const char *fields[] = {"data", "sampling_rate"};
+    out = mxCreateStructMatrix(1, 1, 2, fields);
+
+    data = mxCreateNumericMatrix(n, 1, fill_class(type), mxREAL);
+
+    if (read_continuous_matrix(f, &idx, 1, mxGetData(data), n, type) == 0)
+    {
+        mxSetField(out, 0, "data", data);
+        mxSetField(out, 0, "sampling_rate",
+            mxCreateDoubleScalar(MICROSECONDS / get_sample_interval(f->fhdr, idx)));
+    }
+    else
+    {
+        fill_failed(data, f, idx);
+    }
+
+    return out;
+}
+/* ========================================================================= */
+mxArray *fill_event_channel(struct SMRFile *f, int idx)
+{
+    mxArray *out;
+    uint64_t n = channel_item_count(f, idx);
+
+    out = mxCreateNumericMatrix(n, 1, mxDOUBLE_CLASS, mxREAL);
+
+    if (read_event_channel_into(f, idx, mxGetPr(out)) != 0)
+    {
+        fill_failed(out, f, idx);
+        out = mxCreateNumericMatrix(1, 1, mxDOUBLE_CLASS, mxREAL);
+    }
+
+    return out;
+}
+/* ========================================================================= */
+/* marker kind channels share one record layout, <extra> is the name and
+   <npt> x <cls> the shape of the per record payload (NULL for none) */
+mxArray *fill_marker_records(struct SMRFile *f, int idx, const char *extra,
+    uint64_t npt, mxClassID cls)
+{
+    mxArray *out, *ts, *mrk, *dat;
+    uint64_t n = channel_item_count(f, idx);
+
+    const char *fields[] = {"timestamps", "markers", extra};
+    out = mxCreateStructMatrix(1, 1, 3, fields);
+
+    ts = mxCreateNumericMatrix(n, 1, mxDOUBLE_CLASS, mxREAL);
+    mrk = mxCreateNumericMatrix(MARKER_SIZE, n, mxUINT8_CLASS, mxREAL);
+    dat = mxCreateNumericMatrix(npt, n, cls, mxREAL);
+
+    /* plain marker channels carry no payload, so their 1 x n text is left
+       zeroed */
+    if (read_marker_records_into(f, idx, mxGetPr(ts), mxGetData(mrk),
+        mxGetData(dat)) == 0)
+    {
+        mxSetField(out, 0, "timestamps", ts);
+        mxSetField(out, 0, "markers", mrk);
+        mxSetField(out, 0, extra, dat);
+    }
+    else
+    {
+        mxDestroyArray(ts);
+        mxDestroyArray(mrk);
+        fill_failed(dat, f, idx);
+    }
+
+    return out;
+}
+/* ========================================================================= */
+/* the continuous channels <chans> (a vector of indices or a cell of labels) as
+   the columns of one nsample x nchan matrix, read in a single pass over the
+   file. shorter channels are zero padded. returns NULL on failure */
+mxArray *fill_continuous_matrix(struct SMRFile *f, const mxArray *chans,
+    int type)
+{
+    mxArray *out, *data, *fs;
+    char *label;
+    int *idx;
+    int nchan = (int) mxGetNumberOfElements(chans);
+    int k;
+    uint64_t nrow = 0;
+    int fail = 0;
+
+    const char *fields[] = {"data", "sampling_rate"};
+
+    idx = mxMalloc(sizeof (int) * (nchan > 0 ? nchan : 1));
+    fs = mxCreateNumericMatrix(1, nchan, mxDOUBLE_CLASS, mxREAL);
+
+    for (k = 0; k < nchan; ++k)
+    {
+        if (mxIsCell(chans))
+        {
+            label = mxIsChar(mxGetCell(chans, k)) ?
+                mxArrayToString(mxGetCell(chans, k)) : NULL;
+            idx[k] = label ? channel_label_to_index(f->fhdr, label) : -1;
+            mxFree(label);
+        }
+        else
+        {
+            idx[k] = mxIsDouble(chans) ? (int) mxGetPr(chans)[k] : -1;
+        }
+
+        if (idx[k] < 0 || get_block_header_array(f, idx[k]) == NULL)
+        {
+            fail = 1;
+            break;
+        }
+
+        if (channel_item_count(f, idx[k]) > nrow)
+        {
+            nrow = channel_item_count(f, idx[k]);
+        }
+    }
+
+    data = mxCreateNumericMatrix(fail ? 0 : nrow, nchan, fill_class(type), mxREAL);
+
+    if (fail || read_continuous_matrix(f, idx, nchan, mxGetData(data), nrow, type) != 0)
+    {
+        mxDestroyArray(data);
+        mxDestroyArray(fs);
+        mxFree(idx);
+
+        return NULL;
+    }
+
+    for (k = 0; k < nchan; ++k)
+    {
+        mxGetPr(fs)[k] = MICROSECONDS / get_sample_interval(f->fhdr, idx[k]);
+    }
+
+    mxFree(idx);
+
+    out = mxCreateStructMatrix(1, 1, 2, fields);
+
+    mxSetField(out, 0, "data", data);
+    mxSetField(out, 0, "sampling_rate", fs);
+
+    return out;
+}
+/* ========================================================================= */
 void mexFunction(int nout, mxArray *pout[], int nin, const mxArray *pin[])
 {
-    char *ifile, *label;
+    char *ifile, *label, *opt;
     struct SMRFileHeader *fhdr = NULL;
     struct SMRChannelHeader *chdr = NULL;
+    struct SMRFile *f = NULL;
 
     int idx;
+    int type = SMR_FILL_DOUBLE;
+    int16_t nextra;
+
+    /*cached channels are owned by this module's copy of libsmr, drop them
+      before matlab unloads it*/
+    mexAtExit(clear_channel_cache);
 
     if (nin < 2)
     {
@@ -179,6 +435,44 @@ void mexFunction(int nout, mxArray *pout[], int nin, const mxArray *pin[])
 
     ifile = mxArrayToString(pin[0]);
 
+    if (nin > 2 && mxIsChar(pin[2]))
+    {
+        opt = mxArrayToString(pin[2]);
+
+        if (strcmp(opt, "single") == 0)
+        {
+            type = SMR_FILL_SINGLE;
+        }
+        else if (strcmp(opt, "int16") == 0)
+        {
+            type = SMR_FILL_INT16;
+        }
+
+        mxFree(opt);
+    }
+
+    /* several channels at once are read into a single matrix */
+    if (mxIsCell(pin[1]) || (mxIsNumeric(pin[1]) && mxGetNumberOfElements(pin[1]) != 1))
+    {
+        if ((f = open_smr_file(ifile, get_default_open_flags())) == NULL)
+        {
+            mxFree(ifile);
+            mexErrMsgTxt("Failed to open file");
+        }
+
+        pout[0] = fill_continuous_matrix(f, pin[1], type);
+
+        close_smr_file(f);
+        mxFree(ifile);
+
+        if (pout[0] == NULL)
+        {
+            mexErrMsgTxt("Input 2 *MUST* list valid continuous channels [cell of strings or numeric vector]");
+        }
+
+        return;
+    }
+
     if ((fhdr = read_file_header(ifile)) != NULL)
     {
         if (mxIsChar(pin[1]))
@@ -202,30 +496,59 @@ void mexFunction(int nout, mxArray *pout[], int nin, const mxArray *pin[])
         }
 
         if ((chdr = read_channel_header(fhdr, idx)) != NULL) {
+
+            /* without a cache to go through, decode into the outputs */
+            if (get_channel_cache_info().budget == 0)
+            {
+                f = open_smr_file(ifile, get_default_open_flags());
+            }
+
+            nextra = chdr->nextra;
+
             switch (chdr->kind) {
                 case CONTINUOUS_CHANNEL:
-                    pout[0] = get_continuous_channel(ifile, idx);
+                    pout[0] = f ? fill_continuous_channel(f, idx, type) :
+                        get_continuous_channel(ifile, idx, type);
                     break;
 
                 case EVENT_2_CHANNEL:
                 case EVENT_3_CHANNEL:
                 case EVENT_4_CHANNEL:
-                    pout[0] = get_event_channel(ifile, idx);
+                    pout[0] = f ? fill_event_channel(f, idx) :
+                        get_event_channel(ifile, idx);
                     break;
 
                 case MARKER_CHANNEL:
+                    pout[0] = f ? fill_marker_records(f, idx, "text", 1, mxUINT8_CLASS) :
+                        get_marker_channel(ifile, idx);
+                    break;
+
                 case TEXT_MARKER_CHANNEL:
-                    pout[0] = get_marker_channel(ifile, idx);
+                    pout[0] = f ? fill_marker_records(f, idx, "text", nextra, mxUINT8_CLASS) :
+                        get_marker_channel(ifile, idx);
                     break;
 
                 case ADC_MARKER_CHANNEL:
-                    pout[0] = get_wavemark_channel(ifile, idx);
+                    pout[0] = f ? fill_marker_records(f, idx, "wavemarks",
+                        nextra / sizeof (int16_t), mxINT16_CLASS) :
+                        get_wavemark_channel(ifile, idx);
+                    break;
+
+                case REAL_MARKER_CHANNEL:
+                    pout[0] = f ? fill_marker_records(f, idx, "data",
+                        nextra / sizeof (float), mxSINGLE_CLASS) :
+                        get_realmarker_channel(ifile, idx);
+                    break;
+
+                case REAL_WAVE_CHANNEL:
+                    pout[0] = get_realwave_channel(ifile, idx);
                     break;
 
                 default:
                     pout[0] = mxCreateNumericMatrix(1, 1, mxDOUBLE_CLASS, mxREAL);
                     mexPrintf("WARNING: channels of type %d are not yet supported\n", chdr->kind);
             }
+            close_smr_file(f);
             free_channel_header(chdr);
         }
         else
@@ -1,15 +1,32 @@
-function varargout = smr_read_channel(ifile, channel)
+function varargout = smr_read_channel(ifile, channel, cls)
 % smr_read_channel
 %
-% Syntax: data = smr_read_channel(ifile, channel)
+% Syntax: data = smr_read_channel(ifile, channel, [cls]='double')
 %
 % In:
 %       ifile - the path to a Spike2 .smr file
-%       channel - a channel label [string] or channel index [number]
+%       channel - a channel label [string] or channel index [number], or
+%                 for continuous channels a cell of labels or a vector of
+%                 indices to read them all into one matrix
+%       cls     - the class of continuous channel data: 'double' or 'single'
+%                 (volts) or 'int16' (raw ADC values)
 %
 % Out:
 %       data - a struct with the data from the specified channel
-%              different channel type result in different struct formats
+%              different channel type result in different struct formats.
+%              for several channels data.data is a nsample x nchannel matrix
+%              (zero padded at the end of shorter channels) and
+%              data.sampling_rate a 1 x nchannel vector
+%
+% Notes:
+%       decoded channels can be cached between calls by setting a budget in MB
+%       through the SMR_CACHE_MB environment variable (e.g.
+%       setenv('SMR_CACHE_MB', '4096')), repeated reads of the same channel of
+%       an unchanged file are then served from memory until "clear mex"
+%
+%       without a cache, channels are decoded straight into the outputs, so
+%       the peak memory of a read is just the size of the result. several
+%       channels are read into their matrix in a single pass over the file
 %
 % See also: smr_channel_info
 %
@@ -0,0 +1,152 @@
+#include <string.h>
+#include "matrix.h"
+#include "mex.h"
+#include "smr.h"
+
+/* ========================================================================= */
+/*the events (and markers / waveforms) of trial <k> as a 1 x 1 struct*/
+mxArray *get_trial_events(struct SMREpochChannel *chan, uint64_t k)
+{
+    mxArray *out, *ts, *mrk, *wmrk;
+    uint64_t first = chan->offsets[k];
+    uint64_t n = chan->offsets[k+1] - first;
+
+    const char *fields[] = {"timestamps", "markers", "wavemarks"};
+    out = mxCreateStructMatrix(1, 1, 3, fields);
+
+    ts = mxCreateNumericMatrix(n, 1, mxDOUBLE_CLASS, mxREAL);
+    memcpy(mxGetPr(ts), chan->times + first, (size_t) n * sizeof (double));
+    mxSetField(out, 0, "timestamps", ts);
+
+    if (chan->markers != NULL)
+    {
+        mrk = mxCreateNumericMatrix(MARKER_SIZE, n, mxUINT8_CLASS, mxREAL);
+        memcpy(mxGetData(mrk), chan->markers + first * MARKER_SIZE,
+            (size_t) n * MARKER_SIZE * sizeof (uint8_t));
+        mxSetField(out, 0, "markers", mrk);
+    }
+
+    if (chan->data != NULL)
+    {
+        wmrk = mxCreateNumericMatrix(chan->npt, n, mxINT16_CLASS, mxREAL);
+        memcpy(mxGetData(wmrk), chan->data + first * chan->npt,
+            (size_t) n * chan->npt * sizeof (int16_t));
+        mxSetField(out, 0, "wavemarks", wmrk);
+    }
+
+    return out;
+}
+/* ========================================================================= */
+void mexFunction(int nout, mxArray *pout[], int nin, const mxArray *pin[])
+{
+    char *ifile;
+    struct SMRFile *f = NULL;
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMREpochs *ep = NULL;
+    struct SMREpochChannel *chan;
+
+    mxArray *data, *trials, *fs;
+    double *chan_ptr, *data_ptr;
+    double scale, offset;
+    int *channels;
+    int k;
+    uint64_t j;
+
+    const char *fields[] = {"index", "sampling_rate", "data"};
+
+    /*release any cached channels when matlab clears this mex file*/
+    mexAtExit(clear_channel_cache);
+
+    if (nin < 5)
+    {
+        mexErrMsgTxt("Not enough inputs!");
+    }
+
+    if (!mxIsChar(pin[0]))
+    {
+        mexErrMsgTxt("Input 1 *MUST* be a file path [string]");
+    }
+
+    if (!mxIsDouble(pin[1]) || !mxIsDouble(pin[2]))
+    {
+        mexErrMsgTxt("Inputs 2 and 3 *MUST* be channel indices and trigger times [double]");
+    }
+
+    ifile = mxArrayToString(pin[0]);
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) == NULL)
+    {
+        mxFree(ifile);
+        mexErrMsgTxt("Failed to open file");
+    }
+
+    channels = mxMalloc(sizeof (int) * mxGetNumberOfElements(pin[1]));
+    chan_ptr = mxGetPr(pin[1]);
+
+    for (k = 0; k < (int) mxGetNumberOfElements(pin[1]); ++k)
+    {
+        channels[k] = (int) chan_ptr[k];
+    }
+
+    ep = read_epochs_from_file(f, channels, (int) mxGetNumberOfElements(pin[1]),
+        mxGetPr(pin[2]), (uint64_t) mxGetNumberOfElements(pin[2]),
+        mxGetScalar(pin[3]), mxGetScalar(pin[4]));
+
+    mxFree(channels);
+
+    if (ep == NULL)
+    {
+        close_smr_file(f);
+        mxFree(ifile);
+        mexErrMsgTxt("Failed to read epochs");
+    }
+
+    pout[0] = mxCreateStructMatrix(1, ep->nchannel, 3, fields);
+
+    for (k = 0; k < ep->nchannel; ++k)
+    {
+        chan = ep->channels + k;
+
+        mxSetField(pout[0], k, "index", mxCreateDoubleScalar(chan->index));
+
+        if (chan->kind == CONTINUOUS_CHANNEL)
+        {
+            fs = mxCreateDoubleScalar(chan->sampling_rate);
+            data = mxCreateNumericMatrix(chan->npt, ep->ntrial, mxDOUBLE_CLASS, mxREAL);
+            data_ptr = mxGetPr(data);
+
+            if ((chdr = read_channel_header(f->fhdr, chan->index)) != NULL)
+            {
+                /* same conversion to volts as smr_read_channel */
+                scale = (double) chdr->scale / 6553.6;
+                offset = (double) chdr->offset;
+
+                for (j = 0; j < chan->npt * ep->ntrial; ++j)
+                {
+                    *(data_ptr++) = (chan->data[j] * scale) + offset;
+                }
+
+                free_channel_header(chdr);
+            }
+
+            mxSetField(pout[0], k, "sampling_rate", fs);
+            mxSetField(pout[0], k, "data", data);
+        }
+        else
+        {
+            trials = mxCreateCellMatrix(1, ep->ntrial);
+
+            for (j = 0; j < ep->ntrial; ++j)
+            {
+                mxSetCell(trials, j, get_trial_events(chan, j));
+            }
+
+            mxSetField(pout[0], k, "data", trials);
+        }
+    }
+
+    free_epochs(ep);
+    close_smr_file(f);
+    mxFree(ifile);
+}
+/* ========================================================================= */
@@ -0,0 +1,41 @@
+function varargout = smr_read_epochs(ifile, channels, triggers, pre, post)
+% smr_read_epochs
+%
+% Syntax: ep = smr_read_epochs(ifile, channels, triggers, pre, post)
+%
+% In:
+%       ifile    - the path to a Spike2 .smr file
+%       channels - a vector of channel indices [number]
+%       triggers - a vector of trigger times in seconds
+%       pre      - the # of seconds before each trigger to extract
+%       post     - the # of seconds after each trigger to extract
+%
+% Out:
+%       ep - a 1 x length(channels) struct array with fields:
+%               index         - the channel index
+%               sampling_rate - the sampling rate of continuous channels
+%               data          - for continuous channels a samples x trials
+%                               matrix (in volts), for all other channels a
+%                               1 x trials cell of structs with fields
+%                               'timestamps' (relative to the trigger),
+%                               'markers' and 'wavemarks'
+%
+% Notes:
+%       the blocks of all channels are read in a single pass through the file
+%
+% See also: smr_read_channel
+%
+% Bugs: Please send bug reports to scottiealexander11@gmail.com
+%
+% Updated: 2026-10-19
+% Scottie Alexander
+
+mex_file = [mfilename('fullpath') '.' mexext];
+
+if exist(mex_file, 'file') ~= 2
+    msg = [
+    'The required mex file "%s" appears to be missing!\nCheck mex file ', ...
+    'install location.'...
+    ];
+    error(msg, mex_file);
+end
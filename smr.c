@@ -2,12 +2,50 @@
 gcc -o smr -g -Wall smr.c
 valgrind --tool=memcheck --leak-check=yes --show-reachable=yes ./smr
 */
+/*needed for O_DIRECT, see smr_direct.h*/
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include "smr_utilities.h"
+#include "smr_threads.h"
 #include "smr.h"
+#include "smr_uring.h"
+#include "smr_direct.h"
+#include "smr_mmap.h"
+#include "smr_filter.h"
+
+/* =============================================================================
+INTERNAL FUNCTIONS
+============================================================================= */
+static double channel_sample_interval(struct SMRFileHeader *,
+    struct SMRChannelHeader *);
+static size_t stats_fread(void *, size_t, size_t, FILE *, struct SMRIOStats *);
+static int stats_fseek(FILE *, long, struct SMRIOStats *);
+static char *stats_fill_string(FILE *, int32_t, struct SMRIOStats *);
+static void start_decode_timer(struct SMRFile *, double *);
+static void stop_decode_timer(struct SMRFile *, double *, uint64_t);
+static struct SMRFileHeader *parse_file_header(FILE *, const char *,
+    struct SMRIOStats *);
+static struct SMRChannelHeader *parse_channel_header(FILE *,
+    struct SMRFileHeader *, int, struct SMRIOStats *);
+static struct SMRBlockHeaderArray *walk_block_headers(FILE *,
+    struct SMRChannelHeader *, struct SMRIOStats *);
+static struct SMRBlockHeader parse_block_header(FILE *, struct SMRIOStats *);
+static uint64_t count_frames(struct SMRBlockHeaderArray *, double);
+static void *read_waveform_data(struct SMRFile *, struct SMRChannelHeader *,
+    size_t, uint64_t *, double *);
+static int fetch_block_reads(struct SMRFile *, struct BlockRead *, size_t);
+static int read_block_payloads(struct SMRFile *, struct SMRBlockHeaderArray *,
+    size_t, uint8_t *);
+static struct SMRChannelHeader *fill_channel_header(struct SMRFile *, int,
+    uint8_t, uint8_t, const char *);
+static int read_matching_records(struct SMRFile *, int, const uint8_t *, int,
+    uint64_t *, double **, uint8_t **, uint8_t **);
 
 /* =============================================================================
 UTILITY FUNCTIONS
@@ -18,11 +56,21 @@ double get_sample_interval(struct SMRFileHeader *fhdr, int idx)
     double interval = -1.0;
     struct SMRChannelHeader *chdr = NULL;
 
-    if ((chdr = read_channel_header(fhdr, idx)) == NULL)
+    if ((chdr = read_channel_header(fhdr, idx)) != NULL)
     {
-        goto cleanup;
+        interval = channel_sample_interval(fhdr, chdr);
     }
 
+    free_channel_header(chdr);
+
+    return interval;
+}
+/* -------------------------------------------------------------------------- */
+static double channel_sample_interval(struct SMRFileHeader *fhdr,
+    struct SMRChannelHeader *chdr)
+{
+    double interval = -1.0;
+
     switch (chdr->kind)
     {
         case 1:
@@ -50,9 +98,6 @@ double get_sample_interval(struct SMRFileHeader *fhdr, int idx)
             break;
     }
 
-cleanup:
-    free_channel_header(chdr);
-
     return interval;
 }
 /* ========================================================================== */
@@ -105,11 +150,224 @@ double ticks_to_seconds(struct SMRFileHeader *fhdr, int32_t time)
     return (double)time * (double)fhdr->uspertime * fhdr->dtimebase;
 }
 /* =============================================================================
+I/O STATISTICS
+============================================================================= */
+/*fread / fseek that update <st> when it is not NULL*/
+static size_t stats_fread(void *ptr, size_t size, size_t n, FILE *fp,
+    struct SMRIOStats *st)
+{
+    size_t nread;
+    double t0;
+
+    if (st == NULL)
+    {
+        return fread(ptr, size, n, fp);
+    }
+
+    t0 = get_time();
+    nread = fread(ptr, size, n, fp);
+    st->io_time += get_time() - t0;
+
+    st->bytes_read += (uint64_t) (nread * size);
+    ++st->nread;
+
+    return nread;
+}
+/* -------------------------------------------------------------------------- */
+static int stats_fseek(FILE *fp, long offset, struct SMRIOStats *st)
+{
+    int status;
+    double t0;
+
+    if (st == NULL)
+    {
+        return fseek(fp, offset, SEEK_SET);
+    }
+
+    t0 = get_time();
+    status = fseek(fp, offset, SEEK_SET);
+    st->io_time += get_time() - t0;
+
+    ++st->nseek;
+
+    return status;
+}
+/* -------------------------------------------------------------------------- */
+/*a length prefixed string in a field of <pad> bytes (following the length
+  byte) of a file or channel header, trimmed of white space, NULL if empty. the
+  whole field is read so that it counts toward the bytes read*/
+static char *stats_fill_string(FILE *fp, int32_t pad, struct SMRIOStats *st)
+{
+    uint8_t n = 0;
+    char field[256];
+    char *pt = NULL;
+
+    stats_fread(&n, sizeof (uint8_t), 1, fp, st);
+    stats_fread(field, sizeof (char), (size_t) pad, fp, st);
+
+    if (n > pad)
+    {
+        n = (uint8_t) pad;
+    }
+
+    if (n > 0)
+    {
+        pt = malloc(sizeof (char) * ((size_t) n + 1));
+
+        memcpy(pt, field, n);
+        pt[n] = '\0';
+        strtrim(pt);
+    }
+
+    return pt;
+}
+/* -------------------------------------------------------------------------- */
+/*bracket the block loop of a channel reader: <mark> holds the start time and
+  the io time at the start, everything not spent in fread / fseek in between
+  is counted as conversion*/
+static void start_decode_timer(struct SMRFile *f, double *mark)
+{
+    mark[0] = 0;
+    mark[1] = 0;
+
+    if (f->stats != NULL)
+    {
+        mark[0] = get_time();
+        mark[1] = f->stats->io_time;
+    }
+}
+/* -------------------------------------------------------------------------- */
+static void stop_decode_timer(struct SMRFile *f, double *mark, uint64_t nblock)
+{
+    double elapsed;
+
+    if (f->stats != NULL)
+    {
+        elapsed = get_time() - mark[0];
+
+        f->stats->decode_time += elapsed;
+        f->stats->convert_time += elapsed - (f->stats->io_time - mark[1]);
+        f->stats->nblock += nblock;
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*perform the <n> positioned reads in <reqs>. with SMR_IO_DIRECT they go
+  through the aligned staging buffer, with SMR_IO_URING they are all
+  submitted to io_uring at once. if either is unavailable or fails the
+  handle reverts to stdio for good. returns 0 on success*/
+static int fetch_block_reads(struct SMRFile *f, struct BlockRead *reqs,
+    size_t n)
+{
+    uint64_t nread = 0;
+    uint64_t nbyte = 0;
+    size_t k;
+    double t0;
+    int status = -1;
+
+    if ((f->flags & SMR_IO_URING) && f->direct == NULL && f->uring == NULL)
+    {
+        if ((f->uring = uring_open(URING_QUEUE_DEPTH)) == NULL)
+        {
+            f->flags &= ~SMR_IO_URING;
+        }
+    }
+
+    if ((f->direct != NULL || f->uring != NULL) && n > 0)
+    {
+        t0 = get_time();
+
+        if (f->direct != NULL)
+        {
+            status = direct_read_all(f->direct, reqs, n, &nread, &nbyte);
+        }
+        else
+        {
+            status = uring_read_all(f->uring, f->fp, reqs, n);
+            nread = n;
+
+            for (k = 0; k < n && status == 0; ++k)
+            {
+                nbyte += reqs[k].length;
+            }
+        }
+
+        if (f->stats != NULL)
+        {
+            f->stats->io_time += get_time() - t0;
+            f->stats->nread += nread;
+            f->stats->bytes_read += nbyte;
+        }
+
+        if (status == 0)
+        {
+            return 0;
+        }
+
+        direct_close(f->direct);
+        f->direct = NULL;
+
+        uring_close(f->uring);
+        f->uring = NULL;
+        f->flags &= ~SMR_IO_URING;
+    }
+
+    for (k = 0; k < n; ++k)
+    {
+        stats_fseek(f->fp, (long) reqs[k].offset, f->stats);
+
+        if (stats_fread(reqs[k].dest, 1, reqs[k].length, f->fp, f->stats) != reqs[k].length)
+        {
+            return -1;
+        }
+    }
+
+    /*without direct reads, at least don't let the data linger in the page
+      cache*/
+    if (f->flags & SMR_IO_DIRECT)
+    {
+        drop_file_cache(f->fp);
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*read the data of every block in <bhdr> (<record_size> bytes per item) into
+  <dest>, back to back in block order. returns 0 on success*/
+static int read_block_payloads(struct SMRFile *f,
+    struct SMRBlockHeaderArray *bhdr, size_t record_size, uint8_t *dest)
+{
+    struct BlockRead *reqs;
+    size_t ptr = 0;
+    uint64_t k;
+    int status;
+
+    if (bhdr->length == 0)
+    {
+        return 0;
+    }
+
+    reqs = malloc(sizeof (struct BlockRead) * bhdr->length);
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        reqs[k].offset = (int64_t) bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE;
+        reqs[k].length = (size_t) bhdr->hdr[k].nitem * record_size;
+        reqs[k].dest = dest + ptr;
+
+        ptr += reqs[k].length;
+    }
+
+    status = fetch_block_reads(f, reqs, bhdr->length);
+
+    free(reqs);
+
+    return status;
+}
+/* =============================================================================
 HEADER READ & FREE FUNCTIONS
 ============================================================================= */
 struct SMRFileHeader *read_file_header(const char *ifile)
 {
-    unsigned int k;
     FILE *fp;
     struct SMRFileHeader *hdr = NULL;
 
@@ -119,49 +377,60 @@ struct SMRFileHeader *read_file_header(const char *ifile)
         return NULL;
     }
 
-    rewind(fp);
+    hdr = parse_file_header(fp, ifile, NULL);
+
+    fclose(fp);
+
+    return hdr;
+}
+/* -------------------------------------------------------------------------- */
+static struct SMRFileHeader *parse_file_header(FILE *fp, const char *ifile,
+    struct SMRIOStats *st)
+{
+    unsigned int k;
+    struct SMRFileHeader *hdr = NULL;
+
+    stats_fseek(fp, 0, st);
 
     hdr = malloc(sizeof (struct SMRFileHeader));
 
     hdr->filepath = copy_string(ifile);
 
-    fread(&hdr->system_id, sizeof (hdr->system_id), 1, fp);
+    stats_fread(&hdr->system_id, sizeof (hdr->system_id), 1, fp, st);
 
-    read_chars(fp, "%10c", hdr->copyright, sizeof (hdr->copyright));
+    stats_fread(hdr->copyright, sizeof (char), 10, fp, st);
     hdr->copyright[10] = '\0';
 
-    read_chars(fp, "%8c", hdr->creator, sizeof (hdr->creator));
+    stats_fread(hdr->creator, sizeof (char), 8, fp, st);
     hdr->creator[8] = '\0';
 
-    fread(&hdr->uspertime, sizeof (hdr->uspertime), 1, fp);
-    fread(&hdr->timeperadc, sizeof (hdr->timeperadc), 1, fp);
-    fread(&hdr->filestate, sizeof (hdr->filestate), 1, fp);
+    stats_fread(&hdr->uspertime, sizeof (hdr->uspertime), 1, fp, st);
+    stats_fread(&hdr->timeperadc, sizeof (hdr->timeperadc), 1, fp, st);
+    stats_fread(&hdr->filestate, sizeof (hdr->filestate), 1, fp, st);
 
-    fread(&hdr->firstdata, sizeof (hdr->firstdata), 1, fp);
+    stats_fread(&hdr->firstdata, sizeof (hdr->firstdata), 1, fp, st);
 
-    fread(&hdr->nchannel, sizeof (hdr->nchannel), 1, fp);
-    fread(&hdr->chansize, sizeof (hdr->chansize), 1, fp);
-    fread(&hdr->extra_data, sizeof (hdr->extra_data), 1, fp);
-    fread(&hdr->buffersize, sizeof (hdr->buffersize), 1, fp);
-    fread(&hdr->osformat, sizeof (hdr->osformat), 1, fp);
+    stats_fread(&hdr->nchannel, sizeof (hdr->nchannel), 1, fp, st);
+    stats_fread(&hdr->chansize, sizeof (hdr->chansize), 1, fp, st);
+    stats_fread(&hdr->extra_data, sizeof (hdr->extra_data), 1, fp, st);
+    stats_fread(&hdr->buffersize, sizeof (hdr->buffersize), 1, fp, st);
+    stats_fread(&hdr->osformat, sizeof (hdr->osformat), 1, fp, st);
 
-    fread(&hdr->maxtime, sizeof (hdr->maxtime), 1, fp);
+    stats_fread(&hdr->maxtime, sizeof (hdr->maxtime), 1, fp, st);
 
-    fread(&hdr->dtimebase, sizeof (hdr->dtimebase), 1, fp);
+    stats_fread(&hdr->dtimebase, sizeof (hdr->dtimebase), 1, fp, st);
 
-    fread(hdr->time_detail, sizeof (uint8_t), 6, fp);
-    fread(&hdr->time_year, sizeof (hdr->time_year), 1, fp);
+    stats_fread(hdr->time_detail, sizeof (uint8_t), 6, fp, st);
+    stats_fread(&hdr->time_year, sizeof (hdr->time_year), 1, fp, st);
 
-    fread(hdr->pad, sizeof (char), 52, fp);
+    stats_fread(hdr->pad, sizeof (char), 52, fp, st);
     hdr->pad[52] = '\0';
 
     for (k = 0; k < 5; ++k)
     {
-        hdr->comment[k] = fill_string(fp, 79);
+        hdr->comment[k] = stats_fill_string(fp, 79, st);
     }
 
-    fclose(fp);
-
     return hdr;
 }
 /* -------------------------------------------------------------------------- */
@@ -201,7 +470,17 @@ struct SMRChannelHeader *read_channel_header(struct SMRFileHeader *hdr, int idx)
         return NULL;
     }
 
-    rewind(fp);
+    chan = parse_channel_header(fp, hdr, idx, NULL);
+
+    fclose(fp);
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+static struct SMRChannelHeader *parse_channel_header(FILE *fp,
+    struct SMRFileHeader *hdr, int idx, struct SMRIOStats *st)
+{
+    struct SMRChannelHeader *chan = NULL;
 
     chan = malloc(sizeof (struct SMRChannelHeader));
 
@@ -210,33 +489,33 @@ struct SMRChannelHeader *read_channel_header(struct SMRFileHeader *hdr, int idx)
     chan->filepath = copy_string(hdr->filepath);
 
     /*offset for header and preceeding channels*/
-    fseek(fp, 512+(140*(idx-1)), SEEK_SET);
+    stats_fseek(fp, 512+(140*(idx-1)), st);
 
-    fread(&chan->del_size, sizeof (chan->del_size), 1, fp);
+    stats_fread(&chan->del_size, sizeof (chan->del_size), 1, fp, st);
 
-    fread(&chan->next_del_block, sizeof (chan->next_del_block), 1, fp);
-    fread(&chan->first_block, sizeof (chan->first_block), 1, fp);
-    fread(&chan->last_block, sizeof (chan->last_block), 1, fp);
+    stats_fread(&chan->next_del_block, sizeof (chan->next_del_block), 1, fp, st);
+    stats_fread(&chan->first_block, sizeof (chan->first_block), 1, fp, st);
+    stats_fread(&chan->last_block, sizeof (chan->last_block), 1, fp, st);
 
-    fread(&chan->nblock, sizeof (chan->nblock), 1, fp);
-    fread(&chan->nextra, sizeof (chan->nextra), 1, fp);
-    fread(&chan->pre_trig, sizeof (chan->pre_trig), 1, fp);
-    fread(&chan->free_0, sizeof (chan->free_0), 1, fp);
-    fread(&chan->phy_sz, sizeof (chan->phy_sz), 1, fp);
-    fread(&chan->max_data, sizeof (chan->max_data), 1, fp);
+    stats_fread(&chan->nblock, sizeof (chan->nblock), 1, fp, st);
+    stats_fread(&chan->nextra, sizeof (chan->nextra), 1, fp, st);
+    stats_fread(&chan->pre_trig, sizeof (chan->pre_trig), 1, fp, st);
+    stats_fread(&chan->free_0, sizeof (chan->free_0), 1, fp, st);
+    stats_fread(&chan->phy_sz, sizeof (chan->phy_sz), 1, fp, st);
+    stats_fread(&chan->max_data, sizeof (chan->max_data), 1, fp, st);
 
-    chan->comment = fill_string(fp, 71);
+    chan->comment = stats_fill_string(fp, 71, st);
 
-    fread(&chan->max_chan_time, sizeof (chan->max_chan_time), 1, fp);
-    fread(&chan->l_chan_dvd, sizeof (chan->l_chan_dvd), 1, fp);
+    stats_fread(&chan->max_chan_time, sizeof (chan->max_chan_time), 1, fp, st);
+    stats_fread(&chan->l_chan_dvd, sizeof (chan->l_chan_dvd), 1, fp, st);
 
-    fread(&chan->phy_chan, sizeof (chan->phy_chan), 1, fp);
+    stats_fread(&chan->phy_chan, sizeof (chan->phy_chan), 1, fp, st);
 
-    chan->title = fill_string(fp, 9);
+    chan->title = stats_fill_string(fp, 9, st);
 
-    fread(&chan->ideal_rate, sizeof (chan->ideal_rate), 1, fp);
-    fread(&chan->kind, sizeof (chan->kind), 1, fp);
-    fread(&chan->pad, sizeof (chan->pad), 1, fp);
+    stats_fread(&chan->ideal_rate, sizeof (chan->ideal_rate), 1, fp, st);
+    stats_fread(&chan->kind, sizeof (chan->kind), 1, fp, st);
+    stats_fread(&chan->pad, sizeof (chan->pad), 1, fp, st);
 
     chan->units = NULL;
 
@@ -255,18 +534,18 @@ struct SMRChannelHeader *read_channel_header(struct SMRFileHeader *hdr, int idx)
         case CONTINUOUS_CHANNEL:
         case ADC_MARKER_CHANNEL:
 
-            fread(&chan->scale, sizeof (chan->scale), 1, fp);
-            fread(&chan->offset, sizeof (chan->offset), 1, fp);
+            stats_fread(&chan->scale, sizeof (chan->scale), 1, fp, st);
+            stats_fread(&chan->offset, sizeof (chan->offset), 1, fp, st);
 
-            chan->units = fill_string(fp, 5);
+            chan->units = stats_fill_string(fp, 5, st);
 
             if (hdr->system_id < 6)
             {
-                fread(&chan->divide, sizeof (chan->divide), 1, fp);
+                stats_fread(&chan->divide, sizeof (chan->divide), 1, fp, st);
             }
             else
             {
-                fread(&chan->interleave, sizeof (chan->interleave), 1, fp);
+                stats_fread(&chan->interleave, sizeof (chan->interleave), 1, fp, st);
             }
 
             break;
@@ -274,32 +553,30 @@ struct SMRChannelHeader *read_channel_header(struct SMRFileHeader *hdr, int idx)
         case REAL_MARKER_CHANNEL:
         case REAL_WAVE_CHANNEL:
 
-            fread(&chan->min, sizeof (chan->min), 1, fp);
-            fread(&chan->max, sizeof (chan->max), 1, fp);
+            stats_fread(&chan->min, sizeof (chan->min), 1, fp, st);
+            stats_fread(&chan->max, sizeof (chan->max), 1, fp, st);
 
-            chan->units = fill_string(fp, 5);
+            chan->units = stats_fill_string(fp, 5, st);
 
             if (hdr->system_id < 6)
             {
-                fread(&chan->divide, sizeof (chan->divide), 1, fp);
+                stats_fread(&chan->divide, sizeof (chan->divide), 1, fp, st);
             }
             else
             {
-                fread(&chan->interleave, sizeof (chan->interleave), 1, fp);
+                stats_fread(&chan->interleave, sizeof (chan->interleave), 1, fp, st);
             }
 
             break;
 
         case EVENT_4_CHANNEL:
 
-            fread(&chan->init_low, 1, sizeof (chan->init_low), fp);
-            fread(&chan->next_low, 1, sizeof (chan->next_low), fp);
+            stats_fread(&chan->init_low, 1, sizeof (chan->init_low), fp, st);
+            stats_fread(&chan->next_low, 1, sizeof (chan->next_low), fp, st);
 
             break;
     }
 
-    fclose(fp);
-
     return chan;
 }
 /* -------------------------------------------------------------------------- */
@@ -322,7 +599,6 @@ void free_channel_header(struct SMRChannelHeader *chan)
 struct SMRBlockHeaderArray *read_block_header_array(struct SMRChannelHeader *chan)
 {
     FILE *fp;
-    unsigned int k;
     struct SMRBlockHeaderArray *hdr_array = NULL;
 
     if ((int)chan->first_block == -1)
@@ -339,12 +615,28 @@ struct SMRBlockHeaderArray *read_block_header_array(struct SMRChannelHeader *cha
         return NULL;
     }
 
+    hdr_array = walk_block_headers(fp, chan, NULL);
+
+    fclose(fp);
+
+    return hdr_array;
+}
+/* -------------------------------------------------------------------------- */
+/*follow the chain of blocks belonging to <chan> starting at its first block,
+  on return the <next_block> field of each header holds the file offset of
+  that block*/
+static struct SMRBlockHeaderArray *walk_block_headers(FILE *fp,
+    struct SMRChannelHeader *chan, struct SMRIOStats *st)
+{
+    unsigned int k;
+    struct SMRBlockHeaderArray *hdr_array = NULL;
+
     hdr_array = malloc(sizeof (struct SMRBlockHeaderArray));
     hdr_array->hdr = malloc(sizeof (struct SMRBlockHeader) * chan->nblock);
 
-    fseek(fp, chan->first_block, SEEK_SET);
+    stats_fseek(fp, chan->first_block, st);
 
-    hdr_array->hdr[0] = read_block_header(fp);
+    hdr_array->hdr[0] = parse_block_header(fp, st);
 
     if (hdr_array->hdr[0].last_block == -1)
     {
@@ -354,14 +646,14 @@ struct SMRBlockHeaderArray *read_block_header_array(struct SMRChannelHeader *cha
     }
     else
     {
-        fseek(fp, hdr_array->hdr[0].last_block, SEEK_SET);
+        stats_fseek(fp, hdr_array->hdr[0].last_block, st);
         hdr_array->length = chan->nblock;
 
         for (k = 1; k < chan->nblock; ++k)
         {
-            hdr_array->hdr[k] = read_block_header(fp);
+            hdr_array->hdr[k] = parse_block_header(fp, st);
 
-            fseek(fp, hdr_array->hdr[k].last_block, SEEK_SET);
+            stats_fseek(fp, hdr_array->hdr[k].last_block, st);
 
             hdr_array->hdr[k-1].next_block = hdr_array->hdr[k].next_block;
         }
@@ -370,24 +662,27 @@ struct SMRBlockHeaderArray *read_block_header_array(struct SMRChannelHeader *cha
         hdr_array->length = chan->nblock;
     }
 
-    fclose(fp);
-
     return hdr_array;
 }
 /* -------------------------------------------------------------------------- */
 struct SMRBlockHeader read_block_header(FILE *fp)
+{
+    return parse_block_header(fp, NULL);
+}
+/* -------------------------------------------------------------------------- */
+static struct SMRBlockHeader parse_block_header(FILE *fp, struct SMRIOStats *st)
 {
     struct SMRBlockHeader hdr;
 
     hdr.nitem = 0;
 
-    fread(&hdr.next_block, sizeof (hdr.next_block), 1, fp);
-    fread(&hdr.last_block, sizeof (hdr.last_block), 1, fp);
-    fread(&hdr.start_time, sizeof (hdr.start_time), 1, fp);
-    fread(&hdr.end_time, sizeof (hdr.end_time), 1, fp);
+    stats_fread(&hdr.next_block, sizeof (hdr.next_block), 1, fp, st);
+    stats_fread(&hdr.last_block, sizeof (hdr.last_block), 1, fp, st);
+    stats_fread(&hdr.start_time, sizeof (hdr.start_time), 1, fp, st);
+    stats_fread(&hdr.end_time, sizeof (hdr.end_time), 1, fp, st);
 
-    fread(&hdr.index, sizeof (hdr.index), 1, fp);
-    fread(&hdr.nitem, sizeof (hdr.nitem), 1, fp);
+    stats_fread(&hdr.index, sizeof (hdr.index), 1, fp, st);
+    stats_fread(&hdr.nitem, sizeof (hdr.nitem), 1, fp, st);
 
     return hdr;
 }
@@ -517,133 +812,4663 @@ void free_channel_info_array(struct SMRChannelInfoArray *s)
     }
 }
 /* =============================================================================
-CHANNEL READ & FREE FUNCTIONS
+FILE HANDLE & INDEX FUNCTIONS
 ============================================================================= */
-struct SMRWMrkChannel *read_wavemark_channel(const char *ifile, int idx)
+/*path of the sidecar file that caches the channel and block tables*/
+static char *index_path(const char *ifile)
 {
-    struct SMRFileHeader *fhdr = NULL;
-    struct SMRChannelHeader *chdr = NULL;
-    struct SMRBlockHeaderArray *bhdr = NULL;
-    struct SMRWMrkChannel *chan = NULL;
+    size_t nchar = strlen(ifile) + strlen(INDEX_EXT) + 1;
+    char *path = malloc(sizeof (char) * nchar);
 
-    FILE *fp;
-
-    uint64_t inc = 0;
-    uint64_t k;
-    uint64_t j;
-    int32_t buf;
+    sprintf(path, "%s%s", ifile, INDEX_EXT);
 
-    if (idx < 0)
+    return path;
+}
+/* -------------------------------------------------------------------------- */
+static struct SMRFile *alloc_smr_file(const char *ifile)
+{
+    struct SMRFile *f = malloc(sizeof (struct SMRFile));
+
+    f->fhdr = NULL;
+    f->chdr = NULL;
+    f->bhdr = NULL;
+    f->bstats = NULL;
+    f->stats = NULL;
+    f->uring = NULL;
+    f->direct = NULL;
+    f->fp = NULL;
+    f->flags = 0;
+    memset(&f->stamp, 0, sizeof (struct SMRFileStamp));
+
+    if ((f->fp = open_file(ifile, FILE_READ_MODE)) == NULL)
     {
-        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
-        goto cleanup;
+        fprintf(stderr, "[ERROR]: failed to open file - %s\n", ifile);
+        free(f);
+
+        return NULL;
     }
 
-    if ((fhdr = read_file_header(ifile)) == NULL)
+    if (get_file_stat(ifile, &f->stamp) != 0)
     {
-        goto cleanup;
+        fprintf(stderr, "[ERROR]: failed to stat file - %s\n", ifile);
+        fclose(f->fp);
+        free(f);
+
+        return NULL;
     }
 
-    if ((chdr = read_channel_header(fhdr, idx)) == NULL)
+    return f;
+}
+/* -------------------------------------------------------------------------- */
+/*per-handle I/O state requested by the open_smr_file <flags>*/
+static void init_io_state(struct SMRFile *f, const char *ifile, int flags)
+{
+    f->flags = flags;
+
+    if (flags & SMR_IO_STATS)
     {
-        goto cleanup;
+        f->stats = calloc(1, sizeof (struct SMRIOStats));
     }
 
-    if (chdr->kind != ADC_MARKER_CHANNEL)
+    if (flags & SMR_IO_DIRECT)
     {
-        char msg[80];
-        sprintf(msg, "Channel [%d - %s] is not a wavemark channel", chdr->index, chdr->title);
-        fprintf(stderr, "ERROR: %s\n", msg);
-
-        goto cleanup;
+        /*NULL if direct reads aren't possible, stdio is used instead*/
+        f->direct = direct_open(ifile);
+        advise_sequential(f->fp);
     }
+}
+/* -------------------------------------------------------------------------- */
+static void alloc_channel_tables(struct SMRFile *f)
+{
+    size_t nchannel = (size_t) f->fhdr->nchannel;
+
+    f->chdr = calloc(nchannel, sizeof (struct SMRChannelHeader *));
+    f->bhdr = calloc(nchannel, sizeof (struct SMRBlockHeaderArray *));
+    f->bstats = calloc(nchannel, sizeof (struct SMRBlockStats *));
+}
+/* -------------------------------------------------------------------------- */
+/*min / max / mean of every block of a waveform channel, requires reading all
+  of the channel's data*/
+static struct SMRBlockStats *compute_block_stats(struct SMRFile *f,
+    struct SMRChannelHeader *chdr, struct SMRBlockHeaderArray *bhdr)
+{
+    struct SMRBlockStats *stats;
+
+    size_t size;
+    size_t max_item = 0;
+    uint64_t k;
+    uint64_t j;
+    double mark[2];
 
-    if ((bhdr = read_block_header_array(chdr)) == NULL)
+    uint8_t *buffer;
+
+    if (chdr->kind == CONTINUOUS_CHANNEL)
     {
-        goto cleanup;
+        size = sizeof (int16_t);
+    }
+    else if (chdr->kind == REAL_WAVE_CHANNEL)
+    {
+        size = sizeof (float);
+    }
+    else
+    {
+        return NULL;
     }
-
-    chan = malloc(sizeof (struct SMRWMrkChannel));
-    chan->length = 0;
 
     for (k = 0; k < bhdr->length; ++k)
     {
-        chan->length += (uint64_t) bhdr->hdr[k].nitem;
+        if ((size_t) bhdr->hdr[k].nitem > max_item)
+        {
+            max_item = (size_t) bhdr->hdr[k].nitem;
+        }
     }
 
-    /*data points per spike*/
-    chan->npt = chdr->nextra / sizeof (int16_t);
+    stats = malloc(sizeof (struct SMRBlockStats) * bhdr->length);
+    buffer = malloc(size * max_item);
 
-    chan->timestamps = malloc(sizeof (double) * chan->length);
-    chan->markers = malloc(sizeof (uint8_t) * chan->length * MARKER_SIZE);
-    chan->wavemarks = malloc(sizeof (int16_t) * chan->length * chan->npt);
+    start_decode_timer(f, mark);
 
-    if ((fp = open_file(ifile, FILE_READ_MODE)) == NULL)
+    for (k = 0; k < bhdr->length; ++k)
     {
-        free_wavemark_channel(chan);
-        goto cleanup;
-    }
+        size_t nitem = (size_t) bhdr->hdr[k].nitem;
+        double total = 0.0;
+        float x;
 
-    for (k = 0; k < chdr->nblock; ++k)
-    {
-        fseek(fp, bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE, SEEK_SET);
+        stats[k].min = 0.0f;
+        stats[k].max = 0.0f;
+        stats[k].mean = 0.0f;
+
+        stats_fseek(f->fp, bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE, f->stats);
 
-        for (j = 0; j < bhdr->hdr[k].nitem; ++j, ++inc)
+        if (nitem < 1 || stats_fread(buffer, size, nitem, f->fp, f->stats) != nitem)
         {
-            fread(&buf, sizeof (buf), 1, fp);
-            fread(chan->markers+(inc*MARKER_SIZE), sizeof (uint8_t), MARKER_SIZE, fp);
-            fread(chan->wavemarks+(inc*chan->npt), sizeof (int16_t), chan->npt, fp);
+            continue;
+        }
 
-            /*convert time in ticks to seconds*/
-            chan->timestamps[inc] = ticks_to_seconds(fhdr, buf);
+        for (j = 0; j < nitem; ++j)
+        {
+            if (size == sizeof (int16_t))
+            {
+                x = (float) ((int16_t *) buffer)[j];
+            }
+            else
+            {
+                x = ((float *) buffer)[j];
+            }
+
+            if (j == 0 || x < stats[k].min) { stats[k].min = x; }
+            if (j == 0 || x > stats[k].max) { stats[k].max = x; }
+
+            total += (double) x;
         }
+
+        stats[k].mean = (float) (total / (double) nitem);
     }
 
-    fclose(fp);
+    stop_decode_timer(f, mark, bhdr->length);
 
-cleanup:
-    free_channel_header(chdr);
-    free_file_header(fhdr);
-    free_block_header_array(bhdr);
+    free(buffer);
 
-    return chan;
+    return stats;
 }
 /* -------------------------------------------------------------------------- */
-void free_wavemark_channel(struct SMRWMrkChannel *chan)
+/*strings are stored as a uint16 length followed by the characters, a length
+  of 0xffff indicates a NULL string*/
+static void write_index_string(FILE *fp, const char *str)
 {
-    if (chan)
-    {
-        if (chan->timestamps) { free(chan->timestamps); }
-
-        if (chan->markers) { free(chan->markers); }
+    uint16_t len = str ? (uint16_t) strlen(str) : 0xffff;
 
-        if (chan->wavemarks) { free(chan->wavemarks); }
+    fwrite(&len, sizeof (len), 1, fp);
 
-        free(chan);
+    if (str)
+    {
+        fwrite(str, sizeof (char), len, fp);
     }
 }
-/* ========================================================================== */
-struct SMRContChannel *read_continuous_channel(const char *ifile, int idx)
+/* -------------------------------------------------------------------------- */
+static char *read_index_string(FILE *fp, int *err)
 {
+    uint16_t len = 0;
+    char *str = NULL;
 
-    struct SMRFileHeader *fhdr = NULL;
-    struct SMRChannelHeader *chdr = NULL;
-    struct SMRContChannel *chan = NULL;
-
-    if (idx < 0)
+    if (fread(&len, sizeof (len), 1, fp) != 1)
+    {
+        *err = 1;
+    }
+    else if (len != 0xffff)
+    {
+        str = malloc(sizeof (char) * (len + 1));
+
+        if (fread(str, sizeof (char), len, fp) != len) { *err = 1; }
+
+        str[len] = '\0';
+    }
+
+    return str;
+}
+/* -------------------------------------------------------------------------- */
+/*NOTE: the header structs are written as-is (with their string pointers
+  re-created on load), so the sidecar is only valid for the ABI that wrote
+  it, the struct sizes are stored to catch e.g. 32 vs 64 bit readers.
+  concurrent opens of the same file (by other threads or processes) each
+  write a private temporary that is then renamed over <path>, so readers
+  never see a partially written sidecar*/
+static int write_index_file(struct SMRFile *f, const char *path)
+{
+    FILE *fp;
+    char *tmp;
+    int k, err;
+    uint32_t version = INDEX_VERSION;
+    uint32_t sizes[3];
+    uint8_t has_stats;
+
+    tmp = malloc(sizeof (char) * (strlen(path) + 64));
+    sprintf(tmp, "%s.%lu.%p", path, process_id(), (void *) f);
+
+    if ((fp = open_file(tmp, FILE_WRITE_MODE)) == NULL)
+    {
+        free(tmp);
+        return -1;
+    }
+
+    sizes[0] = (uint32_t) sizeof (struct SMRFileHeader);
+    sizes[1] = (uint32_t) sizeof (struct SMRChannelHeader);
+    sizes[2] = (uint32_t) sizeof (struct SMRBlockHeader);
+
+    fwrite(INDEX_MAGIC, sizeof (char), 8, fp);
+    fwrite(&version, sizeof (version), 1, fp);
+    fwrite(sizes, sizeof (uint32_t), 3, fp);
+    fwrite(&f->stamp, sizeof (struct SMRFileStamp), 1, fp);
+
+    fwrite(f->fhdr, sizeof (struct SMRFileHeader), 1, fp);
+
+    for (k = 0; k < 5; ++k)
+    {
+        write_index_string(fp, f->fhdr->comment[k]);
+    }
+
+    for (k = 0; k < f->fhdr->nchannel; ++k)
+    {
+        struct SMRChannelHeader *chdr = f->chdr[k];
+        uint32_t length = f->bhdr[k] ? f->bhdr[k]->length : 0;
+
+        fwrite(chdr, sizeof (struct SMRChannelHeader), 1, fp);
+
+        write_index_string(fp, chdr->comment);
+        write_index_string(fp, chdr->title);
+        write_index_string(fp, chdr->units);
+
+        fwrite(&length, sizeof (length), 1, fp);
+
+        if (length > 0)
+        {
+            fwrite(f->bhdr[k]->hdr, sizeof (struct SMRBlockHeader), length, fp);
+        }
+
+        has_stats = f->bstats[k] != NULL;
+        fwrite(&has_stats, sizeof (has_stats), 1, fp);
+
+        if (has_stats)
+        {
+            fwrite(f->bstats[k], sizeof (struct SMRBlockStats), length, fp);
+        }
+    }
+
+    err = ferror(fp);
+    err |= fclose(fp);
+
+    if (err != 0 || replace_file(tmp, path) != 0)
+    {
+        remove(tmp);
+        free(tmp);
+        return -1;
+    }
+
+    free(tmp);
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*fill the header and block tables of <f> from the sidecar at <path>, returns
+  0 on success or -1 if the sidecar is missing, stale or corrupt*/
+static int read_index_file(struct SMRFile *f, const char *path, int flags)
+{
+    FILE *fp;
+    int k;
+    int err = 0;
+
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t sizes[3] = {0, 0, 0};
+    struct SMRFileStamp stamp;
+    size_t nread = 0;
+
+    if ((fp = open_file(path, FILE_READ_MODE)) == NULL)
+    {
+        return -1;
+    }
+
+    nread += fread(magic, sizeof (char), 8, fp);
+    nread += fread(&version, sizeof (version), 1, fp);
+    nread += fread(sizes, sizeof (uint32_t), 3, fp);
+    nread += fread(&stamp, sizeof (struct SMRFileStamp), 1, fp);
+
+    if (nread != 13 || memcmp(magic, INDEX_MAGIC, 8) != 0 ||
+        version != INDEX_VERSION ||
+        sizes[0] != sizeof (struct SMRFileHeader) ||
+        sizes[1] != sizeof (struct SMRChannelHeader) ||
+        sizes[2] != sizeof (struct SMRBlockHeader) ||
+        !same_file_stamp(&stamp, &f->stamp))
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    f->fhdr = malloc(sizeof (struct SMRFileHeader));
+
+    if (fread(f->fhdr, sizeof (struct SMRFileHeader), 1, fp) != 1)
+    {
+        /*make sure free_file_header doesn't touch garbage pointers*/
+        memset(f->fhdr, 0, sizeof (struct SMRFileHeader));
+        fclose(fp);
+        return -1;
+    }
+
+    f->fhdr->filepath = NULL;
+
+    for (k = 0; k < 5; ++k)
+    {
+        f->fhdr->comment[k] = read_index_string(fp, &err);
+    }
+
+    alloc_channel_tables(f);
+
+    for (k = 0; k < f->fhdr->nchannel && !err; ++k)
+    {
+        struct SMRChannelHeader *chdr = malloc(sizeof (struct SMRChannelHeader));
+        uint32_t length = 0;
+        uint8_t has_stats = 0;
+
+        f->chdr[k] = chdr;
+
+        if (fread(chdr, sizeof (struct SMRChannelHeader), 1, fp) != 1)
+        {
+            memset(chdr, 0, sizeof (struct SMRChannelHeader));
+            err = 1;
+            break;
+        }
+
+        chdr->filepath = NULL;
+        chdr->comment = read_index_string(fp, &err);
+        chdr->title = read_index_string(fp, &err);
+        chdr->units = read_index_string(fp, &err);
+
+        if (fread(&length, sizeof (length), 1, fp) != 1)
+        {
+            err = 1;
+            break;
+        }
+
+        if (length > 0)
+        {
+            f->bhdr[k] = malloc(sizeof (struct SMRBlockHeaderArray));
+            f->bhdr[k]->length = length;
+            f->bhdr[k]->hdr = malloc(sizeof (struct SMRBlockHeader) * length);
+
+            if (fread(f->bhdr[k]->hdr, sizeof (struct SMRBlockHeader), length, fp) != length)
+            {
+                err = 1;
+                break;
+            }
+        }
+
+        if (fread(&has_stats, sizeof (has_stats), 1, fp) != 1)
+        {
+            err = 1;
+            break;
+        }
+
+        if (has_stats)
+        {
+            f->bstats[k] = malloc(sizeof (struct SMRBlockStats) * length);
+
+            if (fread(f->bstats[k], sizeof (struct SMRBlockStats), length, fp) != length)
+            {
+                err = 1;
+                break;
+            }
+        }
+    }
+
+    fclose(fp);
+
+    /*an index written without block statistics is stale if they were asked
+      for and the file has waveform channels*/
+    if (!err && (flags & SMR_INDEX_STATS))
+    {
+        for (k = 0; k < f->fhdr->nchannel; ++k)
+        {
+            if (f->bhdr[k] && f->bstats[k] == NULL &&
+                (f->chdr[k]->kind == CONTINUOUS_CHANNEL ||
+                f->chdr[k]->kind == REAL_WAVE_CHANNEL))
+            {
+                err = 1;
+                break;
+            }
+        }
+    }
+
+    return err ? -1 : 0;
+}
+/* -------------------------------------------------------------------------- */
+static void free_channel_tables(struct SMRFile *f)
+{
+    int k;
+
+    if (f->fhdr)
+    {
+        for (k = 0; k < f->fhdr->nchannel; ++k)
+        {
+            if (f->chdr) { free_channel_header(f->chdr[k]); }
+
+            if (f->bhdr) { free_block_header_array(f->bhdr[k]); }
+
+            if (f->bstats && f->bstats[k]) { free(f->bstats[k]); }
+        }
+    }
+
+    if (f->chdr) { free(f->chdr); }
+
+    if (f->bhdr) { free(f->bhdr); }
+
+    if (f->bstats) { free(f->bstats); }
+
+    free_file_header(f->fhdr);
+
+    f->fhdr = NULL;
+    f->chdr = NULL;
+    f->bhdr = NULL;
+    f->bstats = NULL;
+}
+/* -------------------------------------------------------------------------- */
+/*open_smr_file flags of the path based readers (read_*_channel and friends),
+  0 unless set with set_default_open_flags() or, until that is called, the
+  SMR_OPEN_FLAGS environment variable (e.g. SMR_OPEN_FLAGS=0x08 for io_uring)*/
+static struct
+{
+    smr_mutex_t lock;
+    int configured;
+    int flags;
+} default_open = {SMR_MUTEX_INIT, 0, 0};
+/* -------------------------------------------------------------------------- */
+void set_default_open_flags(int flags)
+{
+    mutex_lock(&default_open.lock);
+
+    default_open.configured = 1;
+    default_open.flags = flags;
+
+    mutex_unlock(&default_open.lock);
+}
+/* -------------------------------------------------------------------------- */
+int get_default_open_flags(void)
+{
+    const char *env;
+    int flags;
+
+    mutex_lock(&default_open.lock);
+
+    if (!default_open.configured)
+    {
+        env = getenv("SMR_OPEN_FLAGS");
+        default_open.flags = env != NULL ? (int) strtol(env, NULL, 0) : 0;
+    }
+
+    flags = default_open.flags;
+
+    mutex_unlock(&default_open.lock);
+
+    return flags;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRFile *open_smr_file(const char *ifile, int flags)
+{
+    struct SMRFile *f;
+    char *path = NULL;
+    double t0;
+    int k;
+
+    if ((f = alloc_smr_file(ifile)) == NULL)
+    {
+        return NULL;
+    }
+
+    init_io_state(f, ifile, flags);
+
+    t0 = get_time();
+
+    if (flags & SMR_USE_INDEX)
+    {
+        path = index_path(ifile);
+
+        if (read_index_file(f, path, flags) == 0)
+        {
+            /*the filepath fields are not stored in the sidecar*/
+            f->fhdr->filepath = copy_string(ifile);
+
+            for (k = 0; k < f->fhdr->nchannel; ++k)
+            {
+                f->chdr[k]->filepath = copy_string(ifile);
+            }
+
+            free(path);
+
+            if (f->stats) { f->stats->parse_time += get_time() - t0; }
+
+            return f;
+        }
+
+        /*stale or corrupt sidecar, start from scratch*/
+        free_channel_tables(f);
+    }
+
+    f->fhdr = parse_file_header(f->fp, ifile, f->stats);
+
+    alloc_channel_tables(f);
+
+    for (k = 0; k < f->fhdr->nchannel; ++k)
+    {
+        f->chdr[k] = parse_channel_header(f->fp, f->fhdr, k+1, f->stats);
+    }
+
+    if (f->stats) { f->stats->parse_time += get_time() - t0; }
+
+    if (flags & SMR_USE_INDEX)
+    {
+        /*walk every block chain now so that the sidecar is complete*/
+        for (k = 0; k < f->fhdr->nchannel; ++k)
+        {
+            if (f->chdr[k]->kind > 0 && f->chdr[k]->first_block != -1)
+            {
+                t0 = get_time();
+                f->bhdr[k] = walk_block_headers(f->fp, f->chdr[k], f->stats);
+                if (f->stats) { f->stats->walk_time += get_time() - t0; }
+
+                if (flags & SMR_INDEX_STATS)
+                {
+                    f->bstats[k] = compute_block_stats(f, f->chdr[k], f->bhdr[k]);
+                }
+            }
+        }
+
+        /*failing to write the sidecar is not an error, the index will just
+          be rebuilt on the next open*/
+        if (write_index_file(f, path) != 0)
+        {
+            fprintf(stderr, "WARNING: failed to write index file - %s\n", path);
+        }
+
+        free(path);
+    }
+
+    return f;
+}
+/* -------------------------------------------------------------------------- */
+void close_smr_file(struct SMRFile *f)
+{
+    if (f)
+    {
+        free_channel_tables(f);
+
+        if (f->fp && (f->flags & SMR_IO_DIRECT)) { drop_file_cache(f->fp); }
+
+        if (f->fp) { fclose(f->fp); }
+
+        if (f->stats) { free(f->stats); }
+
+        if (f->uring) { uring_close(f->uring); }
+
+        if (f->direct) { direct_close(f->direct); }
+
+        free(f);
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*the returned header is owned by <f>*/
+struct SMRChannelHeader *get_channel_header(struct SMRFile *f, int idx)
+{
+    if ((idx > (int)f->fhdr->nchannel) | (idx < 1))
+    {
+        char msg[80];
+        sprintf(msg, "Requested channel [%d] is out of range [%d]", idx, f->fhdr->nchannel);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    return f->chdr[idx-1];
+}
+/* -------------------------------------------------------------------------- */
+/*kind of channel <idx> (0 for unused slots), -1 if <idx> is out of range*/
+int get_channel_kind(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chan;
+
+    return (chan = get_channel_header(f, idx)) != NULL ? (int) chan->kind : -1;
+}
+/* -------------------------------------------------------------------------- */
+/*same as channel_label_to_index but from the headers already held by <f>,
+  i.e. without touching the file*/
+int channel_label_file_to_index(struct SMRFile *f, const char *label)
+{
+    int k;
+
+    for (k = 0; k < f->fhdr->nchannel; ++k)
+    {
+        if (f->chdr[k]->kind > 0 &&
+            string_compare_nocase(label, f->chdr[k]->title) == 0)
+        {
+            return f->chdr[k]->index;
+        }
+    }
+
+    return -1;
+}
+/* -------------------------------------------------------------------------- */
+/*the returned array is owned by <f>, the block chain is walked on first use*/
+struct SMRBlockHeaderArray *get_block_header_array(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chan;
+    double t0;
+
+    if ((chan = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (f->bhdr[idx-1] == NULL)
+    {
+        if ((int)chan->first_block == -1)
+        {
+            char msg[80];
+            sprintf(msg, "Channel [%d - %s] contains no data", chan->index, chan->title);
+            fprintf(stderr, "ERROR: %s\n", msg);
+
+            return NULL;
+        }
+
+        t0 = get_time();
+        f->bhdr[idx-1] = walk_block_headers(f->fp, chan, f->stats);
+        if (f->stats) { f->stats->walk_time += get_time() - t0; }
+    }
+
+    return f->bhdr[idx-1];
+}
+/* -------------------------------------------------------------------------- */
+/*per-block min / max / mean of a waveform channel, only available when the
+  file was opened with SMR_INDEX_STATS. the returned array is owned by <f>*/
+struct SMRBlockStats *get_block_stats(struct SMRFile *f, int idx)
+{
+    if (get_channel_header(f, idx) == NULL)
+    {
+        return NULL;
+    }
+
+    return f->bstats[idx-1];
+}
+/* -------------------------------------------------------------------------- */
+/*the I/O statistics collected since the file was opened (or last reset), NULL
+  unless the file was opened with SMR_IO_STATS. the returned struct is owned
+  by <f>*/
+struct SMRIOStats *get_io_stats(struct SMRFile *f)
+{
+    return f->stats;
+}
+/* -------------------------------------------------------------------------- */
+void reset_io_stats(struct SMRFile *f)
+{
+    if (f->stats)
+    {
+        memset(f->stats, 0, sizeof (struct SMRIOStats));
+    }
+}
+/* =============================================================================
+CHANNEL CACHE
+
+process-wide LRU cache of decoded channels used by the path based readers
+(read_*_channel). entries are keyed by path, file stamp (struct SMRFileStamp),
+channel index and result type, so a file that changes on disk is never served
+stale. the arrays of a cached channel are shared (not copied) by the cache
+entry and every channel handed out for it, see free_buffer(): callers still
+free what they get back as usual, but must treat the arrays as read-only.
+disabled by default, the budget is set with set_channel_cache_size() or, until
+that is called, read from the SMR_CACHE_MB environment variable on each use.
+all access goes through <channel_cache.lock>, decoding happens outside of it
+============================================================================= */
+struct CacheEntry
+{
+    char *path;
+    struct SMRFileStamp stamp;
+    int idx;
+    int type;
+
+    void *data;
+    uint64_t nbyte;
+
+    struct CacheEntry *prev; /*more recently used*/
+    struct CacheEntry *next; /*less recently used*/
+};
+/* -------------------------------------------------------------------------- */
+static struct
+{
+    smr_mutex_t lock;
+    struct CacheEntry *head;
+    struct CacheEntry *tail;
+    int configured;
+    uint64_t budget;
+    struct SMRCacheInfo info;
+} channel_cache = {SMR_MUTEX_INIT, NULL, NULL, 0, 0, {0, 0, 0, 0, 0, 0}};
+/* -------------------------------------------------------------------------- */
+/*arrays held by more than one channel (a cache entry and the channels handed
+  out for it) and their # of holders. an array that is not listed has a single
+  holder, free_buffer() drops a holder and frees the array along with the last*/
+#define SHARED_BUCKETS 256
+
+struct SharedBuffer
+{
+    void *ptr;
+    uint64_t nref;
+    struct SharedBuffer *next;
+};
+
+static struct
+{
+    smr_mutex_t lock;
+    struct SharedBuffer *bucket[SHARED_BUCKETS];
+} shared_buffers = {SMR_MUTEX_INIT, {NULL}};
+/* -------------------------------------------------------------------------- */
+/*the link that holds (or would hold) the entry of <ptr>*/
+static struct SharedBuffer **shared_slot(const void *ptr)
+{
+    struct SharedBuffer **s;
+
+    s = shared_buffers.bucket + (((uintptr_t) ptr >> 4) % SHARED_BUCKETS);
+
+    while (*s != NULL && (*s)->ptr != ptr)
+    {
+        s = &(*s)->next;
+    }
+
+    return s;
+}
+/* -------------------------------------------------------------------------- */
+/*add a holder to <ptr>*/
+static void retain_buffer(void *ptr)
+{
+    struct SharedBuffer **s;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    mutex_lock(&shared_buffers.lock);
+
+    if (*(s = shared_slot(ptr)) != NULL)
+    {
+        ++(*s)->nref;
+    }
+    else
+    {
+        *s = malloc(sizeof (struct SharedBuffer));
+
+        (*s)->ptr = ptr;
+        (*s)->nref = 2;
+        (*s)->next = NULL;
+    }
+
+    mutex_unlock(&shared_buffers.lock);
+}
+/* -------------------------------------------------------------------------- */
+/*drop a holder of <ptr>, freeing it if that was the last one*/
+static void release_buffer(void *ptr)
+{
+    struct SharedBuffer **s;
+    struct SharedBuffer *b;
+    int last = 1;
+
+    if (ptr == NULL)
+    {
+        return;
+    }
+
+    mutex_lock(&shared_buffers.lock);
+
+    if ((b = *(s = shared_slot(ptr))) != NULL)
+    {
+        last = 0;
+
+        /*a single remaining holder is implied by not being listed*/
+        if (--b->nref == 1)
+        {
+            *s = b->next;
+            free(b);
+        }
+    }
+
+    mutex_unlock(&shared_buffers.lock);
+
+    if (last)
+    {
+        free(ptr);
+    }
+}
+/* -------------------------------------------------------------------------- */
+static void *share_buffer(void *ptr, size_t nbyte, uint64_t *total)
+{
+    retain_buffer(ptr);
+
+    *total += (uint64_t) nbyte;
+
+    return ptr;
+}
+/* -------------------------------------------------------------------------- */
+/*a new channel struct that shares the arrays of <src>, <*nbyte> is set to the
+  size of the arrays*/
+static void *share_channel_data(int type, const void *src, uint64_t *nbyte)
+{
+    *nbyte = 0;
+
+    switch (type)
+    {
+        case WAVEMARK_DATA:
+        {
+            const struct SMRWMrkChannel *s = src;
+            struct SMRWMrkChannel *d = malloc(sizeof (struct SMRWMrkChannel));
+
+            *d = *s;
+            d->timestamps = share_buffer(s->timestamps, sizeof (double) * s->length, nbyte);
+            d->markers = share_buffer(s->markers, sizeof (uint8_t) * s->length * MARKER_SIZE, nbyte);
+            d->wavemarks = share_buffer(s->wavemarks, sizeof (int16_t) * s->length * s->npt, nbyte);
+
+            return d;
+        }
+        case CONTINUOUS_DATA:
+        {
+            const struct SMRContChannel *s = src;
+            struct SMRContChannel *d = malloc(sizeof (struct SMRContChannel));
+
+            *d = *s;
+            d->data = share_buffer(s->data, sizeof (int16_t) * s->length, nbyte);
+
+            return d;
+        }
+        case REALWAVE_DATA:
+        {
+            const struct SMRRealWaveChannel *s = src;
+            struct SMRRealWaveChannel *d = malloc(sizeof (struct SMRRealWaveChannel));
+
+            *d = *s;
+            d->data = share_buffer(s->data, sizeof (float) * s->length, nbyte);
+
+            return d;
+        }
+        case EVENT_DATA:
+        {
+            const struct SMREventChannel *s = src;
+            struct SMREventChannel *d = malloc(sizeof (struct SMREventChannel));
+
+            *d = *s;
+            d->data = share_buffer(s->data, sizeof (double) * s->length, nbyte);
+
+            return d;
+        }
+        case LEVEL_DATA:
+        {
+            const struct SMRLevelChannel *s = src;
+            struct SMRLevelChannel *d = malloc(sizeof (struct SMRLevelChannel));
+
+            *d = *s;
+            d->start = share_buffer(s->start, sizeof (double) * s->length, nbyte);
+            d->stop = share_buffer(s->stop, sizeof (double) * s->length, nbyte);
+
+            return d;
+        }
+        case MARKER_DATA:
+        {
+            const struct SMRMarkerChannel *s = src;
+            struct SMRMarkerChannel *d = malloc(sizeof (struct SMRMarkerChannel));
+
+            *d = *s;
+            d->timestamps = share_buffer(s->timestamps, sizeof (double) * s->length, nbyte);
+            d->markers = share_buffer(s->markers, sizeof (uint8_t) * s->length * MARKER_SIZE, nbyte);
+            d->text = share_buffer(s->text, sizeof (uint8_t) * s->length * s->npt, nbyte);
+
+            return d;
+        }
+        case REALMARKER_DATA:
+        {
+            const struct SMRRealMarkerChannel *s = src;
+            struct SMRRealMarkerChannel *d = malloc(sizeof (struct SMRRealMarkerChannel));
+
+            *d = *s;
+            d->timestamps = share_buffer(s->timestamps, sizeof (double) * s->length, nbyte);
+            d->markers = share_buffer(s->markers, sizeof (uint8_t) * s->length * MARKER_SIZE, nbyte);
+            d->data = share_buffer(s->data, sizeof (float) * s->length * s->npt, nbyte);
+
+            return d;
+        }
+        default:
+            return NULL;
+    }
+}
+/* -------------------------------------------------------------------------- */
+static void free_channel_data(int type, void *data)
+{
+    switch (type)
+    {
+        case WAVEMARK_DATA:   free_wavemark_channel(data); break;
+        case CONTINUOUS_DATA: free_continuous_channel(data); break;
+        case REALWAVE_DATA:   free_realwave_channel(data); break;
+        case EVENT_DATA:      free_event_channel(data); break;
+        case LEVEL_DATA:      free_level_channel(data); break;
+        case MARKER_DATA:     free_marker_channel(data); break;
+        case REALMARKER_DATA: free_realmarker_channel(data); break;
+        default: break;
+    }
+}
+/* -------------------------------------------------------------------------- */
+static void *decode_channel_data(struct SMRFile *f, int idx, int type)
+{
+    switch (type)
+    {
+        case WAVEMARK_DATA:   return read_wavemark_channel_from_file(f, idx);
+        case CONTINUOUS_DATA: return read_continuous_channel_from_file(f, idx);
+        case REALWAVE_DATA:   return read_realwave_channel_from_file(f, idx);
+        case EVENT_DATA:      return read_event_channel_from_file(f, idx);
+        case LEVEL_DATA:      return read_level_channel_from_file(f, idx);
+        case MARKER_DATA:     return read_marker_channel_from_file(f, idx);
+        case REALMARKER_DATA: return read_realmarker_channel_from_file(f, idx);
+        default:               return NULL;
+    }
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t cache_budget(void)
+{
+    const char *env;
+
+    if (!channel_cache.configured)
+    {
+        env = getenv("SMR_CACHE_MB");
+        channel_cache.budget = env != NULL && atof(env) > 0 ?
+            (uint64_t) (atof(env) * 1024.0 * 1024.0) : 0;
+    }
+
+    return channel_cache.budget;
+}
+/* -------------------------------------------------------------------------- */
+static void cache_unlink(struct CacheEntry *e)
+{
+    if (e->prev) { e->prev->next = e->next; } else { channel_cache.head = e->next; }
+    if (e->next) { e->next->prev = e->prev; } else { channel_cache.tail = e->prev; }
+
+    e->prev = NULL;
+    e->next = NULL;
+}
+/* -------------------------------------------------------------------------- */
+static void cache_push_front(struct CacheEntry *e)
+{
+    e->prev = NULL;
+    e->next = channel_cache.head;
+
+    if (channel_cache.head) { channel_cache.head->prev = e; }
+
+    channel_cache.head = e;
+
+    if (channel_cache.tail == NULL) { channel_cache.tail = e; }
+}
+/* -------------------------------------------------------------------------- */
+static void cache_remove(struct CacheEntry *e)
+{
+    cache_unlink(e);
+
+    channel_cache.info.nbyte -= e->nbyte;
+    --channel_cache.info.nentry;
+
+    free_channel_data(e->type, e->data);
+    free(e->path);
+    free(e);
+}
+/* -------------------------------------------------------------------------- */
+/*evict least recently used entries until <nbyte> more bytes fit the budget*/
+static void cache_make_room(uint64_t nbyte, uint64_t budget)
+{
+    while (channel_cache.tail != NULL && channel_cache.info.nbyte + nbyte > budget)
+    {
+        cache_remove(channel_cache.tail);
+        ++channel_cache.info.nevict;
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*shared body of the path based readers*/
+static struct CacheEntry *cache_find(const char *ifile, int idx, int type,
+    const struct SMRFileStamp *stamp)
+{
+    struct CacheEntry *e;
+
+    for (e = channel_cache.head; e != NULL; e = e->next)
+    {
+        if (e->idx == idx && e->type == type &&
+            same_file_stamp(&e->stamp, stamp) && strcmp(e->path, ifile) == 0)
+        {
+            return e;
+        }
+    }
+
+    return NULL;
+}
+/* -------------------------------------------------------------------------- */
+/*a shared copy of the cached channel <idx> of <ifile>, NULL on a miss or if
+  caching is disabled. <stamp> is the version of the file being read, if NULL
+  <ifile> is stat'd. <*budget> is set to the current cache budget*/
+static void *cache_lookup(const char *ifile, int idx, int type,
+    const struct SMRFileStamp *stamp, uint64_t *budget)
+{
+    struct CacheEntry *e;
+    struct SMRFileStamp tmp;
+    uint64_t nbyte;
+    void *data = NULL;
+
+    mutex_lock(&channel_cache.lock);
+
+    *budget = cache_budget();
+
+    if (*budget > 0 && (stamp != NULL || get_file_stat(ifile, &tmp) == 0))
+    {
+        if ((e = cache_find(ifile, idx, type, stamp ? stamp : &tmp)) != NULL)
+        {
+            cache_unlink(e);
+            cache_push_front(e);
+            ++channel_cache.info.nhit;
+
+            data = share_channel_data(type, e->data, &nbyte);
+        }
+        else
+        {
+            ++channel_cache.info.nmiss;
+        }
+    }
+
+    mutex_unlock(&channel_cache.lock);
+
+    return data;
+}
+/* -------------------------------------------------------------------------- */
+/*cache <data> (channel <idx> of <ifile> decoded from <f>) if it fits*/
+static void cache_insert(struct SMRFile *f, const char *ifile, int idx,
+    int type, void *data)
+{
+    struct CacheEntry *e;
+    uint64_t budget;
+    uint64_t nbyte;
+    void *shared;
+
+    shared = share_channel_data(type, data, &nbyte);
+
+    mutex_lock(&channel_cache.lock);
+
+    /*entries for an older version of the file can never hit again*/
+    for (e = channel_cache.head; e != NULL; )
+    {
+        struct CacheEntry *next = e->next;
+
+        if (!same_file_stamp(&e->stamp, &f->stamp) && strcmp(e->path, ifile) == 0)
+        {
+            cache_remove(e);
+        }
+
+        e = next;
+    }
+
+    /*skip entries larger than the whole budget, or already inserted by
+      a concurrent read of the same channel*/
+    budget = cache_budget();
+
+    if (nbyte <= budget &&
+        cache_find(ifile, idx, type, &f->stamp) == NULL)
+    {
+        cache_make_room(nbyte, budget);
+
+        e = malloc(sizeof (struct CacheEntry));
+
+        e->path = copy_string(ifile);
+        e->stamp = f->stamp;
+        e->idx = idx;
+        e->type = type;
+        e->data = shared;
+        e->nbyte = nbyte;
+
+        cache_push_front(e);
+
+        channel_cache.info.nbyte += e->nbyte;
+        ++channel_cache.info.nentry;
+
+        shared = NULL;
+    }
+
+    mutex_unlock(&channel_cache.lock);
+
+    if (shared != NULL)
+    {
+        free_channel_data(type, shared);
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*shared body of the path based readers*/
+static void *read_cached_channel(const char *ifile, int idx, int type)
+{
+    struct SMRFile *f;
+    uint64_t budget;
+    void *data;
+
+    if ((data = cache_lookup(ifile, idx, type, NULL, &budget)) != NULL)
+    {
+        return data;
+    }
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) == NULL)
+    {
+        return NULL;
+    }
+
+    data = decode_channel_data(f, idx, type);
+
+    if (budget > 0 && data != NULL)
+    {
+        cache_insert(f, ifile, idx, type, data);
+    }
+
+    close_smr_file(f);
+
+    return data;
+}
+/* -------------------------------------------------------------------------- */
+/*shared body of the *_from_header readers: the channel is decoded through a
+  handle that borrows <fhdr> and <chdr> rather than re-parsing the headers*/
+static void *read_header_channel(struct SMRFileHeader *fhdr,
+    struct SMRChannelHeader *chdr, int type)
+{
+    struct SMRFile *f;
+    uint64_t budget;
+    void *data;
+    int k;
+
+    if (fhdr == NULL || chdr == NULL || fhdr->filepath == NULL)
+    {
+        fprintf(stderr, "ERROR: invalid file or channel header\n");
+        return NULL;
+    }
+
+    if (chdr->index < 1 || chdr->index > (int) fhdr->nchannel)
+    {
+        fprintf(stderr, "ERROR: Requested channel [%d] is out of range [%d]\n",
+            chdr->index, fhdr->nchannel);
+        return NULL;
+    }
+
+    if ((f = alloc_smr_file(fhdr->filepath)) == NULL)
+    {
+        return NULL;
+    }
+
+    init_io_state(f, fhdr->filepath, get_default_open_flags());
+
+    k = chdr->index - 1;
+
+    f->fhdr = fhdr;
+    alloc_channel_tables(f);
+    f->chdr[k] = chdr;
+
+    data = cache_lookup(fhdr->filepath, chdr->index, type, &f->stamp, &budget);
+
+    if (data == NULL)
+    {
+        data = decode_channel_data(f, chdr->index, type);
+
+        if (budget > 0 && data != NULL)
+        {
+            cache_insert(f, fhdr->filepath, chdr->index, type, data);
+        }
+    }
+
+    /*hand the borrowed headers back before the handle is closed*/
+    free_block_header_array(f->bhdr[k]);
+    free(f->chdr);
+    free(f->bhdr);
+    free(f->bstats);
+
+    f->fhdr = NULL;
+    f->chdr = NULL;
+    f->bhdr = NULL;
+    f->bstats = NULL;
+
+    close_smr_file(f);
+
+    return data;
+}
+/* -------------------------------------------------------------------------- */
+/*set the byte budget of the channel cache, 0 disables caching. entries are
+  evicted immediately if they no longer fit*/
+void set_channel_cache_size(uint64_t nbyte)
+{
+    mutex_lock(&channel_cache.lock);
+
+    channel_cache.configured = 1;
+    channel_cache.budget = nbyte;
+
+    /*NOTE: a budget of 0 also drops empty (0 byte) entries*/
+    while (channel_cache.tail != NULL &&
+        (nbyte == 0 || channel_cache.info.nbyte > nbyte))
+    {
+        cache_remove(channel_cache.tail);
+        ++channel_cache.info.nevict;
+    }
+
+    mutex_unlock(&channel_cache.lock);
+}
+/* -------------------------------------------------------------------------- */
+void clear_channel_cache(void)
+{
+    mutex_lock(&channel_cache.lock);
+
+    while (channel_cache.head != NULL)
+    {
+        cache_remove(channel_cache.head);
+    }
+
+    mutex_unlock(&channel_cache.lock);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRCacheInfo get_channel_cache_info(void)
+{
+    struct SMRCacheInfo info;
+
+    mutex_lock(&channel_cache.lock);
+
+    info = channel_cache.info;
+    info.budget = cache_budget();
+
+    mutex_unlock(&channel_cache.lock);
+
+    return info;
+}
+/* =============================================================================
+ASYNCHRONOUS READS
+
+requests are queued to a pool of worker threads (started on first use) that
+run the path based readers, so results also go through the channel cache.
+the optional callback runs on the worker thread once the result is available,
+it may call channel_read_ready / wait_channel_read on its request but must not
+free it
+============================================================================= */
+#define READ_POOL_MAX 64
+
+struct SMRAsyncRead
+{
+    char *path;
+    int idx;
+    int type;
+
+    SMRReadCallback callback;
+    void *user;
+
+    void *result;
+    int ready; /*the read has finished, <result> is NULL on failure*/
+    int done;  /*the callback has returned, the request can be freed*/
+
+    struct SMRAsyncRead *next;
+};
+/* -------------------------------------------------------------------------- */
+static struct
+{
+    smr_mutex_t lock;
+    smr_cond_t work;     /*a request was queued or the pool is stopping*/
+    smr_cond_t finished; /*some request became ready or done*/
+
+    smr_thread_t thread[READ_POOL_MAX];
+    int nthread;         /*# of running workers*/
+    int size;            /*# of workers to start*/
+    int stop;
+
+    struct SMRAsyncRead *head;
+    struct SMRAsyncRead *tail;
+} read_pool = {SMR_MUTEX_INIT, SMR_COND_INIT, SMR_COND_INIT, {0}, 0, 2, 0,
+    NULL, NULL};
+/* -------------------------------------------------------------------------- */
+static SMR_THREAD_FUNC(read_pool_worker)
+{
+    struct SMRAsyncRead *req;
+    void *result;
+
+    (void) arg;
+
+    for (;;)
+    {
+        mutex_lock(&read_pool.lock);
+
+        while (read_pool.head == NULL && !read_pool.stop)
+        {
+            cond_wait(&read_pool.work, &read_pool.lock);
+        }
+
+        /*the queue is drained before the workers exit*/
+        if (read_pool.head == NULL)
+        {
+            mutex_unlock(&read_pool.lock);
+            break;
+        }
+
+        req = read_pool.head;
+        read_pool.head = req->next;
+
+        if (read_pool.head == NULL) { read_pool.tail = NULL; }
+
+        mutex_unlock(&read_pool.lock);
+
+        result = read_cached_channel(req->path, req->idx, req->type);
+
+        mutex_lock(&read_pool.lock);
+        req->result = result;
+        req->ready = 1;
+        cond_broadcast(&read_pool.finished);
+        mutex_unlock(&read_pool.lock);
+
+        if (req->callback != NULL)
+        {
+            req->callback(req, req->user);
+        }
+
+        mutex_lock(&read_pool.lock);
+        req->done = 1;
+        cond_broadcast(&read_pool.finished);
+        mutex_unlock(&read_pool.lock);
+    }
+
+    SMR_THREAD_RETURN;
+}
+/* -------------------------------------------------------------------------- */
+/*must be called with <read_pool.lock> held, returns 0 on success*/
+static int start_read_pool(void)
+{
+    int k;
+
+    read_pool.stop = 0;
+
+    for (k = 0; k < read_pool.size; ++k)
+    {
+        if (thread_create(&read_pool.thread[k], read_pool_worker, NULL) != 0)
+        {
+            break;
+        }
+    }
+
+    read_pool.nthread = k;
+
+    return k > 0 ? 0 : -1;
+}
+/* -------------------------------------------------------------------------- */
+/*queue a read of channel <idx> of <ifile> using the reader selected by <type>
+  (see enum channel_data_t), returns immediately. <callback> (may be NULL) is
+  called with the request and <user> when the read has finished. the request
+  must be released with free_channel_read*/
+struct SMRAsyncRead *submit_channel_read(const char *ifile, int idx, int type,
+    SMRReadCallback callback, void *user)
+{
+    struct SMRAsyncRead *req;
+
+    if (type < WAVEMARK_DATA || type > REALMARKER_DATA)
+    {
+        fprintf(stderr, "ERROR: invalid channel data type %d\n", type);
+        return NULL;
+    }
+
+    req = malloc(sizeof (struct SMRAsyncRead));
+
+    req->path = copy_string(ifile);
+    req->idx = idx;
+    req->type = type;
+    req->callback = callback;
+    req->user = user;
+    req->result = NULL;
+    req->ready = 0;
+    req->done = 0;
+    req->next = NULL;
+
+    mutex_lock(&read_pool.lock);
+
+    if (read_pool.nthread == 0 && start_read_pool() != 0)
+    {
+        mutex_unlock(&read_pool.lock);
+
+        fprintf(stderr, "ERROR: failed to start read threads\n");
+        free(req->path);
+        free(req);
+
+        return NULL;
+    }
+
+    if (read_pool.tail) { read_pool.tail->next = req; } else { read_pool.head = req; }
+    read_pool.tail = req;
+
+    cond_broadcast(&read_pool.work);
+
+    mutex_unlock(&read_pool.lock);
+
+    return req;
+}
+/* -------------------------------------------------------------------------- */
+/*1 if the read has finished (successfully or not), 0 if it is pending*/
+int channel_read_ready(struct SMRAsyncRead *req)
+{
+    int ready;
+
+    mutex_lock(&read_pool.lock);
+    ready = req->ready;
+    mutex_unlock(&read_pool.lock);
+
+    return ready;
+}
+/* -------------------------------------------------------------------------- */
+/*block until the read has finished and take ownership of its result, which
+  must be freed with the free_*_channel function matching the requested type.
+  returns NULL if the read failed or the result was already taken*/
+void *wait_channel_read(struct SMRAsyncRead *req)
+{
+    void *result;
+
+    mutex_lock(&read_pool.lock);
+
+    while (!req->ready)
+    {
+        cond_wait(&read_pool.finished, &read_pool.lock);
+    }
+
+    result = req->result;
+    req->result = NULL;
+
+    mutex_unlock(&read_pool.lock);
+
+    return result;
+}
+/* -------------------------------------------------------------------------- */
+/*waits for the read (and its callback) to finish, a result that was not taken
+  with wait_channel_read is freed along with the request*/
+void free_channel_read(struct SMRAsyncRead *req)
+{
+    if (req)
+    {
+        mutex_lock(&read_pool.lock);
+
+        while (!req->done)
+        {
+            cond_wait(&read_pool.finished, &read_pool.lock);
+        }
+
+        mutex_unlock(&read_pool.lock);
+
+        if (req->result) { free_channel_data(req->type, req->result); }
+
+        free(req->path);
+        free(req);
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*finish all queued reads and stop the workers, they are restarted by the next
+  submit_channel_read. must not race with submit_channel_read*/
+void shutdown_read_pool(void)
+{
+    int k;
+    int nthread;
+
+    mutex_lock(&read_pool.lock);
+    read_pool.stop = 1;
+    nthread = read_pool.nthread;
+    cond_broadcast(&read_pool.work);
+    mutex_unlock(&read_pool.lock);
+
+    for (k = 0; k < nthread; ++k)
+    {
+        thread_join(read_pool.thread[k]);
+    }
+
+    mutex_lock(&read_pool.lock);
+    read_pool.nthread = 0;
+    read_pool.stop = 0;
+    mutex_unlock(&read_pool.lock);
+}
+/* -------------------------------------------------------------------------- */
+/*number of worker threads (default 2, at most READ_POOL_MAX), a running pool
+  is drained and restarted with the new size on the next submit*/
+void set_read_pool_size(int nthread)
+{
+    if (nthread < 1) { nthread = 1; }
+    if (nthread > READ_POOL_MAX) { nthread = READ_POOL_MAX; }
+
+    shutdown_read_pool();
+
+    mutex_lock(&read_pool.lock);
+    read_pool.size = nthread;
+    mutex_unlock(&read_pool.lock);
+}
+/* =============================================================================
+CHANNEL READ & FREE FUNCTIONS
+============================================================================= */
+struct SMRWMrkChannel *read_wavemark_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, WAVEMARK_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRWMrkChannel *read_wavemark_channel_from_file(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRWMrkChannel *chan = NULL;
+
+    uint64_t k;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != ADC_MARKER_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a wavemark channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    chan = malloc(sizeof (struct SMRWMrkChannel));
+    chan->length = 0;
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        chan->length += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    /*data points per spike*/
+    chan->npt = chdr->nextra / sizeof (int16_t);
+
+    chan->timestamps = malloc(sizeof (double) * chan->length);
+    chan->markers = malloc(sizeof (uint8_t) * chan->length * MARKER_SIZE);
+    chan->wavemarks = malloc(sizeof (int16_t) * chan->length * chan->npt);
+
+    if (read_marker_records_into(f, idx, chan->timestamps, chan->markers,
+        (uint8_t *) chan->wavemarks) != 0)
+    {
+        free_wavemark_channel(chan);
+        chan = NULL;
+    }
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+void free_wavemark_channel(struct SMRWMrkChannel *chan)
+{
+    if (chan)
+    {
+        if (chan->timestamps) { free_buffer(chan->timestamps); }
+
+        if (chan->markers) { free_buffer(chan->markers); }
+
+        if (chan->wavemarks) { free_buffer(chan->wavemarks); }
+
+        free(chan);
+    }
+}
+/* ========================================================================== */
+struct SMRContChannel *read_continuous_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, CONTINUOUS_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRContChannel *read_continuous_channel_from_file(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRContChannel *chan = NULL;
+
+    int16_t *data;
+    uint64_t length = 0;
+    double sampling_rate = 0.0;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != CONTINUOUS_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a continuous channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    data = read_waveform_data(f, chdr, sizeof (int16_t), &length,
+        &sampling_rate);
+
+    if (data != NULL)
+    {
+        chan = malloc(sizeof (struct SMRContChannel));
+
+        chan->length = length;
+        chan->sampling_rate = sampling_rate;
+        chan->data = data;
+    }
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRContChannel *read_continuous_channel_from_header(
+    struct SMRFileHeader *fhdr, struct SMRChannelHeader *chdr)
+{
+    return read_header_channel(fhdr, chdr, CONTINUOUS_DATA);
+}
+/* ========================================================================== */
+/*number of continuously sampled segments in a waveform channel, a gap of more
+  than one sample interval between consecutive blocks starts a new frame*/
+static uint64_t count_frames(struct SMRBlockHeaderArray *bhdr,
+    double sample_interval)
+{
+    uint64_t nframe = 1;
+    uint64_t k;
+    int32_t tmp;
+
+    for (k = 0; k < bhdr->length-1; ++k)
+    {
+        tmp = bhdr->hdr[k+1].start_time - bhdr->hdr[k].end_time;
+
+        if ((double)tmp > sample_interval) { ++nframe; }
+    }
+
+    return nframe;
+}
+/* ========================================================================== */
+/*shared block loop for the waveform channel kinds (CONTINUOUS_CHANNEL and
+  REAL_WAVE_CHANNEL), <size> is the size in bytes of a single sample. returns
+  a malloc'd buffer of <*length> samples or NULL on failure*/
+static void *read_waveform_data(struct SMRFile *f,
+    struct SMRChannelHeader *chdr, size_t size, uint64_t *length,
+    double *sampling_rate)
+{
+    struct SMRBlockHeaderArray *bhdr = NULL;
+
+    double sample_interval;
+    uint64_t nframe;
+    uint64_t k;
+    double mark[2];
+
+    uint8_t *data = NULL;
+
+    sample_interval = channel_sample_interval(f->fhdr, chdr);
+
+    if ((bhdr = get_block_header_array(f, chdr->index)) == NULL)
+    {
+        return NULL;
+    }
+
+    nframe = count_frames(bhdr, sample_interval);
+
+    *sampling_rate = MICROSECONDS / sample_interval;
+
+    if (nframe == 1)
+    {
+        /*NOTE: indicates continuous sampling */
+        uint64_t nsample = 0;
+
+        for (k = 0; k < bhdr->length; ++k)
+        {
+            /*get total number of samples in the record*/
+            nsample += (uint64_t) bhdr->hdr[k].nitem;
+        }
+
+        data = malloc(size * nsample);
+
+        start_decode_timer(f, mark);
+
+        if (read_block_payloads(f, bhdr, size, data) != 0)
+        {
+            fprintf(stderr, "ERROR: failed to read channel data\n");
+            free(data);
+
+            return NULL;
+        }
+
+        stop_decode_timer(f, mark, bhdr->length);
+
+        *length = nsample;
+    }
+    else
+    {
+        /*triggered sampling... what is this?*/
+        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+    }
+
+    return data;
+}
+/* -------------------------------------------------------------------------- */
+void free_continuous_channel(struct SMRContChannel *s)
+{
+    if (s)
+    {
+        if (s->data) { free_buffer(s->data); }
+
+        free(s);
+    }
+}
+/* ========================================================================== */
+struct SMRRealWaveChannel *read_realwave_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, REALWAVE_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRRealWaveChannel *read_realwave_channel_from_file(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRRealWaveChannel *chan = NULL;
+
+    float *data;
+    uint64_t length = 0;
+    double sampling_rate = 0.0;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != REAL_WAVE_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a real wave channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    /*samples are stored as 32-bit IEEE floats in physical units, so they are
+      read block-wise straight into the output buffer*/
+    data = read_waveform_data(f, chdr, sizeof (float), &length,
+        &sampling_rate);
+
+    if (data != NULL)
+    {
+        chan = malloc(sizeof (struct SMRRealWaveChannel));
+
+        chan->length = length;
+        chan->sampling_rate = sampling_rate;
+        chan->data = data;
+    }
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRRealWaveChannel *read_realwave_channel_from_header(
+    struct SMRFileHeader *fhdr, struct SMRChannelHeader *chdr)
+{
+    return read_header_channel(fhdr, chdr, REALWAVE_DATA);
+}
+/* -------------------------------------------------------------------------- */
+void free_realwave_channel(struct SMRRealWaveChannel *s)
+{
+    if (s)
+    {
+        if (s->data) { free_buffer(s->data); }
+
+        free(s);
+    }
+}
+/* ========================================================================== */
+struct SMREventChannel *read_event_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, EVENT_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMREventChannel *read_event_channel_from_file(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMREventChannel *evt = NULL;
+
+    uint64_t nitem = 0ul;
+    uint64_t k;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind < EVENT_2_CHANNEL || chdr->kind > EVENT_4_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not an event channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        /*get total number of samples in the record*/
+        nitem += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    evt = malloc(sizeof (struct SMREventChannel));
+
+    evt->length = nitem;
+    evt->data = malloc(sizeof (double) * nitem);
+
+    if (read_event_channel_into(f, idx, evt->data) != 0)
+    {
+        free_event_channel(evt);
+        evt = NULL;
+    }
+
+    return evt;
+}
+/* -------------------------------------------------------------------------- */
+void free_event_channel(struct SMREventChannel *s)
+{
+    if (s)
+    {
+        if (s->data) { free_buffer(s->data); }
+
+        free(s);
+    }
+}
+/* ========================================================================== */
+struct SMRLevelChannel *read_level_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, LEVEL_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRLevelChannel *read_level_channel_from_file(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRLevelChannel *lvl = NULL;
+
+    uint64_t nitem = 0;
+    uint64_t inc = 0;
+    uint64_t k;
+    double mark[2];
+
+    /*0 = the next edge ends an interval, 1 = the next edge starts one*/
+    uint8_t rising;
+
+    int32_t *buffer = NULL;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != EVENT_4_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a level event channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        nitem += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    lvl = malloc(sizeof (struct SMRLevelChannel));
+
+    lvl->init_low = chdr->init_low != 0;
+
+    /*if the channel starts high the first edge is a falling one, and the
+      first interval is taken to start at time 0*/
+    lvl->length = (nitem + (lvl->init_low ? 0 : 1) + 1) / 2;
+
+    lvl->start = malloc(sizeof (double) * lvl->length);
+    lvl->stop = malloc(sizeof (double) * lvl->length);
+
+    if (!lvl->init_low && lvl->length > 0)
+    {
+        lvl->start[0] = 0.0;
+        rising = 0;
+    }
+    else
+    {
+        rising = 1;
+    }
+
+    buffer = malloc(sizeof (int32_t) * nitem);
+
+    start_decode_timer(f, mark);
+
+    if (read_block_payloads(f, bhdr, sizeof (int32_t), (uint8_t *) buffer) != 0)
+    {
+        fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+
+        free_level_channel(lvl);
+        lvl = NULL;
+
+        goto cleanup;
+    }
+
+    /*edges alternate, so pair them up as we convert ticks to seconds*/
+    for (k = 0; k < nitem; ++k)
+    {
+        if (rising)
+        {
+            lvl->start[inc] = ticks_to_seconds(f->fhdr, buffer[k]);
+        }
+        else
+        {
+            lvl->stop[inc] = ticks_to_seconds(f->fhdr, buffer[k]);
+            ++inc;
+        }
+
+        rising = !rising;
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    /*an interval that is still open at the end of the recording is closed
+      at the file's max time*/
+    if (inc < lvl->length)
+    {
+        lvl->stop[inc] = ticks_to_seconds(f->fhdr, f->fhdr->maxtime);
+    }
+
+cleanup:
+    if (buffer) { free(buffer); }
+
+    return lvl;
+}
+/* -------------------------------------------------------------------------- */
+void free_level_channel(struct SMRLevelChannel *s)
+{
+    if (s)
+    {
+        if (s->start) { free_buffer(s->start); }
+
+        if (s->stop) { free_buffer(s->stop); }
+
+        free(s);
+    }
+}
+/* ========================================================================== */
+struct SMRMarkerChannel *read_marker_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, MARKER_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRMarkerChannel *read_marker_channel_from_file(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRMarkerChannel *evt = NULL;
+
+    uint64_t k;
+    uint8_t hastext;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != MARKER_CHANNEL && chdr->kind != TEXT_MARKER_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not an event marker channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    if (chdr->kind == MARKER_CHANNEL)
+    {
+        hastext = 0;
+    }
+    else
+    {
+        hastext = 1;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    evt = malloc(sizeof (struct SMRMarkerChannel));
+
+    evt->length = 0;
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        evt->length += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    /*number of characters in text field for each event*/
+    if (hastext)
+    {
+        evt->npt = chdr->nextra / sizeof (uint8_t);
+    }
+    else
+    {
+        evt->npt = 1;
+    }
+
+    evt->timestamps = malloc(sizeof (double) * evt->length);
+    evt->markers = malloc(sizeof (uint8_t) * evt->length * MARKER_SIZE);
+    evt->text = malloc(sizeof (uint8_t) * evt->length * evt->npt);
+
+    if (!hastext)
+    {
+        memset(evt->text, 0, evt->length);
+    }
+
+    if (read_marker_records_into(f, idx, evt->timestamps, evt->markers,
+        hastext ? evt->text : NULL) != 0)
+    {
+        free_marker_channel(evt);
+        evt = NULL;
+    }
+
+    return evt;
+}
+/* -------------------------------------------------------------------------- */
+void free_marker_channel(struct SMRMarkerChannel *s)
+{
+    if (s)
+    {
+        if (s->timestamps) { free_buffer(s->timestamps); }
+
+        if (s->markers) { free_buffer(s->markers); }
+
+        if (s->text) { free_buffer(s->text); }
+
+        free(s);
+    }
+}
+/* ========================================================================== */
+struct SMRRealMarkerChannel *read_realmarker_channel(const char *ifile, int idx)
+{
+    return read_cached_channel(ifile, idx, REALMARKER_DATA);
+}
+/* -------------------------------------------------------------------------- */
+struct SMRRealMarkerChannel *read_realmarker_channel_from_file(
+    struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRRealMarkerChannel *evt = NULL;
+
+    uint64_t k;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != REAL_MARKER_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a real marker channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    evt = malloc(sizeof (struct SMRRealMarkerChannel));
+
+    evt->length = 0;
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        evt->length += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    /*number of floats attached to each marker*/
+    evt->npt = chdr->nextra / sizeof (float);
+
+    evt->timestamps = malloc(sizeof (double) * evt->length);
+    evt->markers = malloc(sizeof (uint8_t) * evt->length * MARKER_SIZE);
+    evt->data = malloc(sizeof (float) * evt->length * evt->npt);
+
+    /*records are unpacked into the contiguous timestamp / marker / data
+      arrays a few MB of blocks at a time*/
+    if (read_marker_records_into(f, idx, evt->timestamps, evt->markers,
+        (uint8_t *) evt->data) != 0)
+    {
+        free_realmarker_channel(evt);
+        evt = NULL;
+    }
+
+    return evt;
+}
+/* -------------------------------------------------------------------------- */
+void free_realmarker_channel(struct SMRRealMarkerChannel *s)
+{
+    if (s)
+    {
+        if (s->timestamps) { free_buffer(s->timestamps); }
+
+        if (s->markers) { free_buffer(s->markers); }
+
+        if (s->data) { free_buffer(s->data); }
+
+        free(s);
+    }
+}
+/* ========================================================================== */
+/*just the times (in seconds) of the records of a marker kind channel, see
+  read_marker_ticks_into*/
+struct SMREventChannel *read_marker_timestamps(const char *ifile, int idx)
+{
+    struct SMRFile *f = NULL;
+    struct SMREventChannel *evt = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        evt = read_marker_timestamps_from_file(f, idx);
+    }
+
+    close_smr_file(f);
+
+    return evt;
+}
+/* -------------------------------------------------------------------------- */
+struct SMREventChannel *read_marker_timestamps_from_file(struct SMRFile *f,
+    int idx)
+{
+    struct SMREventChannel *evt = NULL;
+
+    if (fill_channel_header(f, idx, MARKER_CHANNEL, TEXT_MARKER_CHANNEL,
+        "a marker") == NULL)
+    {
+        return NULL;
+    }
+
+    evt = malloc(sizeof (struct SMREventChannel));
+
+    evt->length = channel_item_count(f, idx);
+    evt->data = malloc(sizeof (double) * evt->length);
+
+    if (read_marker_timestamps_into(f, idx, evt->data) != 0)
+    {
+        free_event_channel(evt);
+        evt = NULL;
+    }
+
+    return evt;
+}
+/* ========================================================================== */
+/*a wavemark channel reduced to the spikes whose unit code (markers[0], as
+  assigned by the spike sorter) is one of the <ncode> <codes>. the filter is
+  applied as the blocks are decoded, so the waveforms of other units are never
+  copied. not cached (see read_cached_channel)*/
+struct SMRWMrkChannel *read_wavemark_channel_codes(const char *ifile, int idx,
+    const uint8_t *codes, int ncode)
+{
+    struct SMRFile *f = NULL;
+    struct SMRWMrkChannel *chan = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        chan = read_wavemark_channel_codes_from_file(f, idx, codes, ncode);
+    }
+
+    close_smr_file(f);
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRWMrkChannel *read_wavemark_channel_codes_from_file(struct SMRFile *f,
+    int idx, const uint8_t *codes, int ncode)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRWMrkChannel *chan = NULL;
+    double *timestamps;
+    uint8_t *markers;
+    uint8_t *extra;
+    uint64_t length;
+
+    if ((chdr = fill_channel_header(f, idx, ADC_MARKER_CHANNEL,
+        ADC_MARKER_CHANNEL, "a wavemark")) == NULL)
+    {
+        return NULL;
+    }
+
+    if (read_matching_records(f, idx, codes, ncode, &length, &timestamps,
+        &markers, &extra) != 0)
+    {
+        return NULL;
+    }
+
+    chan = malloc(sizeof (struct SMRWMrkChannel));
+
+    chan->length = length;
+    chan->npt = chdr->nextra / sizeof (int16_t);
+    chan->timestamps = timestamps;
+    chan->markers = markers;
+    chan->wavemarks = (int16_t *) extra;
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+/*as read_wavemark_channel_codes for marker and text marker channels*/
+struct SMRMarkerChannel *read_marker_channel_codes(const char *ifile, int idx,
+    const uint8_t *codes, int ncode)
+{
+    struct SMRFile *f = NULL;
+    struct SMRMarkerChannel *evt = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        evt = read_marker_channel_codes_from_file(f, idx, codes, ncode);
+    }
+
+    close_smr_file(f);
+
+    return evt;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRMarkerChannel *read_marker_channel_codes_from_file(struct SMRFile *f,
+    int idx, const uint8_t *codes, int ncode)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRMarkerChannel *evt = NULL;
+    double *timestamps;
+    uint8_t *markers;
+    uint8_t *extra;
+    uint64_t length;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != MARKER_CHANNEL && chdr->kind != TEXT_MARKER_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not an event marker channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    if (read_matching_records(f, idx, codes, ncode, &length, &timestamps,
+        &markers, &extra) != 0)
+    {
+        return NULL;
+    }
+
+    evt = malloc(sizeof (struct SMRMarkerChannel));
+
+    evt->length = length;
+    evt->timestamps = timestamps;
+    evt->markers = markers;
+
+    if (chdr->kind == TEXT_MARKER_CHANNEL)
+    {
+        evt->npt = chdr->nextra / sizeof (uint8_t);
+        evt->text = extra;
+    }
+    else
+    {
+        /*same zeroed 1 char text as read_marker_channel*/
+        evt->npt = 1;
+        evt->text = calloc(length > 0 ? length : 1, sizeof (uint8_t));
+    }
+
+    return evt;
+}
+/* =============================================================================
+BUFFER FILL FUNCTIONS
+============================================================================= */
+/*these decode a channel straight into storage owned by the caller (e.g. the
+  data of an mxArray or a memory map), sized up front from channel_item_count,
+  so nothing the size of the channel is allocated on top of the output.
+  all return 0 on success*/
+
+/*bytes of block payload staged at a time by the fills that convert records
+  as they are read*/
+#define FILL_STAGE_SIZE (4<<20)
+/* -------------------------------------------------------------------------- */
+/*header of channel <idx> if its kind is in [<lo>, <hi>], NULL otherwise*/
+static struct SMRChannelHeader *fill_channel_header(struct SMRFile *f,
+    int idx, uint8_t lo, uint8_t hi, const char *what)
+{
+    struct SMRChannelHeader *chdr;
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind < lo || chdr->kind > hi)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not %s channel", chdr->index, chdr->title, what);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    return chdr;
+}
+/* -------------------------------------------------------------------------- */
+/*block headers of the waveform channel <idx> of <kind> (CONTINUOUS_CHANNEL
+  or REAL_WAVE_CHANNEL), which must be sampled in a single frame*/
+static struct SMRBlockHeaderArray *fill_waveform_blocks(struct SMRFile *f,
+    int idx, uint8_t kind, struct SMRChannelHeader **chdr)
+{
+    struct SMRBlockHeaderArray *bhdr;
+
+    if ((*chdr = fill_channel_header(f, idx, kind, kind,
+        kind == CONTINUOUS_CHANNEL ? "a continuous" : "a real wave")) == NULL)
+    {
+        return NULL;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (count_frames(bhdr, channel_sample_interval(f->fhdr, *chdr)) != 1)
+    {
+        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+        return NULL;
+    }
+
+    return bhdr;
+}
+/* -------------------------------------------------------------------------- */
+/*bytes of extra data per record of a marker kind channel*/
+static size_t marker_extra_size(struct SMRChannelHeader *chdr)
+{
+    /*plain markers carry nothing past the marker codes*/
+    return chdr->kind == MARKER_CHANNEL ? 0 : (size_t) chdr->nextra;
+}
+/* -------------------------------------------------------------------------- */
+/*size of a staging buffer that holds at least the largest block of <bhdr>*/
+static size_t fill_stage_size(struct SMRBlockHeaderArray *bhdr,
+    size_t record_size)
+{
+    size_t nbyte = FILL_STAGE_SIZE;
+    uint64_t k;
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        if ((size_t) bhdr->hdr[k].nitem * record_size > nbyte)
+        {
+            nbyte = (size_t) bhdr->hdr[k].nitem * record_size;
+        }
+    }
+
+    return nbyte;
+}
+/* -------------------------------------------------------------------------- */
+/*read the payloads of as many blocks from bhdr->hdr[*next] on as fit in
+  <nbyte> bytes of <stage> (at least one), advancing <*next>. returns the #
+  of items read or -1 on failure*/
+static int64_t read_block_batch(struct SMRFile *f,
+    struct SMRBlockHeaderArray *bhdr, uint64_t *next, size_t record_size,
+    uint8_t *stage, size_t nbyte)
+{
+    struct SMRBlockHeaderArray batch;
+    uint64_t nitem = 0;
+    uint64_t k;
+
+    for (k = *next; k < bhdr->length; ++k)
+    {
+        if ((nitem + (uint64_t) bhdr->hdr[k].nitem) * record_size > nbyte)
+        {
+            break;
+        }
+
+        nitem += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    batch.length = (unsigned int) (k - *next);
+    batch.hdr = bhdr->hdr + *next;
+
+    *next = k;
+
+    if (read_block_payloads(f, &batch, record_size, stage) != 0)
+    {
+        return -1;
+    }
+
+    return (int64_t) nitem;
+}
+/* -------------------------------------------------------------------------- */
+/*# of items (samples, events or records) in channel <idx>, 0 on failure*/
+uint64_t channel_item_count(struct SMRFile *f, int idx)
+{
+    struct SMRBlockHeaderArray *bhdr;
+    uint64_t nitem = 0;
+    uint64_t k;
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return 0;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        nitem += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    return nitem;
+}
+/* -------------------------------------------------------------------------- */
+/*bytes of extra data per record of marker kind channel <idx> (wavemark
+  samples, floats or text, 0 for plain markers), i.e. the per record size of
+  the <extra> field of read_marker_records_into. -1 for other kinds*/
+int64_t channel_extra_size(struct SMRFile *f, int idx)
+{
+    struct SMRChannelHeader *chdr;
+
+    if ((chdr = fill_channel_header(f, idx, MARKER_CHANNEL,
+        TEXT_MARKER_CHANNEL, "a marker")) == NULL)
+    {
+        return -1;
+    }
+
+    return (int64_t) marker_extra_size(chdr);
+}
+/* -------------------------------------------------------------------------- */
+/*the raw int16 samples of continuous channel <idx>*/
+int read_continuous_channel_into(struct SMRFile *f, int idx, int16_t *dest)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr;
+    double mark[2];
+    int status;
+
+    if ((bhdr = fill_waveform_blocks(f, idx, CONTINUOUS_CHANNEL, &chdr)) == NULL)
+    {
+        return -1;
+    }
+
+    start_decode_timer(f, mark);
+
+    status = read_block_payloads(f, bhdr, sizeof (int16_t), (uint8_t *) dest);
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    return status;
+}
+/* -------------------------------------------------------------------------- */
+/*shared body of the scaled continuous fills, <single> selects float output*/
+static int fill_continuous_scaled(struct SMRFile *f, int idx, void *dest,
+    int single)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr;
+
+    int16_t *stage;
+    size_t nbyte;
+    uint64_t next = 0;
+    uint64_t inc = 0;
+    int64_t nitem;
+    int64_t k;
+    double scale, offset;
+    double mark[2];
+    int status = 0;
+
+    if ((bhdr = fill_waveform_blocks(f, idx, CONTINUOUS_CHANNEL, &chdr)) == NULL)
+    {
+        return -1;
+    }
+
+    /*volts = (data * (scale / 6553.6)) + offset*/
+    scale = (double) chdr->scale / 6553.6;
+    offset = (double) chdr->offset;
+
+    nbyte = fill_stage_size(bhdr, sizeof (int16_t));
+    stage = malloc(nbyte);
+
+    start_decode_timer(f, mark);
+
+    while (next < bhdr->length)
+    {
+        if ((nitem = read_block_batch(f, bhdr, &next, sizeof (int16_t),
+            (uint8_t *) stage, nbyte)) < 0)
+        {
+            status = -1;
+            break;
+        }
+
+        if (single)
+        {
+            float *out = (float *) dest + inc;
+
+            for (k = 0; k < nitem; ++k)
+            {
+                out[k] = (float) ((double) stage[k] * scale + offset);
+            }
+        }
+        else
+        {
+            double *out = (double *) dest + inc;
+
+            for (k = 0; k < nitem; ++k)
+            {
+                out[k] = (double) stage[k] * scale + offset;
+            }
+        }
+
+        inc += (uint64_t) nitem;
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    free(stage);
+
+    return status;
+}
+/* -------------------------------------------------------------------------- */
+/*the samples of continuous channel <idx> in volts*/
+int read_continuous_channel_scaled(struct SMRFile *f, int idx, double *dest)
+{
+    return fill_continuous_scaled(f, idx, dest, 0);
+}
+/* -------------------------------------------------------------------------- */
+int read_continuous_channel_scaled_single(struct SMRFile *f, int idx,
+    float *dest)
+{
+    return fill_continuous_scaled(f, idx, dest, 1);
+}
+/* -------------------------------------------------------------------------- */
+/*the event times (in seconds) of event channel <idx>*/
+int read_event_channel_into(struct SMRFile *f, int idx, double *dest)
+{
+    struct SMRBlockHeaderArray *bhdr;
+    uint8_t *ticks;
+    uint64_t nitem;
+    uint64_t k;
+    int32_t buf;
+    double mark[2];
+
+    if (fill_channel_header(f, idx, EVENT_2_CHANNEL, EVENT_4_CHANNEL,
+        "an event") == NULL)
+    {
+        return -1;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return -1;
+    }
+
+    nitem = channel_item_count(f, idx);
+
+    /*the 4 byte ticks are read into the upper half of <dest> and widened in
+      place: writing element k never reaches a tick past k, so no scratch
+      buffer is needed. memcpy keeps the mixed type access well defined*/
+    ticks = (uint8_t *) dest + nitem * sizeof (int32_t);
+
+    start_decode_timer(f, mark);
+
+    if (read_block_payloads(f, bhdr, sizeof (int32_t), ticks) != 0)
+    {
+        fprintf(stderr, "ERROR: failed to read channel data\n");
+        return -1;
+    }
+
+    for (k = 0; k < nitem; ++k)
+    {
+        memcpy(&buf, ticks + k * sizeof (int32_t), sizeof (int32_t));
+        dest[k] = ticks_to_seconds(f->fhdr, buf);
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*where read_marker_records_into puts the fields of each record, any of
+  <timestamps>, <markers> or <extra> may be NULL*/
+struct RecordDest
+{
+    double *timestamps;
+    uint8_t *markers;
+    uint8_t *extra;
+    size_t nextra;
+    double uspertime;
+    double dtimebase;
+};
+/* -------------------------------------------------------------------------- */
+/*decodes <n> staged records into record <inc> on of <d>*/
+typedef void (*RecordDecoder)(const uint8_t *, int64_t, struct RecordDest *,
+    uint64_t);
+
+/*defines a decoder for records of <NEXTRA> extra bytes that fills all three
+  fields, with <NEXTRA> a constant the record stride and copies are fixed size
+  (i.e. plain moves) and no field test is left in the loop*/
+#define DEFINE_RECORD_DECODER(name, NEXTRA)                                    \
+static void name(const uint8_t *src, int64_t n, struct RecordDest *d,          \
+    uint64_t inc)                                                              \
+{                                                                              \
+    const size_t record_size = sizeof (int32_t) + MARKER_SIZE + (NEXTRA);      \
+    double *ts = d->timestamps + inc;                                          \
+    uint8_t *mrk = d->markers + inc * MARKER_SIZE;                             \
+    uint8_t *ext = (NEXTRA) > 0 ? d->extra + inc * (NEXTRA) : NULL;            \
+    int32_t buf;                                                               \
+    int64_t k;                                                                 \
+                                                                               \
+    for (k = 0; k < n; ++k, src += record_size)                                \
+    {                                                                          \
+        memcpy(&buf, src, sizeof (int32_t));                                   \
+        ts[k] = (double) buf * d->uspertime * d->dtimebase;                    \
+        memcpy(mrk + k * MARKER_SIZE, src + sizeof (int32_t), MARKER_SIZE);    \
+        if ((NEXTRA) > 0)                                                      \
+        {                                                                      \
+            memcpy(ext + k * (NEXTRA), src + sizeof (int32_t) + MARKER_SIZE,   \
+                (NEXTRA));                                                     \
+        }                                                                      \
+    }                                                                          \
+}
+
+/*plain markers and wavemarks of 32 and 64 samples*/
+DEFINE_RECORD_DECODER(decode_records_0, 0)
+DEFINE_RECORD_DECODER(decode_records_64, 64)
+DEFINE_RECORD_DECODER(decode_records_128, 128)
+
+/* -------------------------------------------------------------------------- */
+/*any layout and any subset of the fields*/
+static void decode_records(const uint8_t *src, int64_t n, struct RecordDest *d,
+    uint64_t inc)
+{
+    const size_t record_size = sizeof (int32_t) + MARKER_SIZE + d->nextra;
+    int32_t buf;
+    int64_t k;
+
+    for (k = 0; k < n; ++k, ++inc, src += record_size)
+    {
+        if (d->timestamps != NULL)
+        {
+            memcpy(&buf, src, sizeof (int32_t));
+
+            /*convert time in ticks to seconds*/
+            d->timestamps[inc] = (double) buf * d->uspertime * d->dtimebase;
+        }
+
+        if (d->markers != NULL)
+        {
+            memcpy(d->markers + inc * MARKER_SIZE, src + sizeof (int32_t),
+                MARKER_SIZE);
+        }
+
+        if (d->extra != NULL)
+        {
+            memcpy(d->extra + inc * d->nextra,
+                src + sizeof (int32_t) + MARKER_SIZE, d->nextra);
+        }
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*the decoder specialized for the layout and fields of <d>, if any*/
+static RecordDecoder select_record_decoder(struct RecordDest *d)
+{
+    if (d->timestamps == NULL || d->markers == NULL ||
+        (d->extra == NULL && d->nextra > 0))
+    {
+        return decode_records;
+    }
+
+    switch (d->nextra)
+    {
+        case 0:   return decode_records_0;
+        case 64:  return decode_records_64;
+        case 128: return decode_records_128;
+        default:  return decode_records;
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*the records of a marker kind channel (MARKER_CHANNEL through
+  TEXT_MARKER_CHANNEL): <timestamps> in seconds, MARKER_SIZE <markers> and
+  the nextra bytes of <extra> (wavemark samples, floats or text) per record.
+  any of the three may be NULL to skip that field*/
+int read_marker_records_into(struct SMRFile *f, int idx, double *timestamps,
+    uint8_t *markers, uint8_t *extra)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr;
+    struct RecordDest dest;
+    RecordDecoder decode;
+
+    uint8_t *stage;
+    size_t record_size;
+    size_t nbyte;
+    uint64_t next = 0;
+    uint64_t inc = 0;
+    int64_t nitem;
+    double mark[2];
+    int status = 0;
+
+    if ((chdr = fill_channel_header(f, idx, MARKER_CHANNEL,
+        TEXT_MARKER_CHANNEL, "a marker")) == NULL)
+    {
+        return -1;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return -1;
+    }
+
+    dest.timestamps = timestamps;
+    dest.markers = markers;
+    dest.extra = extra;
+
+    /*each record is: 4 byte tick, 4 marker bytes, <nextra> bytes*/
+    dest.nextra = marker_extra_size(chdr);
+    dest.uspertime = (double) f->fhdr->uspertime;
+    dest.dtimebase = f->fhdr->dtimebase;
+
+    record_size = sizeof (int32_t) + MARKER_SIZE + dest.nextra;
+    decode = select_record_decoder(&dest);
+
+    nbyte = fill_stage_size(bhdr, record_size);
+    stage = malloc(nbyte);
+
+    start_decode_timer(f, mark);
+
+    while (next < bhdr->length)
+    {
+        if ((nitem = read_block_batch(f, bhdr, &next, record_size, stage,
+            nbyte)) < 0)
+        {
+            status = -1;
+            break;
+        }
+
+        decode(stage, nitem, &dest, inc);
+
+        inc += (uint64_t) nitem;
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    free(stage);
+
+    if (status != 0)
+    {
+        fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+    }
+
+    return status;
+}
+/* -------------------------------------------------------------------------- */
+/*called with the <n> records of <record_size> bytes at <src>, returns 0 to
+  keep going or -1 to stop*/
+typedef int (*RecordVisitor)(const uint8_t *, int64_t, size_t, void *);
+
+/*hand the payloads of the blocks of <bhdr> to <visit> in order. payloads are
+  visited in place in a memory map of the file where possible (not with
+  SMR_IO_DIRECT, which is meant to bypass the page cache), so bytes <visit>
+  does not look at are never copied, otherwise they are staged a few MB of
+  blocks at a time*/
+static int visit_record_payloads(struct SMRFile *f,
+    struct SMRBlockHeaderArray *bhdr, size_t record_size, RecordVisitor visit,
+    void *ctx)
+{
+    struct SMRMap *map = NULL;
+
+    uint8_t *stage;
+    size_t nbyte;
+    uint64_t next = 0;
+    uint64_t k;
+    int64_t offset;
+    int64_t nitem;
+    double mark[2];
+    int status = 0;
+
+    if (!(f->flags & SMR_IO_DIRECT))
+    {
+        map = map_file(f->fp, f->stamp.size);
+    }
+
+    start_decode_timer(f, mark);
+
+    if (map != NULL)
+    {
+        for (k = 0; k < bhdr->length && status == 0; ++k)
+        {
+            offset = (int64_t) bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE;
+            nitem = (int64_t) bhdr->hdr[k].nitem;
+
+            if (offset < 0 || nitem < 0 ||
+                (uint64_t) offset + (uint64_t) nitem * record_size > map->size)
+            {
+                status = -1;
+                break;
+            }
+
+            /*the pages of a visited block are faulted in as it is walked,
+              so it counts as one read of all of its records*/
+            if (f->stats != NULL)
+            {
+                f->stats->bytes_read += (uint64_t) nitem * record_size;
+                ++f->stats->nread;
+            }
+
+            status = visit(map->base + offset, nitem, record_size, ctx);
+        }
+
+        unmap_file(map);
+    }
+    else
+    {
+        nbyte = fill_stage_size(bhdr, record_size);
+        stage = malloc(nbyte);
+
+        while (next < bhdr->length && status == 0)
+        {
+            if ((nitem = read_block_batch(f, bhdr, &next, record_size, stage,
+                nbyte)) < 0)
+            {
+                status = -1;
+                break;
+            }
+
+            status = visit(stage, nitem, record_size, ctx);
+        }
+
+        free(stage);
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    return status;
+}
+/* -------------------------------------------------------------------------- */
+/*copy the leading tick of each of the <n> records of <record_size> bytes at
+  <src> to the int32_t * at <ctx>, advancing it*/
+static int gather_ticks(const uint8_t *src, int64_t n, size_t record_size,
+    void *ctx)
+{
+    int32_t **dest = ctx;
+    int64_t k;
+
+    for (k = 0; k < n; ++k, src += record_size)
+    {
+        memcpy(*dest + k, src, sizeof (int32_t));
+    }
+
+    *dest += n;
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*the raw ticks of the records of a marker kind channel, only the tick of each
+  record is touched (see visit_record_payloads)*/
+int read_marker_ticks_into(struct SMRFile *f, int idx, int32_t *dest)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr;
+
+    size_t record_size;
+
+    if ((chdr = fill_channel_header(f, idx, MARKER_CHANNEL,
+        TEXT_MARKER_CHANNEL, "a marker")) == NULL)
+    {
+        return -1;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return -1;
+    }
+
+    record_size = sizeof (int32_t) + MARKER_SIZE + marker_extra_size(chdr);
+
+    if (visit_record_payloads(f, bhdr, record_size, gather_ticks, &dest) != 0)
+    {
+        fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+        return -1;
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*the times (in seconds) of the records of a marker kind channel, see
+  read_marker_ticks_into*/
+int read_marker_timestamps_into(struct SMRFile *f, int idx, double *dest)
+{
+    uint8_t *ticks;
+    uint64_t nitem;
+    uint64_t k;
+    int32_t buf;
+
+    nitem = channel_item_count(f, idx);
+
+    /*same in place widening as read_event_channel_into*/
+    ticks = (uint8_t *) dest + nitem * sizeof (int32_t);
+
+    if (read_marker_ticks_into(f, idx, (int32_t *) ticks) != 0)
+    {
+        return -1;
+    }
+
+    for (k = 0; k < nitem; ++k)
+    {
+        memcpy(&buf, ticks + k * sizeof (int32_t), sizeof (int32_t));
+        dest[k] = ticks_to_seconds(f->fhdr, buf);
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*state of read_matching_records: records whose unit code (first marker byte)
+  is set in <keep> are appended to the fields of <dest>*/
+struct MatchState
+{
+    struct RecordDest dest;
+    uint8_t keep[256];
+    uint64_t length;
+    uint64_t capacity;
+    uint64_t total;
+};
+/* -------------------------------------------------------------------------- */
+/*double the capacity of the fields of <m>, never past the channel length*/
+static void grow_match_state(struct MatchState *m)
+{
+    struct RecordDest *d = &m->dest;
+
+    m->capacity = m->capacity > 0 ? m->capacity * 2 : 1024;
+
+    if (m->capacity > m->total)
+    {
+        m->capacity = m->total;
+    }
+
+    d->timestamps = realloc(d->timestamps, sizeof (double) * m->capacity);
+    d->markers = realloc(d->markers, MARKER_SIZE * m->capacity);
+
+    if (d->nextra > 0)
+    {
+        d->extra = realloc(d->extra, d->nextra * m->capacity);
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*the record visitor of read_matching_records, <ctx> is a struct MatchState*/
+static int decode_matching(const uint8_t *src, int64_t n, size_t record_size,
+    void *ctx)
+{
+    struct MatchState *m = ctx;
+    struct RecordDest *d = &m->dest;
+    int32_t buf;
+    int64_t k;
+
+    for (k = 0; k < n; ++k, src += record_size)
+    {
+        if (!m->keep[src[sizeof (int32_t)]])
+        {
+            continue;
+        }
+
+        if (m->length == m->capacity)
+        {
+            grow_match_state(m);
+        }
+
+        memcpy(&buf, src, sizeof (int32_t));
+        d->timestamps[m->length] = (double) buf * d->uspertime * d->dtimebase;
+
+        memcpy(d->markers + m->length * MARKER_SIZE, src + sizeof (int32_t),
+            MARKER_SIZE);
+
+        if (d->nextra > 0)
+        {
+            memcpy(d->extra + m->length * d->nextra,
+                src + sizeof (int32_t) + MARKER_SIZE, d->nextra);
+        }
+
+        ++m->length;
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*the records of marker kind channel <idx> whose unit code (markers[0]) is one
+  of the <ncode> <codes>, filtered as the blocks are decoded so that rejected
+  records are never copied (see visit_record_payloads). on success the
+  <*length> matches are in newly allocated <*timestamps>, <*markers> and
+  <*extra> (NULL for plain markers) that the caller frees*/
+static int read_matching_records(struct SMRFile *f, int idx,
+    const uint8_t *codes, int ncode, uint64_t *length, double **timestamps,
+    uint8_t **markers, uint8_t **extra)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr;
+    struct MatchState m;
+
+    size_t record_size;
+    uint64_t n;
+    int k;
+
+    if (ncode < 0 || (ncode > 0 && codes == NULL))
+    {
+        fprintf(stderr, "ERROR: invalid marker code set\n");
+        return -1;
+    }
+
+    if ((chdr = fill_channel_header(f, idx, MARKER_CHANNEL,
+        TEXT_MARKER_CHANNEL, "a marker")) == NULL)
+    {
+        return -1;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return -1;
+    }
+
+    memset(&m, 0, sizeof (struct MatchState));
+
+    for (k = 0; k < ncode; ++k)
+    {
+        m.keep[codes[k]] = 1;
+    }
+
+    m.dest.nextra = marker_extra_size(chdr);
+    m.dest.uspertime = (double) f->fhdr->uspertime;
+    m.dest.dtimebase = f->fhdr->dtimebase;
+    m.total = channel_item_count(f, idx);
+
+    record_size = sizeof (int32_t) + MARKER_SIZE + m.dest.nextra;
+
+    if (visit_record_payloads(f, bhdr, record_size, decode_matching, &m) != 0)
+    {
+        fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+
+        free(m.dest.timestamps);
+        free(m.dest.markers);
+        free(m.dest.extra);
+
+        return -1;
+    }
+
+    /*trim to the matches (keeping the fields non-NULL when there are none)*/
+    n = m.length > 0 ? m.length : 1;
+
+    m.dest.timestamps = realloc(m.dest.timestamps, sizeof (double) * n);
+    m.dest.markers = realloc(m.dest.markers, MARKER_SIZE * n);
+
+    if (m.dest.nextra > 0)
+    {
+        m.dest.extra = realloc(m.dest.extra, m.dest.nextra * n);
+    }
+
+    *length = m.length;
+    *timestamps = m.dest.timestamps;
+    *markers = m.dest.markers;
+    *extra = m.dest.extra;
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*a block of one column of read_continuous_matrix*/
+struct MatrixBlock
+{
+    int64_t offset;
+    uint64_t row;
+    size_t nitem;
+    int column;
+};
+/* -------------------------------------------------------------------------- */
+static int compare_matrix_blocks(const void *a, const void *b)
+{
+    const struct MatrixBlock *x = a;
+    const struct MatrixBlock *y = b;
+
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+/* -------------------------------------------------------------------------- */
+/*the <nchan> continuous channels <idx> as the columns of the column major
+  <nrow> x <nchan> matrix <dest> of SMR_FILL_INT16 (raw), SMR_FILL_SINGLE or
+  SMR_FILL_DOUBLE (volts) samples. the blocks of all channels are read in a
+  single pass in file order, rows past the end of a shorter channel are left
+  as they are*/
+int read_continuous_matrix(struct SMRFile *f, const int *idx, int nchan,
+    void *dest, uint64_t nrow, int type)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr;
+    struct MatrixBlock *blocks = NULL;
+    struct BlockRead *reqs = NULL;
+
+    double *scale = NULL;
+    double *offset = NULL;
+    int16_t *stage = NULL;
+    uint64_t nblock = 0;
+    uint64_t row;
+    uint64_t k;
+    uint64_t j;
+    uint64_t n;
+    size_t nbyte = FILL_STAGE_SIZE;
+    size_t used;
+    size_t i;
+    double mark[2];
+    int status = -1;
+    int c;
+
+    if (type != SMR_FILL_INT16 && type != SMR_FILL_SINGLE &&
+        type != SMR_FILL_DOUBLE)
+    {
+        fprintf(stderr, "ERROR: invalid matrix sample type %d\n", type);
+        return -1;
+    }
+
+    scale = malloc(sizeof (double) * (nchan > 0 ? nchan : 1));
+    offset = malloc(sizeof (double) * (nchan > 0 ? nchan : 1));
+
+    for (c = 0; c < nchan; ++c)
+    {
+        if ((bhdr = fill_waveform_blocks(f, idx[c], CONTINUOUS_CHANNEL,
+            &chdr)) == NULL)
+        {
+            goto cleanup;
+        }
+
+        if (channel_item_count(f, idx[c]) > nrow)
+        {
+            fprintf(stderr, "ERROR: channel %d has more than %lu samples\n",
+                idx[c], (unsigned long) nrow);
+            goto cleanup;
+        }
+
+        /*volts = (data * (scale / 6553.6)) + offset*/
+        scale[c] = (double) chdr->scale / 6553.6;
+        offset[c] = (double) chdr->offset;
+
+        nblock += bhdr->length;
+    }
+
+    blocks = malloc(sizeof (struct MatrixBlock) * (nblock > 0 ? nblock : 1));
+    nblock = 0;
+
+    for (c = 0; c < nchan; ++c)
+    {
+        bhdr = get_block_header_array(f, idx[c]);
+
+        for (k = 0, row = 0; k < bhdr->length; ++k)
+        {
+            blocks[nblock].offset = (int64_t) bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE;
+            blocks[nblock].row = row;
+            blocks[nblock].nitem = (size_t) bhdr->hdr[k].nitem;
+            blocks[nblock].column = c;
+
+            if (blocks[nblock].nitem * sizeof (int16_t) > nbyte)
+            {
+                nbyte = blocks[nblock].nitem * sizeof (int16_t);
+            }
+
+            row += (uint64_t) bhdr->hdr[k].nitem;
+            ++nblock;
+        }
+    }
+
+    if (nblock > 0)
+    {
+        qsort(blocks, nblock, sizeof (struct MatrixBlock), compare_matrix_blocks);
+    }
+
+    reqs = malloc(sizeof (struct BlockRead) * (nblock > 0 ? nblock : 1));
+
+    /*raw samples are read straight into their column, scaled ones are
+      staged a few MB at a time and converted into it*/
+    if (type != SMR_FILL_INT16)
+    {
+        stage = malloc(nbyte);
+    }
+
+    start_decode_timer(f, mark);
+
+    for (k = 0; k < nblock; k += n)
+    {
+        used = 0;
+
+        for (n = 0; k + n < nblock; ++n)
+        {
+            struct MatrixBlock *b = blocks + k + n;
+
+            if (stage != NULL && n > 0 && used + b->nitem * sizeof (int16_t) > nbyte)
+            {
+                break;
+            }
+
+            reqs[n].offset = b->offset;
+            reqs[n].length = b->nitem * sizeof (int16_t);
+            reqs[n].dest = stage != NULL ? (uint8_t *) stage + used :
+                (uint8_t *) ((int16_t *) dest + (uint64_t) b->column * nrow + b->row);
+
+            used += reqs[n].length;
+        }
+
+        if (fetch_block_reads(f, reqs, (size_t) n) != 0)
+        {
+            fprintf(stderr, "ERROR: failed to read channel data\n");
+            goto cleanup;
+        }
+
+        for (j = 0; stage != NULL && j < n; ++j)
+        {
+            struct MatrixBlock *b = blocks + k + j;
+            int16_t *in = (int16_t *) reqs[j].dest;
+            uint64_t first = (uint64_t) b->column * nrow + b->row;
+
+            if (type == SMR_FILL_SINGLE)
+            {
+                float *out = (float *) dest + first;
+
+                for (i = 0; i < b->nitem; ++i)
+                {
+                    out[i] = (float) ((double) in[i] * scale[b->column] + offset[b->column]);
+                }
+            }
+            else
+            {
+                double *out = (double *) dest + first;
+
+                for (i = 0; i < b->nitem; ++i)
+                {
+                    out[i] = (double) in[i] * scale[b->column] + offset[b->column];
+                }
+            }
+        }
+    }
+
+    stop_decode_timer(f, mark, nblock);
+
+    status = 0;
+
+cleanup:
+    free(scale);
+    free(offset);
+    if (blocks) { free(blocks); }
+    if (reqs) { free(reqs); }
+    if (stage) { free(stage); }
+
+    return status;
+}
+/* =============================================================================
+CURSOR FUNCTIONS
+============================================================================= */
+/*walk a channel <chunk> items at a time through one staging buffer, so that
+  channels of any length are processed in constant memory*/
+struct SMRCursor *open_channel_cursor(const char *ifile, int idx,
+    uint64_t chunk)
+{
+    struct SMRFile *f;
+    struct SMRCursor *c;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) == NULL)
+    {
+        return NULL;
+    }
+
+    if ((c = open_channel_cursor_from_file(f, idx, chunk)) == NULL)
+    {
+        close_smr_file(f);
+        return NULL;
+    }
+
+    c->own_file = 1;
+
+    return c;
+}
+/* -------------------------------------------------------------------------- */
+/*<f> must stay open until the cursor is closed*/
+struct SMRCursor *open_channel_cursor_from_file(struct SMRFile *f, int idx,
+    uint64_t chunk)
+{
+    struct SMRChannelHeader *chdr;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRCursor *c;
+    size_t record_size = 0;
+
+    if (chunk == 0)
+    {
+        fprintf(stderr, "ERROR: cursor chunk size must be > 0\n");
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    switch (chdr->kind)
+    {
+        case CONTINUOUS_CHANNEL:
+        case REAL_WAVE_CHANNEL:
+            bhdr = fill_waveform_blocks(f, idx, chdr->kind, &chdr);
+            record_size = chdr->kind == CONTINUOUS_CHANNEL ? sizeof (int16_t) :
+                sizeof (float);
+            break;
+
+        case EVENT_2_CHANNEL:
+        case EVENT_3_CHANNEL:
+        case EVENT_4_CHANNEL:
+            bhdr = get_block_header_array(f, idx);
+            record_size = sizeof (int32_t);
+            break;
+
+        default:
+            fprintf(stderr, "ERROR: channels of type %d cannot be read with a cursor\n", chdr->kind);
+    }
+
+    if (bhdr == NULL)
+    {
+        return NULL;
+    }
+
+    c = malloc(sizeof (struct SMRCursor));
+
+    c->index = idx;
+    c->kind = chdr->kind;
+    c->chunk = chunk;
+    c->length = channel_item_count(f, idx);
+    c->position = 0;
+    c->sampling_rate = chdr->kind == CONTINUOUS_CHANNEL ||
+        chdr->kind == REAL_WAVE_CHANNEL ?
+        MICROSECONDS / channel_sample_interval(f->fhdr, chdr) : 0.0;
+
+    c->f = f;
+    c->own_file = 0;
+    c->bhdr = bhdr;
+    c->next = 0;
+    c->record_size = record_size;
+    c->nbyte = fill_stage_size(bhdr, record_size);
+    c->stage = malloc(c->nbyte);
+    c->nstage = 0;
+    c->pos = 0;
+
+    return c;
+}
+/* -------------------------------------------------------------------------- */
+/*copy the next (up to) c->chunk items into <dest>: int16 samples for
+  continuous, float samples for real wave and double times in seconds for
+  event channels. returns the # of items, 0 at the end of the channel or -1
+  on failure*/
+int64_t read_cursor_chunk(struct SMRCursor *c, void *dest)
+{
+    uint64_t first = c->next;
+    uint64_t out = 0;
+    uint64_t n;
+    uint64_t k;
+    int64_t nitem;
+    int32_t buf;
+    double mark[2];
+
+    start_decode_timer(c->f, mark);
+
+    while (out < c->chunk)
+    {
+        if (c->pos == c->nstage)
+        {
+            if (c->next == c->bhdr->length)
+            {
+                break;
+            }
+
+            if ((nitem = read_block_batch(c->f, c->bhdr, &c->next,
+                c->record_size, c->stage, c->nbyte)) < 0)
+            {
+                fprintf(stderr, "ERROR: failed to read data of channel %d\n", c->index);
+                return -1;
+            }
+
+            c->nstage = (uint64_t) nitem;
+            c->pos = 0;
+
+            continue;
+        }
+
+        n = c->nstage - c->pos < c->chunk - out ? c->nstage - c->pos :
+            c->chunk - out;
+
+        if (c->kind != CONTINUOUS_CHANNEL && c->kind != REAL_WAVE_CHANNEL)
+        {
+            /*event ticks are converted to seconds*/
+            for (k = 0; k < n; ++k)
+            {
+                memcpy(&buf, c->stage + (c->pos + k) * sizeof (int32_t), sizeof (int32_t));
+                ((double *) dest)[out + k] = ticks_to_seconds(c->f->fhdr, buf);
+            }
+        }
+        else
+        {
+            memcpy((uint8_t *) dest + out * c->record_size,
+                c->stage + c->pos * c->record_size, n * c->record_size);
+        }
+
+        c->pos += n;
+        out += n;
+    }
+
+    stop_decode_timer(c->f, mark, c->next - first);
+
+    c->position += out;
+
+    return (int64_t) out;
+}
+/* -------------------------------------------------------------------------- */
+/*start over at the first item of the channel*/
+void rewind_channel_cursor(struct SMRCursor *c)
+{
+    c->next = 0;
+    c->nstage = 0;
+    c->pos = 0;
+    c->position = 0;
+}
+/* -------------------------------------------------------------------------- */
+void close_channel_cursor(struct SMRCursor *c)
+{
+    if (c)
+    {
+        if (c->stage) { free(c->stage); }
+
+        if (c->own_file) { close_smr_file(c->f); }
+
+        free(c);
+    }
+}
+/* =============================================================================
+SUMMARY PYRAMID FUNCTIONS
+============================================================================= */
+/*path of the sidecar file that caches the summary of channel <idx>*/
+static char *summary_path(const char *ifile, int idx)
+{
+    size_t nchar = strlen(ifile) + 32;
+    char *path = malloc(sizeof (char) * nchar);
+
+    sprintf(path, "%s.%d.smrsum", ifile, idx);
+
+    return path;
+}
+/* -------------------------------------------------------------------------- */
+static struct SMRSummary *alloc_summary(unsigned int nlevel)
+{
+    struct SMRSummary *sum = malloc(sizeof (struct SMRSummary));
+
+    sum->nlevel = nlevel;
+    sum->level = calloc(nlevel, sizeof (struct SMRSummaryLevel));
+
+    return sum;
+}
+/* -------------------------------------------------------------------------- */
+static void alloc_summary_level(struct SMRSummaryLevel *lvl, uint64_t length,
+    uint64_t binsize)
+{
+    lvl->length = length;
+    lvl->binsize = binsize;
+    lvl->min = malloc(sizeof (int16_t) * length);
+    lvl->max = malloc(sizeof (int16_t) * length);
+    lvl->mean = malloc(sizeof (float) * length);
+}
+/* -------------------------------------------------------------------------- */
+static unsigned int count_summary_levels(uint64_t nsample)
+{
+    unsigned int nlevel = 1;
+    uint64_t nbin = (nsample + SUMMARY_BASE_BIN - 1) / SUMMARY_BASE_BIN;
+
+    while (nbin > 1)
+    {
+        nbin = (nbin + SUMMARY_FACTOR - 1) / SUMMARY_FACTOR;
+        ++nlevel;
+    }
+
+    return nlevel;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRSummary *build_continuous_summary(struct SMRFileHeader *fhdr,
+    struct SMRChannelHeader *chdr)
+{
+    struct SMRFile *f;
+    struct SMRSummary *sum = NULL;
+
+    if ((f = open_smr_file(fhdr->filepath, get_default_open_flags())) != NULL)
+    {
+        sum = build_continuous_summary_from_file(f, chdr->index);
+        close_smr_file(f);
+    }
+
+    return sum;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRSummary *build_continuous_summary_from_file(struct SMRFile *f,
+    int idx)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRSummary *sum = NULL;
+    struct SMRSummaryLevel *lvl;
+
+    double sample_interval;
+    uint64_t nsample = 0;
+    uint64_t nbin;
+    uint64_t bin = 0;
+    uint64_t count = 0;
+    uint64_t next = 0;
+    uint64_t k;
+    uint64_t j;
+    int64_t nitem;
+    size_t nbyte;
+    unsigned int l;
+    double mark[2];
+
+    int16_t *buffer = NULL;
+    int16_t cur_min = 0;
+    int16_t cur_max = 0;
+    double cur_sum = 0.0;
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != CONTINUOUS_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a continuous channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    sample_interval = channel_sample_interval(f->fhdr, chdr);
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (count_frames(bhdr, sample_interval) != 1)
+    {
+        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+        return NULL;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        nsample += (uint64_t) bhdr->hdr[k].nitem;
+    }
+
+    sum = alloc_summary(count_summary_levels(nsample));
+
+    sum->nsample = nsample;
+    sum->sampling_rate = MICROSECONDS / sample_interval;
+    sum->start_time = ticks_to_seconds(f->fhdr, bhdr->hdr[0].start_time);
+
+    nbin = (nsample + SUMMARY_BASE_BIN - 1) / SUMMARY_BASE_BIN;
+    alloc_summary_level(sum->level, nbin, SUMMARY_BASE_BIN);
+
+    nbyte = fill_stage_size(bhdr, sizeof (int16_t));
+    buffer = malloc(nbyte);
+
+    start_decode_timer(f, mark);
+
+    /*stream the blocks once, a batch at a time, reducing every
+      SUMMARY_BASE_BIN samples into a single level 0 bin*/
+    while (next < bhdr->length)
+    {
+        if ((nitem = read_block_batch(f, bhdr, &next, sizeof (int16_t),
+            (uint8_t *) buffer, nbyte)) < 0)
+        {
+            fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+
+            free_continuous_summary(sum);
+            sum = NULL;
+
+            goto cleanup;
+        }
+
+        for (j = 0; j < (uint64_t) nitem; ++j)
+        {
+            if (count == 0)
+            {
+                cur_min = buffer[j];
+                cur_max = buffer[j];
+                cur_sum = 0.0;
+            }
+            else if (buffer[j] < cur_min)
+            {
+                cur_min = buffer[j];
+            }
+            else if (buffer[j] > cur_max)
+            {
+                cur_max = buffer[j];
+            }
+
+            cur_sum += (double) buffer[j];
+
+            if (++count == SUMMARY_BASE_BIN)
+            {
+                sum->level[0].min[bin] = cur_min;
+                sum->level[0].max[bin] = cur_max;
+                sum->level[0].mean[bin] = (float) (cur_sum / (double) count);
+
+                ++bin;
+                count = 0;
+            }
+        }
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+    /*partial last bin*/
+    if (count > 0)
+    {
+        sum->level[0].min[bin] = cur_min;
+        sum->level[0].max[bin] = cur_max;
+        sum->level[0].mean[bin] = (float) (cur_sum / (double) count);
+    }
+
+    /*each coarser level reduces SUMMARY_FACTOR bins of the level below it,
+      means are weighted by the number of samples each bin covers*/
+    for (l = 1; l < sum->nlevel; ++l)
+    {
+        struct SMRSummaryLevel *src = sum->level + (l-1);
+
+        lvl = sum->level + l;
+        nbin = (src->length + SUMMARY_FACTOR - 1) / SUMMARY_FACTOR;
+
+        alloc_summary_level(lvl, nbin, src->binsize * SUMMARY_FACTOR);
+
+        for (k = 0; k < nbin; ++k)
+        {
+            uint64_t first = k * SUMMARY_FACTOR;
+            uint64_t last = first + SUMMARY_FACTOR;
+            double total = 0.0;
+            double n = 0.0;
+
+            if (last > src->length) { last = src->length; }
+
+            lvl->min[k] = src->min[first];
+            lvl->max[k] = src->max[first];
+
+            for (j = first; j < last; ++j)
+            {
+                uint64_t start = j * src->binsize;
+                uint64_t nj = (nsample - start) < src->binsize ? (nsample - start) : src->binsize;
+
+                if (src->min[j] < lvl->min[k]) { lvl->min[k] = src->min[j]; }
+                if (src->max[j] > lvl->max[k]) { lvl->max[k] = src->max[j]; }
+
+                total += (double) src->mean[j] * (double) nj;
+                n += (double) nj;
+            }
+
+            lvl->mean[k] = (float) (total / n);
+        }
+    }
+
+cleanup:
+    if (buffer) { free(buffer); }
+
+    return sum;
+}
+/* -------------------------------------------------------------------------- */
+static int write_summary_file(const char *path, struct SMRSummary *sum,
+    int idx, const struct SMRFileStamp *stamp)
+{
+    FILE *fp;
+    char *tmp;
+    unsigned int l;
+    int err;
+    uint32_t version = SUMMARY_VERSION;
+    int32_t index = (int32_t) idx;
+
+    /*written next to <path> and renamed into place (as write_index_file)*/
+    tmp = malloc(sizeof (char) * (strlen(path) + 64));
+    sprintf(tmp, "%s.%lu.%p", path, process_id(), (void *) sum);
+
+    if ((fp = open_file(tmp, FILE_WRITE_MODE)) == NULL)
+    {
+        free(tmp);
+        return -1;
+    }
+
+    fwrite(SUMMARY_MAGIC, sizeof (char), 8, fp);
+    fwrite(&version, sizeof (version), 1, fp);
+    fwrite(&index, sizeof (index), 1, fp);
+    fwrite(stamp, sizeof (struct SMRFileStamp), 1, fp);
+
+    fwrite(&sum->nsample, sizeof (sum->nsample), 1, fp);
+    fwrite(&sum->sampling_rate, sizeof (sum->sampling_rate), 1, fp);
+    fwrite(&sum->start_time, sizeof (sum->start_time), 1, fp);
+    fwrite(&sum->nlevel, sizeof (sum->nlevel), 1, fp);
+
+    for (l = 0; l < sum->nlevel; ++l)
+    {
+        struct SMRSummaryLevel *lvl = sum->level + l;
+
+        fwrite(&lvl->length, sizeof (lvl->length), 1, fp);
+        fwrite(&lvl->binsize, sizeof (lvl->binsize), 1, fp);
+        fwrite(lvl->min, sizeof (int16_t), lvl->length, fp);
+        fwrite(lvl->max, sizeof (int16_t), lvl->length, fp);
+        fwrite(lvl->mean, sizeof (float), lvl->length, fp);
+    }
+
+    err = ferror(fp);
+    err |= fclose(fp);
+
+    if (err != 0 || replace_file(tmp, path) != 0)
+    {
+        remove(tmp);
+        free(tmp);
+        return -1;
+    }
+
+    free(tmp);
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*load a cached summary, NULL if the sidecar is missing or was written for a
+  different version of the smr file*/
+static struct SMRSummary *read_summary_file(const char *path, int idx,
+    const struct SMRFileStamp *stamp)
+{
+    FILE *fp;
+    struct SMRSummary *sum = NULL;
+
+    char magic[8];
+    uint32_t version = 0;
+    int32_t index = 0;
+    struct SMRFileStamp fstamp;
+    uint64_t nsample = 0;
+    double sampling_rate = 0.0;
+    double start_time = 0.0;
+    unsigned int nlevel = 0;
+    unsigned int l;
+    uint64_t expected = SUMMARY_BASE_BIN;
+    size_t nread = 0;
+
+    if ((fp = open_file(path, FILE_READ_MODE)) == NULL)
+    {
+        return NULL;
+    }
+
+    nread += fread(magic, sizeof (char), 8, fp);
+    nread += fread(&version, sizeof (version), 1, fp);
+    nread += fread(&index, sizeof (index), 1, fp);
+    nread += fread(&fstamp, sizeof (struct SMRFileStamp), 1, fp);
+    nread += fread(&nsample, sizeof (nsample), 1, fp);
+    nread += fread(&sampling_rate, sizeof (sampling_rate), 1, fp);
+    nread += fread(&start_time, sizeof (start_time), 1, fp);
+    nread += fread(&nlevel, sizeof (nlevel), 1, fp);
+
+    if (nread != 15 || memcmp(magic, SUMMARY_MAGIC, 8) != 0 ||
+        version != SUMMARY_VERSION || index != idx ||
+        !same_file_stamp(&fstamp, stamp) ||
+        nlevel != count_summary_levels(nsample))
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    sum = alloc_summary(nlevel);
+
+    sum->nsample = nsample;
+    sum->sampling_rate = sampling_rate;
+    sum->start_time = start_time;
+
+    for (l = 0; l < nlevel; ++l)
+    {
+        uint64_t length = 0;
+        uint64_t binsize = 0;
+
+        nread = fread(&length, sizeof (length), 1, fp);
+        nread += fread(&binsize, sizeof (binsize), 1, fp);
+
+        /*the layout of every level follows from <nsample>, anything else is
+          a truncated or foreign file*/
+        if (nread != 2 || binsize != expected ||
+            length != (nsample + binsize - 1) / binsize)
+        {
+            free_continuous_summary(sum);
+            sum = NULL;
+            break;
+        }
+
+        alloc_summary_level(sum->level + l, length, binsize);
+
+        nread = fread(sum->level[l].min, sizeof (int16_t), length, fp);
+        nread += fread(sum->level[l].max, sizeof (int16_t), length, fp);
+        nread += fread(sum->level[l].mean, sizeof (float), length, fp);
+
+        if (nread != 3 * length)
+        {
+            free_continuous_summary(sum);
+            sum = NULL;
+            break;
+        }
+
+        expected *= SUMMARY_FACTOR;
+    }
+
+    fclose(fp);
+
+    return sum;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRSummary *read_continuous_summary(const char *ifile, int idx,
+    int use_cache)
+{
+    struct SMRFile *f = NULL;
+    struct SMRSummary *sum = NULL;
+
+    char *path = NULL;
+    struct SMRFileStamp stamp;
+
+    if (idx < 0)
     {
         printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
         goto cleanup;
     }
 
-    if ((fhdr = read_file_header(ifile)) == NULL)
+    if (use_cache)
+    {
+        if (get_file_stat(ifile, &stamp) != 0)
+        {
+            fprintf(stderr, "[ERROR]: failed to open file - %s\n", ifile);
+            goto cleanup;
+        }
+
+        path = summary_path(ifile, idx);
+
+        if ((sum = read_summary_file(path, idx, &stamp)) != NULL)
+        {
+            goto cleanup;
+        }
+    }
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) == NULL)
+    {
+        goto cleanup;
+    }
+
+    sum = build_continuous_summary_from_file(f, idx);
+
+    /*failing to write the cache (e.g. read-only data directory) is not an
+      error, the summary will just be rebuilt next time*/
+    if (sum != NULL && use_cache)
+    {
+        if (write_summary_file(path, sum, idx, &f->stamp) != 0)
+        {
+            fprintf(stderr, "WARNING: failed to write summary file - %s\n", path);
+        }
+    }
+
+cleanup:
+    if (path) { free(path); }
+    close_smr_file(f);
+
+    return sum;
+}
+/* -------------------------------------------------------------------------- */
+void free_continuous_summary(struct SMRSummary *sum)
+{
+    if (sum)
+    {
+        unsigned int l;
+
+        if (sum->level)
+        {
+            for (l = 0; l < sum->nlevel; ++l)
+            {
+                if (sum->level[l].min) { free(sum->level[l].min); }
+
+                if (sum->level[l].max) { free(sum->level[l].max); }
+
+                if (sum->level[l].mean) { free(sum->level[l].mean); }
+            }
+
+            free(sum->level);
+        }
+
+        free(sum);
+    }
+}
+/* -------------------------------------------------------------------------- */
+struct SMREnvelope *read_summary_window(struct SMRSummary *sum, double t0,
+    double t1, uint32_t npixel)
+{
+    struct SMREnvelope *env = NULL;
+    struct SMRSummaryLevel *lvl;
+
+    double s0;
+    double s1;
+    double spp;
+    uint64_t k;
+    uint64_t j;
+    unsigned int l;
+
+    /*window in (fractional) samples, clipped to the data*/
+    s0 = (t0 - sum->start_time) * sum->sampling_rate;
+    s1 = (t1 - sum->start_time) * sum->sampling_rate;
+
+    if (s0 < 0.0) { s0 = 0.0; }
+    if (s1 > (double) sum->nsample) { s1 = (double) sum->nsample; }
+
+    env = malloc(sizeof (struct SMREnvelope));
+
+    env->length = 0;
+    env->min = NULL;
+    env->max = NULL;
+    env->mean = NULL;
+
+    if (s1 <= s0 || npixel < 1)
+    {
+        env->t0 = t0;
+        env->dt = 0.0;
+
+        return env;
+    }
+
+    spp = (s1 - s0) / (double) npixel;
+
+    /*coarsest level whose bins still fit within a single pixel*/
+    lvl = sum->level;
+    for (l = 1; l < sum->nlevel; ++l)
+    {
+        if ((double) sum->level[l].binsize <= spp)
+        {
+            lvl = sum->level + l;
+        }
+    }
+
+    env->length = npixel;
+    env->t0 = sum->start_time + (s0 / sum->sampling_rate);
+    env->dt = spp / sum->sampling_rate;
+
+    env->min = malloc(sizeof (int16_t) * npixel);
+    env->max = malloc(sizeof (int16_t) * npixel);
+    env->mean = malloc(sizeof (float) * npixel);
+
+    for (k = 0; k < npixel; ++k)
+    {
+        double edge = s0 + (double) (k+1) * spp;
+        uint64_t first = (uint64_t) (s0 + (double) k * spp) / lvl->binsize;
+        uint64_t last = (uint64_t) edge;
+        double total = 0.0;
+        double n = 0.0;
+
+        /*bin holding the last sample that falls inside this pixel*/
+        if ((double) last < edge) { ++last; }
+        last = (last - 1) / lvl->binsize;
+
+        if (last >= lvl->length) { last = lvl->length - 1; }
+        if (last < first) { last = first; }
+
+        env->min[k] = lvl->min[first];
+        env->max[k] = lvl->max[first];
+
+        for (j = first; j <= last; ++j)
+        {
+            uint64_t start = j * lvl->binsize;
+            uint64_t nj = (sum->nsample - start) < lvl->binsize ? (sum->nsample - start) : lvl->binsize;
+
+            if (lvl->min[j] < env->min[k]) { env->min[k] = lvl->min[j]; }
+            if (lvl->max[j] > env->max[k]) { env->max[k] = lvl->max[j]; }
+
+            total += (double) lvl->mean[j] * (double) nj;
+            n += (double) nj;
+        }
+
+        env->mean[k] = (float) (total / n);
+    }
+
+    return env;
+}
+/* -------------------------------------------------------------------------- */
+void free_summary_window(struct SMREnvelope *env)
+{
+    if (env)
+    {
+        if (env->min) { free(env->min); }
+
+        if (env->max) { free(env->max); }
+
+        if (env->mean) { free(env->mean); }
+
+        free(env);
+    }
+}
+/* =============================================================================
+DECIMATION FUNCTIONS
+============================================================================= */
+struct SMRContChannel *read_continuous_channel_decimated(const char *ifile,
+    int idx, int factor)
+{
+    struct SMRFile *f = NULL;
+    struct SMRContChannel *chan = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        chan = read_continuous_channel_decimated_from_file(f, idx, factor);
+    }
+
+    close_smr_file(f);
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+/*low pass filter a continuous channel and keep every <factor>th sample,
+  streaming the blocks so that only the output and a window of a few filter
+  lengths are ever held in memory. the anti-alias filter is a linear phase
+  FIR (see smr_filter.h) that is only evaluated at the retained samples, so
+  the output is aligned with the input (output k is input k * factor). the
+  signal is extended with its first / last sample past either end*/
+struct SMRContChannel *read_continuous_channel_decimated_from_file(
+    struct SMRFile *f, int idx, int factor)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRContChannel *chan = NULL;
+
+    double sample_interval;
+    uint64_t nsample = 0;
+    uint64_t nout;
+    uint64_t out = 0;
+    uint64_t base = 0;
+    uint64_t next = 0;
+    uint64_t k;
+    int64_t nitem;
+    size_t max_item = 0;
+    size_t nbyte;
+    size_t p, m;
+    size_t half;
+    size_t ntap;
+    size_t fill = 0;
+    size_t j;
+    double mark[2];
+
+    int16_t *buffer = NULL;
+    int16_t *src;
+    float *window = NULL;
+    float *h = NULL;
+
+    if (factor < 1 || factor > DECIMATE_MAX_FACTOR)
+    {
+        fprintf(stderr, "ERROR: decimation factor %d is not in [1, %d]\n", factor, DECIMATE_MAX_FACTOR);
+        return NULL;
+    }
+    else if (factor == 1)
+    {
+        return read_continuous_channel_from_file(f, idx);
+    }
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != CONTINUOUS_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a continuous channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    sample_interval = channel_sample_interval(f->fhdr, chdr);
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (count_frames(bhdr, sample_interval) != 1)
+    {
+        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+        return NULL;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        nsample += (uint64_t) bhdr->hdr[k].nitem;
+
+        if ((size_t) bhdr->hdr[k].nitem > max_item)
+        {
+            max_item = (size_t) bhdr->hdr[k].nitem;
+        }
+    }
+
+    nout = (nsample + (uint64_t) factor - 1) / (uint64_t) factor;
+
+    chan = malloc(sizeof (struct SMRContChannel));
+
+    chan->length = nout;
+    chan->sampling_rate = MICROSECONDS / sample_interval / (double) factor;
+    chan->data = malloc(sizeof (int16_t) * nout);
+
+    if (nsample == 0)
+    {
+        return chan;
+    }
+
+    half = (size_t) DECIMATE_ZEROS * (size_t) factor;
+    ntap = 2 * half + 1;
+
+    h = lowpass_fir(0.5 * DECIMATE_CUTOFF / (double) factor, ntap);
+
+    /*<window> holds the padded input from padded sample <base> on, output
+      <out> is computed from padded samples [out*factor, out*factor + ntap)*/
+    window = malloc(sizeof (float) * (2 * ntap + max_item));
+
+    nbyte = fill_stage_size(bhdr, sizeof (int16_t));
+    buffer = malloc(nbyte);
+
+    start_decode_timer(f, mark);
+
+    /*blocks are fetched a batch at a time and fed through the window
+      <max_item> samples at a time*/
+    while (next < bhdr->length)
+    {
+        if ((nitem = read_block_batch(f, bhdr, &next, sizeof (int16_t),
+            (uint8_t *) buffer, nbyte)) < 0)
+        {
+            fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+
+            free_continuous_channel(chan);
+            chan = NULL;
+
+            goto cleanup;
+        }
+
+        for (p = 0; p < (size_t) nitem; p += m)
+        {
+            src = buffer + p;
+            m = (size_t) nitem - p < max_item ? (size_t) nitem - p : max_item;
+
+            if (fill == 0 && base == 0)
+            {
+                for (j = 0; j < half; ++j)
+                {
+                    window[fill++] = (float) src[0];
+                }
+            }
+
+            for (j = 0; j < m; ++j)
+            {
+                window[fill++] = (float) src[j];
+            }
+
+            while (out < nout && (out * factor) + ntap <= base + fill)
+            {
+                chan->data[out] = saturate_int16(fir_dot(h, window + (out * factor - base), ntap));
+                ++out;
+            }
+
+            /*drop the samples that no remaining output needs*/
+            j = (size_t) (out * factor - base);
+
+            if (j > fill)
+            {
+                j = fill;
+            }
+
+            memmove(window, window + j, sizeof (float) * (fill - j));
+
+            fill -= j;
+            base += j;
+        }
+    }
+
+    /*extend past the end with the last sample and finish the tail*/
+    for (j = 0; j < half && out < nout; ++j)
+    {
+        window[fill] = window[fill - 1];
+        ++fill;
+    }
+
+    while (out < nout)
+    {
+        chan->data[out] = saturate_int16(fir_dot(h, window + (out * factor - base), ntap));
+        ++out;
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+cleanup:
+    if (buffer) { free(buffer); }
+
+    if (window) { free(window); }
+
+    if (h) { free(h); }
+
+    return chan;
+}
+/* =============================================================================
+BAND-PASS FILTER FUNCTIONS
+============================================================================= */
+/*300 - 6000 Hz 4th order band-pass, filtered data only*/
+void default_filter_config(struct SMRFilterConfig *cfg)
+{
+    cfg->low = 300.0;
+    cfg->high = 6000.0;
+    cfg->order = 4;
+    cfg->threshold = 0.0;
+    cfg->dead_time = 0.001;
+    cfg->emit = SMR_EMIT_DATA;
+}
+/* -------------------------------------------------------------------------- */
+struct SMRFilteredChannel *read_filtered_channel(const char *ifile, int idx,
+    struct SMRFilterConfig *cfg)
+{
+    struct SMRFile *f = NULL;
+    struct SMRFilteredChannel *chan = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        chan = read_filtered_channel_from_file(f, idx, cfg);
+    }
+
+    close_smr_file(f);
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+/*append <t> to the crossing times of <chan>, growing the array as needed*/
+static void push_crossing(struct SMRFilteredChannel *chan, uint64_t *capacity,
+    double t)
+{
+    if (chan->ncrossing == *capacity)
+    {
+        *capacity = *capacity > 0 ? *capacity * 2 : 1024;
+        chan->crossings = realloc(chan->crossings, sizeof (double) * (*capacity));
+    }
+
+    chan->crossings[chan->ncrossing++] = t;
+}
+/* -------------------------------------------------------------------------- */
+/*band-pass filter a continuous channel and / or detect threshold crossings
+  of the filtered signal, block by block as the channel is read so that the
+  raw channel is never held in memory. the filter (and detector) state is
+  carried across block boundaries, the result is identical to filtering the
+  whole channel at once. this is a causal (single pass) filter, so the
+  filtered signal is delayed relative to the raw one*/
+struct SMRFilteredChannel *read_filtered_channel_from_file(struct SMRFile *f,
+    int idx, struct SMRFilterConfig *cfg)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRFilteredChannel *chan = NULL;
+    struct Biquad sections[SMR_MAX_FILTER_ORDER];
+
+    double sample_interval;
+    double nyquist;
+    double start_time;
+    double prev = 0.0;
+    uint64_t nsample = 0;
+    uint64_t capacity = 0;
+    uint64_t ptr = 0;
+    uint64_t dead = 0;
+    uint64_t last = 0;
+    uint64_t next = 0;
+    uint64_t k;
+    int64_t nitem;
+    size_t max_item = 0;
+    size_t nbyte;
+    size_t p, m;
+    size_t j;
+    int nsec = 0;
+    int crossed = 0;
+    double mark[2];
+
+    int16_t *buffer = NULL;
+    int16_t *src;
+    double *work = NULL;
+
+    if (cfg->order < 2 || cfg->order > SMR_MAX_FILTER_ORDER || (cfg->order % 2) != 0)
+    {
+        fprintf(stderr, "ERROR: filter order must be even and in [2, %d]\n", SMR_MAX_FILTER_ORDER);
+        return NULL;
+    }
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (chdr->kind != CONTINUOUS_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not a continuous channel", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return NULL;
+    }
+
+    sample_interval = channel_sample_interval(f->fhdr, chdr);
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (count_frames(bhdr, sample_interval) != 1)
+    {
+        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+        return NULL;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        nsample += (uint64_t) bhdr->hdr[k].nitem;
+
+        if ((size_t) bhdr->hdr[k].nitem > max_item)
+        {
+            max_item = (size_t) bhdr->hdr[k].nitem;
+        }
+    }
+
+    /*corners at or beyond Nyquist are not realizable and an empty band
+      would silently reject everything*/
+    nyquist = MICROSECONDS / sample_interval / 2.0;
+
+    if ((cfg->low > 0.0 && cfg->low >= nyquist) ||
+        (cfg->high > 0.0 && cfg->high >= nyquist) ||
+        (cfg->low > 0.0 && cfg->high > 0.0 && cfg->low >= cfg->high))
+    {
+        fprintf(stderr, "ERROR: invalid filter band [%f, %f] Hz, corners must satisfy 0 < low < high < %f\n",
+            cfg->low, cfg->high, nyquist);
+        return NULL;
+    }
+
+    chan = malloc(sizeof (struct SMRFilteredChannel));
+
+    chan->sampling_rate = MICROSECONDS / sample_interval;
+    chan->length = (cfg->emit & SMR_EMIT_DATA) ? nsample : 0;
+    chan->data = (cfg->emit & SMR_EMIT_DATA) ? malloc(sizeof (float) * nsample) : NULL;
+    chan->ncrossing = 0;
+    chan->crossings = NULL;
+
+    if (cfg->low > 0.0)
+    {
+        nsec += butterworth_sections(sections + nsec, cfg->order, cfg->low,
+            chan->sampling_rate, 1);
+    }
+
+    if (cfg->high > 0.0)
     {
-        goto cleanup;
+        nsec += butterworth_sections(sections + nsec, cfg->order, cfg->high,
+            chan->sampling_rate, 0);
     }
 
-    if ((chdr = read_channel_header(fhdr, idx)) == NULL)
+    start_time = bhdr->length > 0 ? ticks_to_seconds(f->fhdr, bhdr->hdr[0].start_time) : 0.0;
+    dead = (uint64_t) ceil(cfg->dead_time * chan->sampling_rate);
+
+    /*blocks are fetched a batch at a time and filtered <max_item> samples
+      at a time, the filter state carries over between pieces*/
+    nbyte = fill_stage_size(bhdr, sizeof (int16_t));
+    buffer = malloc(nbyte);
+    work = malloc(sizeof (double) * max_item);
+
+    start_decode_timer(f, mark);
+
+    while (next < bhdr->length)
     {
-        goto cleanup;
+        if ((nitem = read_block_batch(f, bhdr, &next, sizeof (int16_t),
+            (uint8_t *) buffer, nbyte)) < 0)
+        {
+            fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+
+            free_filtered_channel(chan);
+            chan = NULL;
+
+            goto cleanup;
+        }
+
+        for (p = 0; p < (size_t) nitem; p += m)
+        {
+            src = buffer + p;
+            m = (size_t) nitem - p < max_item ? (size_t) nitem - p : max_item;
+
+            if (ptr == 0)
+            {
+                biquad_settle(sections, nsec, (double) src[0]);
+            }
+
+            for (j = 0; j < m; ++j)
+            {
+                work[j] = (double) src[j];
+            }
+
+            biquad_filter(sections, nsec, work, m);
+
+            if (chan->data != NULL)
+            {
+                for (j = 0; j < m; ++j)
+                {
+                    chan->data[ptr + j] = (float) work[j];
+                }
+            }
+
+            if ((cfg->emit & SMR_EMIT_CROSSINGS) && cfg->threshold != 0.0)
+            {
+                for (j = 0; j < m; ++j)
+                {
+                    uint64_t s = ptr + j;
+                    int beyond = cfg->threshold < 0.0 ?
+                        work[j] <= cfg->threshold : work[j] >= cfg->threshold;
+                    int was_beyond = cfg->threshold < 0.0 ?
+                        prev <= cfg->threshold : prev >= cfg->threshold;
+
+                    if (s > 0 && beyond && !was_beyond && (!crossed || s - last >= dead))
+                    {
+                        push_crossing(chan, &capacity, start_time + (double) s * sample_interval / MICROSECONDS);
+
+                        last = s;
+                        crossed = 1;
+                    }
+
+                    prev = work[j];
+                }
+            }
+
+            ptr += (uint64_t) m;
+        }
+    }
+
+    stop_decode_timer(f, mark, bhdr->length);
+
+cleanup:
+    if (buffer) { free(buffer); }
+
+    if (work) { free(work); }
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+void free_filtered_channel(struct SMRFilteredChannel *s)
+{
+    if (s)
+    {
+        if (s->data) { free(s->data); }
+
+        if (s->crossings) { free(s->crossings); }
+
+        free(s);
+    }
+}
+/* =============================================================================
+SNIPPET FUNCTIONS
+============================================================================= */
+/*# of blocks fetched per read_block_payloads call*/
+#define SNIPPET_BATCH 256
+
+/*first sample of snippet <index>*/
+struct SnippetRef
+{
+    int64_t start;
+    uint64_t index;
+};
+/* -------------------------------------------------------------------------- */
+struct SMRWMrkChannel *read_continuous_snippets(const char *ifile, int idx,
+    const double *times, uint64_t n, double pre, double post)
+{
+    struct SMRFile *f = NULL;
+    struct SMRWMrkChannel *chan = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        chan = read_continuous_snippets_from_file(f, idx, times, n, pre, post);
+    }
+
+    close_smr_file(f);
+
+    return chan;
+}
+/* -------------------------------------------------------------------------- */
+static int compare_snippets(const void *a, const void *b)
+{
+    const struct SnippetRef *x = a;
+    const struct SnippetRef *y = b;
+
+    return (x->start > y->start) - (x->start < y->start);
+}
+/* -------------------------------------------------------------------------- */
+/*copy the parts of the <n> snippets of <npt> samples in <refs> (sorted by
+  start sample) that fall in the block holding samples [<b0>, <b0> + <nitem>)
+  to <dest> (snippet refs[r].index at dest + refs[r].index * npt). blocks can
+  be visited in any order*/
+static void copy_snippets(int16_t *dest, uint64_t npt, struct SnippetRef *refs,
+    uint64_t n, int64_t b0, size_t nitem, const int16_t *block)
+{
+    int64_t b1 = b0 + (int64_t) nitem;
+    int64_t lo, hi;
+    uint64_t first = 0;
+    uint64_t last = n;
+    uint64_t mid;
+    uint64_t r;
+
+    /*first snippet that ends after the block starts*/
+    while (first < last)
+    {
+        mid = first + (last - first) / 2;
+
+        if (refs[mid].start + (int64_t) npt <= b0)
+        {
+            first = mid + 1;
+        }
+        else
+        {
+            last = mid;
+        }
+    }
+
+    for (r = first; r < n && refs[r].start < b1; ++r)
+    {
+        lo = refs[r].start > b0 ? refs[r].start : b0;
+        hi = refs[r].start + (int64_t) npt < b1 ? refs[r].start + (int64_t) npt : b1;
+
+        memcpy(dest + (refs[r].index * npt) + (lo - refs[r].start),
+            block + (lo - b0), sizeof (int16_t) * (size_t) (hi - lo));
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*extract the samples from <pre> seconds before to <post> seconds after each
+  of the <n> <times> from a continuous channel, reading only the blocks that
+  hold them. the result is laid out like a wavemark channel: snippet k (for
+  times[k]) is wavemarks[k*npt, (k+1)*npt), its sample at index
+  round(pre * sampling rate) is the one nearest times[k]. samples that fall
+  outside of the recording are 0, markers are all 0*/
+struct SMRWMrkChannel *read_continuous_snippets_from_file(struct SMRFile *f,
+    int idx, const double *times, uint64_t n, double pre, double post)
+{
+    struct SMRChannelHeader *chdr = NULL;
+    struct SMRBlockHeaderArray *bhdr = NULL;
+    struct SMRWMrkChannel *chan = NULL;
+    struct SMRBlockHeaderArray batch;
+    struct SnippetRef *refs = NULL;
+
+    double sample_interval;
+    double start_time;
+    int64_t *first = NULL;
+    int64_t npre, npost;
+    uint64_t *need = NULL;
+    uint64_t nneed = 0;
+    uint64_t active = 0;
+    uint64_t k;
+    uint64_t j;
+    size_t max_item = 0;
+    size_t ptr;
+    double mark[2];
+
+    int16_t *buffer = NULL;
+
+    batch.hdr = NULL;
+
+    if (idx < 0)
+    {
+        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
+        return NULL;
+    }
+
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return NULL;
     }
 
     if (chdr->kind != CONTINUOUS_CHANNEL)
@@ -652,368 +5477,732 @@ struct SMRContChannel *read_continuous_channel(const char *ifile, int idx)
         sprintf(msg, "Channel [%d - %s] is not a continuous channel", chdr->index, chdr->title);
         fprintf(stderr, "ERROR: %s\n", msg);
 
-        goto cleanup;
+        return NULL;
+    }
+
+    sample_interval = channel_sample_interval(f->fhdr, chdr);
+
+    npre = (int64_t) llround(pre * MICROSECONDS / sample_interval);
+    npost = (int64_t) llround(post * MICROSECONDS / sample_interval);
+
+    if (npre < 0 || npost < 0 || npre + npost < 1)
+    {
+        fprintf(stderr, "ERROR: invalid snippet window [%f, %f]\n", -pre, post);
+        return NULL;
+    }
+
+    if ((bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return NULL;
+    }
+
+    if (count_frames(bhdr, sample_interval) != 1)
+    {
+        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+        return NULL;
+    }
+
+    chan = malloc(sizeof (struct SMRWMrkChannel));
+
+    chan->length = n;
+    chan->npt = (uint64_t) (npre + npost);
+    chan->timestamps = malloc(sizeof (double) * n);
+    chan->markers = calloc(n * MARKER_SIZE, sizeof (uint8_t));
+    chan->wavemarks = calloc(n * chan->npt, sizeof (int16_t));
+
+    if (n > 0)
+    {
+        memcpy(chan->timestamps, times, sizeof (double) * n);
+    }
+
+    if (n == 0 || bhdr->length == 0)
+    {
+        return chan;
     }
 
-    chan = read_continuous_channel_from_header(fhdr, chdr);
+    start_time = ticks_to_seconds(f->fhdr, bhdr->hdr[0].start_time);
+
+    /*snippets in order of their first sample, so that blocks can be visited
+      in file order and each one is read at most once*/
+    refs = malloc(sizeof (struct SnippetRef) * n);
+
+    for (k = 0; k < n; ++k)
+    {
+        refs[k].start = (int64_t) llround((times[k] - start_time) * MICROSECONDS / sample_interval) - npre;
+        refs[k].index = k;
+    }
+
+    qsort(refs, n, sizeof (struct SnippetRef), compare_snippets);
+
+    /*index of the first sample of every block, and the blocks that overlap
+      at least one snippet*/
+    first = malloc(sizeof (int64_t) * (bhdr->length + 1));
+    need = malloc(sizeof (uint64_t) * bhdr->length);
+
+    first[0] = 0;
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        first[k+1] = first[k] + (int64_t) bhdr->hdr[k].nitem;
+
+        while (active < n && refs[active].start + (int64_t) chan->npt <= first[k])
+        {
+            ++active;
+        }
+
+        if (active < n && refs[active].start < first[k+1] && bhdr->hdr[k].nitem > 0)
+        {
+            need[nneed++] = k;
+
+            if ((size_t) bhdr->hdr[k].nitem > max_item)
+            {
+                max_item = (size_t) bhdr->hdr[k].nitem;
+            }
+        }
+    }
+
+    batch.hdr = malloc(sizeof (struct SMRBlockHeader) * SNIPPET_BATCH);
+    buffer = malloc(sizeof (int16_t) * max_item * SNIPPET_BATCH);
+
+    start_decode_timer(f, mark);
+
+    for (k = 0; k < nneed; k += batch.length)
+    {
+        batch.length = (unsigned int) (nneed - k < SNIPPET_BATCH ? nneed - k : SNIPPET_BATCH);
+
+        for (j = 0; j < batch.length; ++j)
+        {
+            batch.hdr[j] = bhdr->hdr[need[k+j]];
+        }
+
+        if (read_block_payloads(f, &batch, sizeof (int16_t), (uint8_t *) buffer) != 0)
+        {
+            fprintf(stderr, "ERROR: failed to read data of channel %d\n", idx);
+
+            free_wavemark_channel(chan);
+            chan = NULL;
+
+            goto cleanup;
+        }
+
+        ptr = 0;
+
+        for (j = 0; j < batch.length; ++j)
+        {
+            copy_snippets(chan->wavemarks, chan->npt, refs, n, first[need[k+j]],
+                (size_t) batch.hdr[j].nitem, buffer + ptr);
+
+            ptr += (size_t) batch.hdr[j].nitem;
+        }
+    }
+
+    stop_decode_timer(f, mark, nneed);
 
 cleanup:
-    free_channel_header(chdr);
-    free_file_header(fhdr);
+    if (refs) { free(refs); }
+
+    if (first) { free(first); }
+
+    if (need) { free(need); }
+
+    if (batch.hdr) { free(batch.hdr); }
+
+    if (buffer) { free(buffer); }
 
     return chan;
 }
-/* ========================================================================== */
-struct SMRContChannel *read_continuous_channel_from_header(
-    struct SMRFileHeader *fhdr, struct SMRChannelHeader *chdr)
+/* =============================================================================
+EPOCH FUNCTIONS
+============================================================================= */
+/*the blocks fetched at once are limited to about this many bytes*/
+#define EPOCH_BATCH_SIZE (8 << 20)
+
+/*a trigger time and the trial it starts*/
+struct EpochTrigger
 {
-    struct SMRBlockHeaderArray *bhdr = NULL;
-    struct SMRContChannel *chan = NULL;
+    double time;
+    uint64_t trial;
+};
 
-    FILE *fp;
+/*an event that falls in the window of a trial, <slot> locates its marker and
+  waveform in the scratch arrays of its channel*/
+struct EpochHit
+{
+    uint64_t trial;
+    double time;
+    uint64_t slot;
+};
+
+/*a block to fetch and the channel (position in the request) it belongs to*/
+struct EpochBlock
+{
+    int64_t offset;
+    int channel;
+    uint64_t block;
+};
+
+/*per channel state while the blocks are visited*/
+struct EpochWork
+{
+    struct SMREpochChannel *out;
+    struct SMRBlockHeaderArray *bhdr;
+    size_t record_size;
+
+    /*continuous channels*/
+    struct SnippetRef *refs;
+    int64_t *first;
+
+    /*event and marker kind channels*/
+    struct EpochHit *hits;
+    uint64_t nhit;
+    uint64_t capacity;
+    uint8_t *markers;
+    int16_t *waves;
+};
+/* -------------------------------------------------------------------------- */
+struct SMREpochs *read_epochs(const char *ifile, const int *channels,
+    int nchannel, const double *triggers, uint64_t ntrial, double pre,
+    double post)
+{
+    struct SMRFile *f = NULL;
+    struct SMREpochs *ep = NULL;
+
+    if ((f = open_smr_file(ifile, get_default_open_flags())) != NULL)
+    {
+        ep = read_epochs_from_file(f, channels, nchannel, triggers, ntrial,
+            pre, post);
+    }
+
+    close_smr_file(f);
+
+    return ep;
+}
+/* -------------------------------------------------------------------------- */
+static int compare_epoch_triggers(const void *a, const void *b)
+{
+    const struct EpochTrigger *x = a;
+    const struct EpochTrigger *y = b;
+
+    return (x->time > y->time) - (x->time < y->time);
+}
+/* -------------------------------------------------------------------------- */
+static int compare_epoch_hits(const void *a, const void *b)
+{
+    const struct EpochHit *x = a;
+    const struct EpochHit *y = b;
+
+    if (x->trial != y->trial)
+    {
+        return (x->trial > y->trial) - (x->trial < y->trial);
+    }
+    else if (x->time != y->time)
+    {
+        return (x->time > y->time) - (x->time < y->time);
+    }
+
+    return (x->slot > y->slot) - (x->slot < y->slot);
+}
+/* -------------------------------------------------------------------------- */
+static int compare_epoch_blocks(const void *a, const void *b)
+{
+    const struct EpochBlock *x = a;
+    const struct EpochBlock *y = b;
+
+    return (x->offset > y->offset) - (x->offset < y->offset);
+}
+/* -------------------------------------------------------------------------- */
+/*index of the first of the <n> sorted triggers at or after time <t>*/
+static uint64_t first_trigger(struct EpochTrigger *trig, uint64_t n, double t)
+{
+    uint64_t first = 0;
+    uint64_t last = n;
+    uint64_t mid;
+
+    while (first < last)
+    {
+        mid = first + (last - first) / 2;
+
+        if (trig[mid].time < t)
+        {
+            first = mid + 1;
+        }
+        else
+        {
+            last = mid;
+        }
+    }
 
+    return first;
+}
+/* -------------------------------------------------------------------------- */
+/*set up the output and scratch state of channel <idx>, returns 0 on success*/
+static int init_epoch_work(struct SMRFile *f, struct EpochWork *w, int idx,
+    struct EpochTrigger *trig, uint64_t ntrial, double pre, double post)
+{
+    struct SMRChannelHeader *chdr = NULL;
     double sample_interval;
-    uint64_t nframe = 1;
+    double start_time;
+    int64_t npre, npost;
     uint64_t k;
-    int32_t tmp;
 
-    sample_interval = get_sample_interval(fhdr, chdr->index);
+    if ((chdr = get_channel_header(f, idx)) == NULL)
+    {
+        return -1;
+    }
+
+    if (chdr->kind == REAL_WAVE_CHANNEL || chdr->kind < CONTINUOUS_CHANNEL ||
+        chdr->kind > REAL_WAVE_CHANNEL)
+    {
+        char msg[80];
+        sprintf(msg, "Channel [%d - %s] is not supported for epochs", chdr->index, chdr->title);
+        fprintf(stderr, "ERROR: %s\n", msg);
+
+        return -1;
+    }
+
+    if ((w->bhdr = get_block_header_array(f, idx)) == NULL)
+    {
+        return -1;
+    }
+
+    w->out->index = idx;
+    w->out->kind = chdr->kind;
+
+    if (chdr->kind == CONTINUOUS_CHANNEL)
+    {
+        sample_interval = channel_sample_interval(f->fhdr, chdr);
+
+        if (count_frames(w->bhdr, sample_interval) != 1)
+        {
+            fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
+            return -1;
+        }
+
+        npre = (int64_t) llround(pre * MICROSECONDS / sample_interval);
+        npost = (int64_t) llround(post * MICROSECONDS / sample_interval);
+
+        w->record_size = sizeof (int16_t);
+        w->out->sampling_rate = MICROSECONDS / sample_interval;
+        w->out->npt = (uint64_t) (npre + npost);
+        w->out->data = calloc(w->out->npt * ntrial, sizeof (int16_t));
+
+        start_time = w->bhdr->length > 0 ? ticks_to_seconds(f->fhdr, w->bhdr->hdr[0].start_time) : 0.0;
+
+        w->refs = malloc(sizeof (struct SnippetRef) * ntrial);
+
+        for (k = 0; k < ntrial; ++k)
+        {
+            w->refs[k].start = (int64_t) llround((trig[k].time - start_time) * MICROSECONDS / sample_interval) - npre;
+            w->refs[k].index = trig[k].trial;
+        }
+
+        /*<trig> is sorted and rounding is monotonic, so <refs> is too*/
 
-    if ((bhdr = read_block_header_array(chdr)) == NULL)
+        w->first = malloc(sizeof (int64_t) * (w->bhdr->length + 1));
+        w->first[0] = 0;
+
+        for (k = 0; k < w->bhdr->length; ++k)
+        {
+            w->first[k+1] = w->first[k] + (int64_t) w->bhdr->hdr[k].nitem;
+        }
+    }
+    else if (chdr->kind <= EVENT_4_CHANNEL)
     {
-        goto cleanup;
+        w->record_size = sizeof (int32_t);
     }
-
-    /* count the number of frames? */
-    for (k = 0; k < bhdr->length-1; ++k)
+    else
     {
-        tmp = bhdr->hdr[k+1].start_time - bhdr->hdr[k].end_time;
+        w->record_size = sizeof (int32_t) + MARKER_SIZE + chdr->nextra;
 
-        if ((double)tmp > sample_interval) { ++nframe; }
+        if (chdr->kind == ADC_MARKER_CHANNEL)
+        {
+            w->out->npt = chdr->nextra / sizeof (int16_t);
+        }
     }
 
-    fp = open_file(fhdr->filepath, FILE_READ_MODE);
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*does block <k> of the channel overlap the window of any trial*/
+static int epoch_block_needed(struct SMRFile *f, struct EpochWork *w,
+    uint64_t k, struct EpochTrigger *trig, uint64_t ntrial, double pre,
+    double post)
+{
+    struct SMRBlockHeader *hdr = w->bhdr->hdr + k;
+    uint64_t first, last, mid;
+    int64_t npt = (int64_t) w->out->npt;
+    double start, end;
 
-    if (fp == NULL)
+    if (hdr->nitem < 1)
     {
-        fprintf(stderr, "ERROR: failed to open file - %s\n", fhdr->filepath);
-        goto cleanup;
+        return 0;
     }
 
-    rewind(fp);
-
-    chan = malloc(sizeof (struct SMRContChannel));
-
-    chan->sampling_rate = MICROSECONDS / sample_interval;
-
-    if (nframe == 1)
+    if (w->out->kind == CONTINUOUS_CHANNEL)
     {
-        /*NOTE: indicates continuous sampling */
-        uint64_t nsample = 0;
-
-        size_t ptr = 0;
-
-        for (k = 0; k < bhdr->length; ++k)
-        {
-            /*get total number of samples in the record*/
-            nsample += (uint64_t) bhdr->hdr[k].nitem;
-        }
-
-        chan->data = malloc(sizeof (int16_t) * nsample);
+        first = 0;
+        last = ntrial;
 
-        for (k = 0; k < bhdr->length; ++k)
+        while (first < last)
         {
-            fseek(fp, bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE, SEEK_SET);
+            mid = first + (last - first) / 2;
 
-            /*FIXME: this pointer opperation may not be kosher...*/
-            if ((ptr + (size_t) bhdr->hdr[k].nitem) <= (size_t) nsample)
+            if (w->refs[mid].start + npt <= w->first[k])
             {
-                ptr  += fread(chan->data + ptr, sizeof (int16_t), bhdr->hdr[k].nitem, fp);
+                first = mid + 1;
             }
             else
             {
-                fprintf(stderr, "WARNING: write extends beyond allocated area\n");
-                fclose(fp);
-                free(chan->data);
-
-                goto cleanup;
+                last = mid;
             }
         }
-        chan->length = nsample;
-    }
-    else
-    {
-        /*triggered sampling... what is this?*/
-        fprintf(stderr, "ERROR: triggered sampling is not yet supported!\n");
-        fclose(fp);
 
-        free_continuous_channel(chan);
-        chan = NULL;
-
-        goto cleanup;
+        return first < ntrial && w->refs[first].start < w->first[k+1];
     }
 
-    fclose(fp);
+    start = ticks_to_seconds(f->fhdr, hdr->start_time);
+    end = ticks_to_seconds(f->fhdr, hdr->end_time);
 
-cleanup:
-    free_block_header_array(bhdr);
+    first = first_trigger(trig, ntrial, start - post);
 
-    return chan;
+    return first < ntrial && trig[first].time <= end + pre;
 }
 /* -------------------------------------------------------------------------- */
-void free_continuous_channel(struct SMRContChannel *s)
+/*record the event at <t> (with marker / waveform <record>, if any) in the
+  window of every trial it falls in*/
+static void add_epoch_hits(struct EpochWork *w, double t, const uint8_t *record,
+    struct EpochTrigger *trig, uint64_t ntrial, double pre, double post)
 {
-    if (s)
+    uint64_t k = first_trigger(trig, ntrial, t - post);
+    uint64_t slot;
+
+    for (; k < ntrial && trig[k].time <= t + pre; ++k)
     {
-        if (s->data) { free(s->data); }
+        if (w->nhit == w->capacity)
+        {
+            w->capacity = w->capacity > 0 ? w->capacity * 2 : 1024;
+            w->hits = realloc(w->hits, sizeof (struct EpochHit) * w->capacity);
 
-        free(s);
-    }
-}
-/* ========================================================================== */
-struct SMREventChannel *read_event_channel(const char *ifile, int idx)
-{
-    struct SMRFileHeader *fhdr = NULL;
-    struct SMRChannelHeader *chdr = NULL;
-    struct SMRBlockHeaderArray *bhdr = NULL;
-    struct SMREventChannel *evt = NULL;
+            if (w->out->kind >= MARKER_CHANNEL)
+            {
+                w->markers = realloc(w->markers, MARKER_SIZE * w->capacity);
+            }
 
-    FILE *fp;
+            if (w->out->npt > 0)
+            {
+                w->waves = realloc(w->waves, sizeof (int16_t) * w->out->npt * w->capacity);
+            }
+        }
 
-    uint64_t nitem = 0ul;
-    uint64_t k;
+        slot = w->nhit++;
 
-    int32_t *buffer = NULL;
-    size_t ptr = 0;
+        w->hits[slot].trial = trig[k].trial;
+        w->hits[slot].time = t - trig[k].time;
+        w->hits[slot].slot = slot;
 
-    if (idx < 0)
-    {
-        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
-        goto cleanup;
-    }
+        if (w->out->kind >= MARKER_CHANNEL)
+        {
+            memcpy(w->markers + (slot * MARKER_SIZE), record + sizeof (int32_t), MARKER_SIZE);
+        }
 
-    if ((fhdr = read_file_header(ifile)) == NULL)
-    {
-        goto cleanup;
+        if (w->out->npt > 0)
+        {
+            memcpy(w->waves + (slot * w->out->npt), record + sizeof (int32_t) + MARKER_SIZE,
+                sizeof (int16_t) * w->out->npt);
+        }
     }
+}
+/* -------------------------------------------------------------------------- */
+/*distribute the data of block <k> (read to <data>) over the trials*/
+static void visit_epoch_block(struct SMRFile *f, struct EpochWork *w,
+    uint64_t k, const uint8_t *data, struct EpochTrigger *trig,
+    uint64_t ntrial, double pre, double post)
+{
+    size_t nitem = (size_t) w->bhdr->hdr[k].nitem;
+    size_t j;
+    int32_t tick;
 
-    if ((chdr = read_channel_header(fhdr, idx)) == NULL)
+    if (w->out->kind == CONTINUOUS_CHANNEL)
     {
-        goto cleanup;
+        copy_snippets(w->out->data, w->out->npt, w->refs, ntrial, w->first[k],
+            nitem, (const int16_t *) data);
+
+        return;
     }
 
-    if (chdr->kind < EVENT_2_CHANNEL || chdr->kind > EVENT_4_CHANNEL)
+    for (j = 0; j < nitem; ++j, data += w->record_size)
     {
-        char msg[80];
-        sprintf(msg, "Channel [%d - %s] is not an event channel", chdr->index, chdr->title);
-        fprintf(stderr, "ERROR: %s\n", msg);
+        memcpy(&tick, data, sizeof (int32_t));
 
-        goto cleanup;
+        add_epoch_hits(w, ticks_to_seconds(f->fhdr, tick), data, trig, ntrial,
+            pre, post);
     }
+}
+/* -------------------------------------------------------------------------- */
+/*order the events of a channel by trial and time and fill in its output*/
+static void finish_epoch_channel(struct EpochWork *w, uint64_t ntrial)
+{
+    struct SMREpochChannel *out = w->out;
+    uint64_t k;
 
-    if ((bhdr = read_block_header_array(chdr)) == NULL)
+    if (out->kind == CONTINUOUS_CHANNEL)
     {
-        goto cleanup;
+        return;
     }
 
-    for (k = 0; k < bhdr->length; ++k)
+    if (w->nhit > 0)
     {
-        /*get total number of samples in the record*/
-        nitem += (uint64_t) bhdr->hdr[k].nitem;
+        qsort(w->hits, w->nhit, sizeof (struct EpochHit), compare_epoch_hits);
     }
 
-    if ((fp = open_file(ifile, FILE_READ_MODE)) == NULL)
+    out->nevent = w->nhit;
+    out->offsets = calloc(ntrial + 1, sizeof (uint64_t));
+    out->times = malloc(sizeof (double) * w->nhit);
+
+    if (out->kind >= MARKER_CHANNEL)
     {
-        fprintf(stderr, "ERROR: failed to open file - %s\n", fhdr->filepath);
-        goto cleanup;
+        out->markers = malloc(MARKER_SIZE * w->nhit);
     }
 
-    rewind(fp);
-
-    evt = malloc(sizeof (struct SMREventChannel));
-    buffer = malloc(sizeof (int32_t) * nitem);
+    if (out->npt > 0)
+    {
+        out->data = malloc(sizeof (int16_t) * out->npt * w->nhit);
+    }
 
-    for (k = 0; k < bhdr->length; ++k)
+    for (k = 0; k < w->nhit; ++k)
     {
-        fseek(fp, bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE, SEEK_SET);
+        ++out->offsets[w->hits[k].trial + 1];
 
-        /*FIXME: this pointer opperation may not be kosher...*/
-        if ((ptr + (size_t) bhdr->hdr[k].nitem) <= (size_t) nitem)
+        out->times[k] = w->hits[k].time;
+
+        if (out->kind >= MARKER_CHANNEL)
         {
-            ptr  += fread(buffer + ptr, sizeof (int32_t), bhdr->hdr[k].nitem, fp);
+            memcpy(out->markers + (k * MARKER_SIZE), w->markers + (w->hits[k].slot * MARKER_SIZE), MARKER_SIZE);
         }
-        else
-        {
-            fprintf(stderr, "WARNING: write extends beyond allocated area\n");
-            fclose(fp);
-
-            free_event_channel(evt);
-            evt = NULL;
 
-            goto cleanup;
+        if (out->npt > 0)
+        {
+            memcpy(out->data + (k * out->npt), w->waves + (w->hits[k].slot * out->npt), sizeof (int16_t) * out->npt);
         }
     }
 
-    evt->data = malloc(sizeof (double) * nitem);
-
-    for (k = 0; k < nitem; ++k)
+    for (k = 0; k < ntrial; ++k)
     {
-        evt->data[k] = ticks_to_seconds(fhdr, buffer[k]);
+        out->offsets[k+1] += out->offsets[k];
     }
-
-    evt->length = nitem;
-
-    fclose(fp);
-
-cleanup:
-    if (buffer) { free(buffer); }
-    free_block_header_array(bhdr);
-    free_channel_header(chdr);
-    free_file_header(fhdr);
-
-    return evt;
 }
 /* -------------------------------------------------------------------------- */
-void free_event_channel(struct SMREventChannel *s)
+/*align the data of the <nchannel> <channels> to the <ntrial> <triggers>,
+  keeping from <pre> seconds before to <post> seconds after each trigger
+  (see struct SMREpochChannel for the layout). the blocks of all channels
+  that overlap any trial are read once, in file order. continuous, event,
+  level and all marker kind channels are supported*/
+struct SMREpochs *read_epochs_from_file(struct SMRFile *f, const int *channels,
+    int nchannel, const double *triggers, uint64_t ntrial, double pre,
+    double post)
 {
-    if (s)
-    {
-        if (s->data) { free(s->data); }
+    struct SMREpochs *ep = NULL;
+    struct EpochWork *work = NULL;
+    struct EpochTrigger *trig = NULL;
+    struct EpochBlock *blocks = NULL;
+    struct BlockRead *reqs = NULL;
+
+    uint64_t nblock = 0;
+    uint64_t capacity = 0;
+    uint64_t start;
+    uint64_t end;
+    uint64_t k;
+    size_t length;
+    size_t ptr;
+    size_t size = EPOCH_BATCH_SIZE;
+    double mark[2];
+    int c;
 
-        free(s);
+    uint8_t *buffer = NULL;
+
+    if (pre < 0.0 || post < 0.0)
+    {
+        fprintf(stderr, "ERROR: invalid epoch window [%f, %f]\n", -pre, post);
+        return NULL;
     }
-}
-/* ========================================================================== */
-struct SMRMarkerChannel *read_marker_channel(const char *ifile, int idx)
-{
-    struct SMRFileHeader *fhdr = NULL;
-    struct SMRChannelHeader *chdr = NULL;
-    struct SMRBlockHeaderArray *bhdr = NULL;
-    struct SMRMarkerChannel *evt = NULL;
 
-    FILE *fp;
+    ep = malloc(sizeof (struct SMREpochs));
 
-    uint64_t inc = 0;
-    uint64_t k;
-    uint64_t j;
-    uint8_t hastext;
-    int32_t buf;
+    ep->ntrial = ntrial;
+    ep->pre = pre;
+    ep->post = post;
+    ep->triggers = malloc(sizeof (double) * ntrial);
+    ep->nchannel = nchannel;
+    ep->channels = calloc(nchannel, sizeof (struct SMREpochChannel));
 
-    if (idx < 0)
+    if (ntrial > 0)
     {
-        printf("[ERROR]: channel index '%d' is not a valid index\n", idx);
-        goto cleanup;
+        memcpy(ep->triggers, triggers, sizeof (double) * ntrial);
     }
 
-    if ((fhdr = read_file_header(ifile)) == NULL)
-    {
-        goto cleanup;
-    }
+    trig = malloc(sizeof (struct EpochTrigger) * ntrial);
 
-    if ((chdr = read_channel_header(fhdr, idx)) == NULL)
+    for (k = 0; k < ntrial; ++k)
     {
-        goto cleanup;
+        trig[k].time = triggers[k];
+        trig[k].trial = k;
     }
 
-    if (chdr->kind != MARKER_CHANNEL && chdr->kind != TEXT_MARKER_CHANNEL)
+    if (ntrial > 0)
     {
-        char msg[80];
-        sprintf(msg, "Channel [%d - %s] is not an event marker channel", chdr->index, chdr->title);
-        fprintf(stderr, "ERROR: %s\n", msg);
-
-        goto cleanup;
+        qsort(trig, ntrial, sizeof (struct EpochTrigger), compare_epoch_triggers);
     }
 
-    if (chdr->kind == MARKER_CHANNEL)
-    {
-        hastext = 0;
-    }
-    else
-    {
-        hastext = 1;
-    }
+    work = calloc(nchannel, sizeof (struct EpochWork));
 
-    if ((bhdr = read_block_header_array(chdr)) == NULL)
+    /*collect the blocks of every channel that overlap any trial*/
+    for (c = 0; c < nchannel; ++c)
     {
-        goto cleanup;
-    }
+        work[c].out = ep->channels + c;
 
-    evt = malloc(sizeof (struct SMRMarkerChannel));
+        if (init_epoch_work(f, work + c, channels[c], trig, ntrial, pre, post) != 0)
+        {
+            free_epochs(ep);
+            ep = NULL;
 
+            goto cleanup;
+        }
 
-    if ((fp = open_file(ifile, FILE_READ_MODE)) == NULL)
-    {
-        fprintf(stderr, "ERROR: failed to open file - %s\n", ifile);
-        goto cleanup;
-    }
+        for (k = 0; k < work[c].bhdr->length; ++k)
+        {
+            if (!epoch_block_needed(f, work + c, k, trig, ntrial, pre, post))
+            {
+                continue;
+            }
 
-    rewind(fp);
+            if (nblock == capacity)
+            {
+                capacity = capacity > 0 ? capacity * 2 : 256;
+                blocks = realloc(blocks, sizeof (struct EpochBlock) * capacity);
+            }
 
-    evt->length = 0;
+            blocks[nblock].offset = (int64_t) work[c].bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE;
+            blocks[nblock].channel = c;
+            blocks[nblock].block = k;
 
-    for (k = 0; k < bhdr->length; ++k)
-    {
-        evt->length += (uint64_t) bhdr->hdr[k].nitem;
-    }
+            length = (size_t) work[c].bhdr->hdr[k].nitem * work[c].record_size;
 
-    /*number of characters in text field for each event*/
-    if (hastext)
-    {
-        evt->npt = chdr->nextra / sizeof (uint8_t);
+            if (length + 8 > size)
+            {
+                size = length + 8;
+            }
+
+            ++nblock;
+        }
     }
-    else
+
+    if (nblock > 0)
     {
-        evt->npt = 1;
+        qsort(blocks, nblock, sizeof (struct EpochBlock), compare_epoch_blocks);
     }
 
-    evt->timestamps = malloc(sizeof (double) * evt->length);
-    evt->markers = malloc(sizeof (uint8_t) * evt->length * MARKER_SIZE);
-    evt->text = malloc(sizeof (uint8_t) * evt->length * evt->npt);
+    reqs = malloc(sizeof (struct BlockRead) * (nblock > 0 ? nblock : 1));
+    buffer = malloc(size);
+
+    start_decode_timer(f, mark);
 
-    for (k = 0; k < chdr->nblock; ++k)
+    /*fetch as many consecutive blocks as fit in the buffer at once*/
+    for (start = 0; start < nblock; start = end)
     {
-        fseek(fp, bhdr->hdr[k].next_block + BLOCK_HEADER_SIZE, SEEK_SET);
+        ptr = 0;
 
-        for (j = 0; j < bhdr->hdr[k].nitem; ++j, ++inc)
+        for (end = start; end < nblock; ++end)
         {
-            fread(&buf, sizeof (int32_t), 1, fp);
-            fread(evt->markers+(inc*MARKER_SIZE), sizeof (uint8_t), MARKER_SIZE, fp);
+            struct EpochWork *w = work + blocks[end].channel;
 
-            if (hastext)
-            {
-                fread(evt->text+(inc*evt->npt), sizeof (uint8_t), evt->npt, fp);
-            }
-            else
+            length = (size_t) w->bhdr->hdr[blocks[end].block].nitem * w->record_size;
+
+            if (ptr + length > size)
             {
-                evt->text[inc] = 0;
+                break;
             }
 
-            /*convert time in ticks to seconds*/
-            evt->timestamps[inc] = ticks_to_seconds(fhdr, buf);
+            reqs[end].offset = blocks[end].offset;
+            reqs[end].length = length;
+            reqs[end].dest = buffer + ptr;
+
+            /*keep every block 8 byte aligned for the decoders*/
+            ptr += (length + 7) & ~((size_t) 7);
+        }
+
+        if (fetch_block_reads(f, reqs + start, (size_t) (end - start)) != 0)
+        {
+            fprintf(stderr, "ERROR: failed to read epoch data\n");
+
+            free_epochs(ep);
+            ep = NULL;
+
+            goto cleanup;
+        }
+
+        for (k = start; k < end; ++k)
+        {
+            visit_epoch_block(f, work + blocks[k].channel, blocks[k].block,
+                reqs[k].dest, trig, ntrial, pre, post);
         }
     }
 
-    fclose(fp);
+    for (c = 0; c < nchannel; ++c)
+    {
+        finish_epoch_channel(work + c, ntrial);
+    }
+
+    stop_decode_timer(f, mark, nblock);
 
 cleanup:
-    free_block_header_array(bhdr);
-    free_channel_header(chdr);
-    free_file_header(fhdr);
+    for (c = 0; work != NULL && c < nchannel; ++c)
+    {
+        if (work[c].refs) { free(work[c].refs); }
 
-    return evt;
+        if (work[c].first) { free(work[c].first); }
+
+        if (work[c].hits) { free(work[c].hits); }
+
+        if (work[c].markers) { free(work[c].markers); }
+
+        if (work[c].waves) { free(work[c].waves); }
+    }
+
+    if (work) { free(work); }
+
+    if (trig) { free(trig); }
+
+    if (blocks) { free(blocks); }
+
+    if (reqs) { free(reqs); }
+
+    if (buffer) { free(buffer); }
+
+    return ep;
 }
 /* -------------------------------------------------------------------------- */
-void free_marker_channel(struct SMRMarkerChannel *s)
+void free_epochs(struct SMREpochs *ep)
 {
-    if (s)
+    int c;
+
+    if (ep)
     {
-        if (s->timestamps) { free(s->timestamps); }
+        for (c = 0; ep->channels != NULL && c < ep->nchannel; ++c)
+        {
+            if (ep->channels[c].data) { free(ep->channels[c].data); }
 
-        if (s->markers) { free(s->markers); }
+            if (ep->channels[c].offsets) { free(ep->channels[c].offsets); }
 
-        if (s->text) { free(s->text); }
+            if (ep->channels[c].times) { free(ep->channels[c].times); }
 
-        free(s);
+            if (ep->channels[c].markers) { free(ep->channels[c].markers); }
+        }
+
+        if (ep->channels) { free(ep->channels); }
+
+        if (ep->triggers) { free(ep->triggers); }
+
+        free(ep);
     }
 }
 /* ========================================================================== */
@@ -1038,3 +6227,13 @@ cleanup:
     return ifo;
 }
 /* ========================================================================== */
+/*release one buffer of a struct returned by a read_* function. bindings that
+  keep the buffers of a result (rather than copying them) free them here,
+  so that the allocator of the library is used, and the emptied struct itself
+  with free_buffer as well. the arrays of channels served by the channel cache
+  are shared, and only freed along with their last holder*/
+void free_buffer(void *ptr)
+{
+    release_buffer(ptr);
+}
+/* ========================================================================== */
@@ -4,6 +4,10 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /* =============================================================================
 TODO:
     1) rename field 'nitem' to 'nsample' in block header
@@ -21,6 +25,45 @@ TODO:
 /*# of microsconds in a second*/
 #define MICROSECONDS 1000000.0
 
+/*# of samples reduced into each bin of the finest summary level, and the
+  reduction factor between consecutive levels*/
+#define SUMMARY_BASE_BIN 16
+#define SUMMARY_FACTOR 4
+
+/*flags for open_smr_file: load / regenerate the <file>.smridx sidecar index,
+  include per-block statistics of waveform channels in it, collect I/O
+  statistics (see struct SMRIOStats) while reading, fetch channel blocks
+  through io_uring (Linux only, silently falls back to stdio elsewhere), and
+  keep the file out of the page cache for cold bulk scans (direct reads where
+  possible, otherwise cached pages are dropped after use). the path based
+  readers open with set_default_open_flags() / SMR_OPEN_FLAGS, 0 by default*/
+#define SMR_USE_INDEX 0x01
+#define SMR_INDEX_STATS 0x02
+#define SMR_IO_STATS 0x04
+#define SMR_IO_URING 0x08
+#define SMR_IO_DIRECT 0x10
+
+/*outputs of read_filtered_channel (see struct SMRFilterConfig)*/
+#define SMR_EMIT_DATA 0x01
+#define SMR_EMIT_CROSSINGS 0x02
+
+/*highest Butterworth order of either edge of the band-pass filter*/
+#define SMR_MAX_FILTER_ORDER 8
+
+/*sample types of read_continuous_matrix: raw ADC values or volts*/
+#define SMR_FILL_INT16 0
+#define SMR_FILL_SINGLE 1
+#define SMR_FILL_DOUBLE 2
+
+/*index sidecar file identification*/
+#define INDEX_EXT ".smridx"
+#define INDEX_MAGIC "SMRIDX\0\0"
+#define INDEX_VERSION 2
+
+/*summary sidecar file identification*/
+#define SUMMARY_MAGIC "SMRSUM\0\0"
+#define SUMMARY_VERSION 2
+
 /* ========================================================================== */
 enum channel_type_t
 {
@@ -34,6 +77,19 @@ enum channel_type_t
     TEXT_MARKER_CHANNEL = 8,
     REAL_WAVE_CHANNEL = 9
 };
+/* -------------------------------------------------------------------------- */
+/*result of each channel reader, selects the reader for run time dispatch
+  (e.g. submit_channel_read)*/
+enum channel_data_t
+{
+    WAVEMARK_DATA = 1,   /*read_wavemark_channel*/
+    CONTINUOUS_DATA,     /*read_continuous_channel*/
+    REALWAVE_DATA,       /*read_realwave_channel*/
+    EVENT_DATA,          /*read_event_channel*/
+    LEVEL_DATA,          /*read_level_channel*/
+    MARKER_DATA,         /*read_marker_channel*/
+    REALMARKER_DATA      /*read_realmarker_channel*/
+};
 /* ========================================================================== */
 struct SMRFileHeader
 {
@@ -144,6 +200,87 @@ struct SMRBlockHeaderArray
     unsigned int length;
     struct SMRBlockHeader *hdr;
 };
+/* -------------------------------------------------------------------------- */
+struct SMRBlockStats
+{
+    float min;
+    float max;
+    float mean;
+};
+/* -------------------------------------------------------------------------- */
+/*counters accumulated by an SMRFile opened with SMR_IO_STATS. the counts
+  cover reads of the smr file itself (not of sidecar files); times are wall
+  clock seconds. <decode_time> spans the block loops of the channel readers
+  and includes <io_time> spent inside them, <convert_time> is the remainder
+  (unpacking records and converting ticks to seconds)*/
+struct SMRIOStats
+{
+    uint64_t bytes_read;
+    uint64_t nread;       /*# of fread calls*/
+    uint64_t nseek;       /*# of fseek calls*/
+    uint64_t nblock;      /*# of data blocks decoded*/
+
+    double parse_time;    /*file / channel headers or the sidecar index*/
+    double walk_time;     /*following block chains*/
+    double decode_time;
+    double convert_time;
+    double io_time;       /*total time spent in fread / fseek*/
+};
+/* -------------------------------------------------------------------------- */
+/*state of the process-wide channel cache, see set_channel_cache_size*/
+struct SMRCacheInfo
+{
+    uint64_t budget;  /*bytes, 0 = disabled*/
+    uint64_t nbyte;   /*bytes currently held*/
+    uint64_t nentry;
+    uint64_t nhit;
+    uint64_t nmiss;
+    uint64_t nevict;
+};
+/* -------------------------------------------------------------------------- */
+/*a queued channel read, see submit_channel_read (opaque)*/
+struct SMRAsyncRead;
+
+typedef void (*SMRReadCallback)(struct SMRAsyncRead *, void *);
+
+struct SMRUring;
+struct SMRDirect;
+/* ========================================================================== */
+/*identifies the contents of a file on disk, any change to the file (even one
+  that keeps its size and is rewritten within the same second) changes one of
+  the fields. used to validate the channel cache and sidecar files*/
+struct SMRFileStamp
+{
+    int64_t size;
+    int64_t mtime;  /*modification time in ns*/
+    int64_t ctime;  /*status change time in ns*/
+    uint64_t inode; /*inode (file index on Windows)*/
+};
+/* ========================================================================== */
+/*an open smr file, holding the parsed headers and the (lazily walked) block
+  tables of every channel so that repeated reads don't have to re-parse them.
+  all arrays are indexed by channel index - 1.
+
+  threading: a handle is not locked, so it must only be used by one thread at
+  a time. distinct handles (including several of the same file) share no
+  state apart from the internally locked channel cache and read pool, so one
+  handle per thread reads in parallel, as do the path based readers (which
+  open a private handle per call)*/
+struct SMRFile
+{
+    struct SMRFileHeader *fhdr;
+    struct SMRChannelHeader **chdr;
+    struct SMRBlockHeaderArray **bhdr;
+    struct SMRBlockStats **bstats;
+    struct SMRIOStats *stats; /*NULL unless opened with SMR_IO_STATS*/
+    struct SMRUring *uring; /*created on first read with SMR_IO_URING*/
+    struct SMRDirect *direct; /*direct read state with SMR_IO_DIRECT*/
+
+    FILE *fp;
+    int flags;
+
+    struct SMRFileStamp stamp; /*the version of the file that was opened*/
+};
 /* ========================================================================== */
 struct SMRWMrkChannel
 {
@@ -161,12 +298,107 @@ struct SMRContChannel
     int16_t *data;
 };
 /* ========================================================================== */
+/*the epochs of one channel in an SMREpochs. continuous channels fill <data>
+  with one column of <npt> samples per trial, the sample at index
+  round(pre * sampling_rate) being the one nearest the trigger. event and
+  marker kind channels list the events of every trial in <times> (relative to
+  the trigger, in seconds), trial k being [offsets[k], offsets[k+1]), marker
+  kinds add their <markers> and wavemark channels their <npt> x <nevent>
+  waveforms in <data>*/
+struct SMREpochChannel
+{
+    int index;
+    uint8_t kind;
+    double sampling_rate; /*continuous only*/
+    uint64_t npt;
+
+    int16_t *data;
+
+    uint64_t nevent;
+    uint64_t *offsets;
+    double *times;
+    uint8_t *markers;
+};
+/* -------------------------------------------------------------------------- */
+/*data of several channels aligned to <ntrial> trigger times, see read_epochs*/
+struct SMREpochs
+{
+    uint64_t ntrial;
+    double pre;
+    double post;
+    double *triggers;
+
+    int nchannel;
+    struct SMREpochChannel *channels;
+};
+/* ========================================================================== */
+/*a channel read chunk by chunk, see read_cursor_chunk. the fields up to
+  <sampling_rate> are public*/
+struct SMRCursor
+{
+    int index;
+    uint8_t kind;
+    uint64_t chunk;        /*items per chunk*/
+    uint64_t length;       /*items in the channel*/
+    uint64_t position;     /*index of the first item of the next chunk*/
+    double sampling_rate;  /*waveform channels only*/
+
+    struct SMRFile *f;
+    int own_file;
+    struct SMRBlockHeaderArray *bhdr;
+    uint64_t next;         /*next block to stage*/
+    size_t record_size;
+    uint8_t *stage;
+    size_t nbyte;
+    uint64_t nstage;       /*items staged*/
+    uint64_t pos;          /*staged items consumed*/
+};
+/* ========================================================================== */
+struct SMRRealWaveChannel
+{
+    uint64_t length;
+    double sampling_rate;
+    float *data;
+};
+/* ========================================================================== */
+/*band-pass filter and threshold detector applied by read_filtered_channel.
+  either corner can be disabled with a value <= 0, the enabled ones must
+  satisfy 0 < <low> < <high> < Nyquist. a negative <threshold> detects
+  downward crossings, a positive one upward crossings and 0 none*/
+struct SMRFilterConfig
+{
+    double low;       /*high pass corner in Hz*/
+    double high;      /*low pass corner in Hz*/
+    int order;        /*Butterworth order of each corner, even*/
+    double threshold; /*in ADC units of the filtered signal*/
+    double dead_time; /*minimum time between crossings in seconds*/
+    int emit;         /*SMR_EMIT_DATA and / or SMR_EMIT_CROSSINGS*/
+};
+/* -------------------------------------------------------------------------- */
+struct SMRFilteredChannel
+{
+    uint64_t length;   /*0 unless SMR_EMIT_DATA*/
+    double sampling_rate;
+    float *data;       /*filtered samples in ADC units*/
+
+    uint64_t ncrossing;
+    double *crossings; /*crossing times in seconds*/
+};
+/* ========================================================================== */
 struct SMREventChannel
 {
     uint64_t length;
     double *data;
 };
 /* ========================================================================== */
+struct SMRLevelChannel
+{
+    uint64_t length;  /*number of high intervals*/
+    uint8_t init_low; /*1 if the channel level starts low*/
+    double *start;    /*time of the rising edge starting each interval*/
+    double *stop;     /*time of the falling edge ending each interval*/
+};
+/* ========================================================================== */
 struct SMRMarkerChannel
 {
     uint64_t length; /*number of events*/
@@ -176,6 +408,43 @@ struct SMRMarkerChannel
     uint8_t *text;
 };
 /* ========================================================================== */
+struct SMRRealMarkerChannel
+{
+    uint64_t length; /*number of events*/
+    uint64_t npt;    /*# of floats for each event*/
+    double *timestamps;
+    uint8_t *markers;
+    float *data;
+};
+/* ========================================================================== */
+struct SMRSummaryLevel
+{
+    uint64_t length;  /*# of bins*/
+    uint64_t binsize; /*# of samples per bin (the last bin may be partial)*/
+    int16_t *min;
+    int16_t *max;
+    float *mean;
+};
+/* -------------------------------------------------------------------------- */
+struct SMRSummary
+{
+    uint64_t nsample;
+    double sampling_rate;
+    double start_time;   /*time of the first sample in seconds*/
+    unsigned int nlevel; /*level 0 is the finest*/
+    struct SMRSummaryLevel *level;
+};
+/* -------------------------------------------------------------------------- */
+struct SMREnvelope
+{
+    uint64_t length; /*# of pixels*/
+    double t0;       /*time of the left edge of the first pixel in seconds*/
+    double dt;       /*width of each pixel in seconds*/
+    int16_t *min;
+    int16_t *max;
+    float *mean;
+};
+/* ========================================================================== */
 struct SMRFileHeader *read_file_header(const char *);
 void free_file_header(struct SMRFileHeader *);
 
@@ -191,27 +460,149 @@ struct SMRChannelInfo *load_channel_info(struct SMRChannelHeader *);
 void free_channel_info_array(struct SMRChannelInfoArray *);
 void free_channel_info(struct SMRChannelInfo *);
 
+struct SMRFile *open_smr_file(const char *, int);
+void close_smr_file(struct SMRFile *);
+struct SMRChannelHeader *get_channel_header(struct SMRFile *, int);
+int get_channel_kind(struct SMRFile *, int);
+struct SMRBlockHeaderArray *get_block_header_array(struct SMRFile *, int);
+struct SMRBlockStats *get_block_stats(struct SMRFile *, int);
+struct SMRIOStats *get_io_stats(struct SMRFile *);
+void reset_io_stats(struct SMRFile *);
+
+void set_default_open_flags(int);
+int get_default_open_flags(void);
+
+void set_channel_cache_size(uint64_t);
+void clear_channel_cache(void);
+struct SMRCacheInfo get_channel_cache_info(void);
+
+struct SMRAsyncRead *submit_channel_read(const char *, int, int,
+    SMRReadCallback, void *);
+int channel_read_ready(struct SMRAsyncRead *);
+void *wait_channel_read(struct SMRAsyncRead *);
+void free_channel_read(struct SMRAsyncRead *);
+void shutdown_read_pool(void);
+void set_read_pool_size(int);
+
 struct SMRWMrkChannel *read_wavemark_channel(const char *, int);
+struct SMRWMrkChannel *read_wavemark_channel_from_file(struct SMRFile *, int);
+struct SMRWMrkChannel *read_wavemark_channel_codes(const char *, int,
+    const uint8_t *, int);
+struct SMRWMrkChannel *read_wavemark_channel_codes_from_file(struct SMRFile *,
+    int, const uint8_t *, int);
 void free_wavemark_channel(struct SMRWMrkChannel *);
 
 struct SMRContChannel *read_continuous_channel(const char *, int);
+struct SMRContChannel *read_continuous_channel_from_file(struct SMRFile *, int);
 struct SMRContChannel *read_continuous_channel_from_header(
     struct SMRFileHeader *, struct SMRChannelHeader *);
+struct SMRContChannel *read_continuous_channel_decimated(const char *, int,
+    int);
+struct SMRContChannel *read_continuous_channel_decimated_from_file(
+    struct SMRFile *, int, int);
 void free_continuous_channel(struct SMRContChannel *);
 
+void default_filter_config(struct SMRFilterConfig *);
+struct SMRFilteredChannel *read_filtered_channel(const char *, int,
+    struct SMRFilterConfig *);
+struct SMRFilteredChannel *read_filtered_channel_from_file(struct SMRFile *,
+    int, struct SMRFilterConfig *);
+void free_filtered_channel(struct SMRFilteredChannel *);
+
+struct SMRWMrkChannel *read_continuous_snippets(const char *, int,
+    const double *, uint64_t, double, double);
+struct SMRWMrkChannel *read_continuous_snippets_from_file(struct SMRFile *,
+    int, const double *, uint64_t, double, double);
+
+struct SMREpochs *read_epochs(const char *, const int *, int, const double *,
+    uint64_t, double, double);
+struct SMREpochs *read_epochs_from_file(struct SMRFile *, const int *, int,
+    const double *, uint64_t, double, double);
+void free_epochs(struct SMREpochs *);
+
+struct SMRRealWaveChannel *read_realwave_channel(const char *, int);
+struct SMRRealWaveChannel *read_realwave_channel_from_file(struct SMRFile *,
+    int);
+struct SMRRealWaveChannel *read_realwave_channel_from_header(
+    struct SMRFileHeader *, struct SMRChannelHeader *);
+void free_realwave_channel(struct SMRRealWaveChannel *);
+
 struct SMREventChannel *read_event_channel(const char *, int);
+struct SMREventChannel *read_event_channel_from_file(struct SMRFile *, int);
 void free_event_channel(struct SMREventChannel *);
 
+struct SMRLevelChannel *read_level_channel(const char *, int);
+struct SMRLevelChannel *read_level_channel_from_file(struct SMRFile *, int);
+void free_level_channel(struct SMRLevelChannel *);
+
 struct SMRMarkerChannel *read_marker_channel(const char *, int);
+struct SMRMarkerChannel *read_marker_channel_from_file(struct SMRFile *, int);
+struct SMRMarkerChannel *read_marker_channel_codes(const char *, int,
+    const uint8_t *, int);
+struct SMRMarkerChannel *read_marker_channel_codes_from_file(struct SMRFile *,
+    int, const uint8_t *, int);
 void free_marker_channel(struct SMRMarkerChannel *);
 
+struct SMRRealMarkerChannel *read_realmarker_channel(const char *, int);
+struct SMRRealMarkerChannel *read_realmarker_channel_from_file(
+    struct SMRFile *, int);
+void free_realmarker_channel(struct SMRRealMarkerChannel *);
+
+struct SMREventChannel *read_marker_timestamps(const char *, int);
+struct SMREventChannel *read_marker_timestamps_from_file(struct SMRFile *,
+    int);
+
+/*decode into caller owned buffers of channel_item_count items (times the
+  per item size of each field), see BUFFER FILL FUNCTIONS in smr.c*/
+uint64_t channel_item_count(struct SMRFile *, int);
+int64_t channel_extra_size(struct SMRFile *, int);
+int read_continuous_channel_into(struct SMRFile *, int, int16_t *);
+int read_continuous_channel_scaled(struct SMRFile *, int, double *);
+int read_continuous_channel_scaled_single(struct SMRFile *, int, float *);
+int read_event_channel_into(struct SMRFile *, int, double *);
+int read_marker_records_into(struct SMRFile *, int, double *, uint8_t *,
+    uint8_t *);
+int read_marker_ticks_into(struct SMRFile *, int, int32_t *);
+int read_marker_timestamps_into(struct SMRFile *, int, double *);
+int read_continuous_matrix(struct SMRFile *, const int *, int, void *,
+    uint64_t, int);
+
+struct SMRCursor *open_channel_cursor(const char *, int, uint64_t);
+struct SMRCursor *open_channel_cursor_from_file(struct SMRFile *, int,
+    uint64_t);
+int64_t read_cursor_chunk(struct SMRCursor *, void *);
+void rewind_channel_cursor(struct SMRCursor *);
+void close_channel_cursor(struct SMRCursor *);
+
 int channel_label_to_index(struct SMRFileHeader *, const char *);
 
 int channel_label_path_to_index(const char *, const char *);
 
+int channel_label_file_to_index(struct SMRFile *, const char *);
+
 double get_sample_interval(struct SMRFileHeader *, int);
 
 struct SMRChannelInfoArray *read_channel_array(const char *);
 
+/*while the channel cache is enabled the arrays of a channel returned by a
+  path based read_*_channel are shared with the cache entry and every other
+  read of that channel: they are READ-ONLY, copy them before modifying. free
+  them as usual, a shared array is only released with its last holder*/
+void free_buffer(void *);
+
+struct SMRSummary *read_continuous_summary(const char *, int, int);
+struct SMRSummary *build_continuous_summary(struct SMRFileHeader *,
+    struct SMRChannelHeader *);
+struct SMRSummary *build_continuous_summary_from_file(struct SMRFile *, int);
+void free_continuous_summary(struct SMRSummary *);
+
+struct SMREnvelope *read_summary_window(struct SMRSummary *, double, double,
+    uint32_t);
+void free_summary_window(struct SMREnvelope *);
+
 /* ========================================================================== */
+#ifdef __cplusplus
+}
+#endif
+
 #endif
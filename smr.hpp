@@ -0,0 +1,605 @@
+#ifndef _SMR_HPP
+#define _SMR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if __cplusplus > 201703L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "smr.h"
+
+/* =============================================================================
+header-only C++17 interface to libsmr (link against libsmr as usual):
+
+    smr::File f("data.smr");
+    smr::ContinuousChannel raw = f.read_continuous(f.index("Raw"));
+
+    for (int16_t x : raw.data()) { ... }
+
+    //decode into a caller owned (e.g. mmapped) buffer
+    f.read_continuous_into(1, smr::span<int16_t>(ptr, f.item_count(1)));
+
+    //stream a channel in constant memory
+    for (smr::span<const int16_t> chunk : f.chunks<int16_t>(1, 1 << 20)) { ... }
+
+every handle and channel owns its C struct and is move-only, the matching
+close / free function runs in the destructor. spans view memory owned by the
+object they came from and are invalidated when it is destroyed. failures of
+the C functions are thrown as smr::error, the details having been printed to
+stderr by the library. a File (and anything read from it lazily, e.g. a
+Cursor) must only be used by one thread at a time
+============================================================================= */
+namespace smr
+{
+/* ========================================================================== */
+#if defined(__cpp_lib_span)
+template <class T>
+using span = std::span<T>;
+#else
+/*the subset of std::span (C++20) used here: a pointer and a length*/
+template <class T>
+class span
+{
+public:
+    using element_type = T;
+    using value_type = std::remove_cv_t<T>;
+    using size_type = std::size_t;
+    using iterator = T *;
+
+    constexpr span() noexcept : ptr_(nullptr), size_(0) {}
+    constexpr span(T *ptr, size_type size) noexcept : ptr_(ptr), size_(size) {}
+
+    /*any contiguous container of T with data() and size(), e.g. std::vector*/
+    template <class C, class = std::enable_if_t<std::is_convertible<
+        std::remove_pointer_t<decltype(std::declval<C &>().data())> (*)[],
+        T (*)[]>::value>>
+    constexpr span(C &c) noexcept : ptr_(c.data()), size_(c.size()) {}
+
+    /*span<T> -> span<const T>*/
+    template <class U, class = std::enable_if_t<
+        std::is_convertible<U (*)[], T (*)[]>::value>>
+    constexpr span(const span<U> &s) noexcept : ptr_(s.data()), size_(s.size()) {}
+
+    constexpr T *data() const noexcept { return ptr_; }
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr bool empty() const noexcept { return size_ == 0; }
+
+    constexpr T &operator[](size_type k) const noexcept { return ptr_[k]; }
+
+    constexpr iterator begin() const noexcept { return ptr_; }
+    constexpr iterator end() const noexcept { return ptr_ + size_; }
+
+    constexpr span subspan(size_type offset, size_type count) const noexcept
+    {
+        return span(ptr_ + offset, count);
+    }
+
+private:
+    T *ptr_;
+    size_type size_;
+};
+#endif
+/* ========================================================================== */
+class error : public std::runtime_error
+{
+public:
+    using std::runtime_error::runtime_error;
+};
+/* ========================================================================== */
+namespace detail
+{
+/* -------------------------------------------------------------------------- */
+template <class T, void (*Free)(T *)>
+struct deleter
+{
+    void operator()(T *ptr) const noexcept { Free(ptr); }
+};
+/* -------------------------------------------------------------------------- */
+/*move-only owner of a C struct released with <Free>*/
+template <class T, void (*Free)(T *)>
+class owned
+{
+public:
+    explicit owned(T *ptr) : ptr_(ptr) {}
+
+    /*the C struct, still owned by this object*/
+    const T *get() const noexcept { return ptr_.get(); }
+
+    /*give up ownership, the caller must call <Free> on the result*/
+    T *release() noexcept { return ptr_.release(); }
+
+protected:
+    std::unique_ptr<T, deleter<T, Free>> ptr_;
+};
+/* -------------------------------------------------------------------------- */
+template <class T>
+T *check(T *ptr, const char *func)
+{
+    if (ptr == nullptr)
+    {
+        throw error(std::string("call to ") + func + " failed");
+    }
+
+    return ptr;
+}
+/* -------------------------------------------------------------------------- */
+inline void check(int status, const char *func)
+{
+    if (status != 0)
+    {
+        throw error(std::string("call to ") + func + " failed");
+    }
+}
+/* -------------------------------------------------------------------------- */
+} /*namespace detail*/
+/* ========================================================================== */
+class ContinuousChannel
+    : public detail::owned<SMRContChannel, free_continuous_channel>
+{
+public:
+    using owned::owned;
+
+    std::size_t size() const noexcept { return ptr_->length; }
+    double sampling_rate() const noexcept { return ptr_->sampling_rate; }
+
+    /*raw ADC values*/
+    span<const int16_t> data() const noexcept { return {ptr_->data, size()}; }
+};
+/* -------------------------------------------------------------------------- */
+class RealWaveChannel
+    : public detail::owned<SMRRealWaveChannel, free_realwave_channel>
+{
+public:
+    using owned::owned;
+
+    std::size_t size() const noexcept { return ptr_->length; }
+    double sampling_rate() const noexcept { return ptr_->sampling_rate; }
+
+    span<const float> data() const noexcept { return {ptr_->data, size()}; }
+};
+/* -------------------------------------------------------------------------- */
+class EventChannel : public detail::owned<SMREventChannel, free_event_channel>
+{
+public:
+    using owned::owned;
+
+    std::size_t size() const noexcept { return ptr_->length; }
+
+    /*event times in seconds*/
+    span<const double> timestamps() const noexcept { return {ptr_->data, size()}; }
+};
+/* -------------------------------------------------------------------------- */
+class LevelChannel : public detail::owned<SMRLevelChannel, free_level_channel>
+{
+public:
+    using owned::owned;
+
+    /*# of high intervals*/
+    std::size_t size() const noexcept { return ptr_->length; }
+    bool init_low() const noexcept { return ptr_->init_low != 0; }
+
+    span<const double> start() const noexcept { return {ptr_->start, size()}; }
+    span<const double> stop() const noexcept { return {ptr_->stop, size()}; }
+};
+/* -------------------------------------------------------------------------- */
+class WavemarkChannel
+    : public detail::owned<SMRWMrkChannel, free_wavemark_channel>
+{
+public:
+    using owned::owned;
+
+    std::size_t size() const noexcept { return ptr_->length; }
+
+    /*points per waveform*/
+    std::size_t npt() const noexcept { return ptr_->npt; }
+
+    span<const double> timestamps() const noexcept
+    {
+        return {ptr_->timestamps, size()};
+    }
+
+    /*MARKER_SIZE codes per spike*/
+    span<const uint8_t> markers() const noexcept
+    {
+        return {ptr_->markers, size() * MARKER_SIZE};
+    }
+
+    span<const uint8_t> marker(std::size_t k) const noexcept
+    {
+        return markers().subspan(k * MARKER_SIZE, MARKER_SIZE);
+    }
+
+    /*npt x size() samples, one column per spike*/
+    span<const int16_t> waveforms() const noexcept
+    {
+        return {ptr_->wavemarks, size() * npt()};
+    }
+
+    span<const int16_t> waveform(std::size_t k) const noexcept
+    {
+        return waveforms().subspan(k * npt(), npt());
+    }
+};
+/* -------------------------------------------------------------------------- */
+class MarkerChannel
+    : public detail::owned<SMRMarkerChannel, free_marker_channel>
+{
+public:
+    using owned::owned;
+
+    std::size_t size() const noexcept { return ptr_->length; }
+
+    span<const double> timestamps() const noexcept
+    {
+        return {ptr_->timestamps, size()};
+    }
+
+    span<const uint8_t> markers() const noexcept
+    {
+        return {ptr_->markers, size() * MARKER_SIZE};
+    }
+
+    span<const uint8_t> marker(std::size_t k) const noexcept
+    {
+        return markers().subspan(k * MARKER_SIZE, MARKER_SIZE);
+    }
+
+    /*the text of marker <k> up to its first NUL (empty for plain markers)*/
+    std::string_view text(std::size_t k) const noexcept
+    {
+        const char *ptr = reinterpret_cast<const char *>(ptr_->text + k * ptr_->npt);
+        std::size_t n = 0;
+
+        while (n < ptr_->npt && ptr[n] != '\0')
+        {
+            ++n;
+        }
+
+        return {ptr, n};
+    }
+};
+/* -------------------------------------------------------------------------- */
+class RealMarkerChannel
+    : public detail::owned<SMRRealMarkerChannel, free_realmarker_channel>
+{
+public:
+    using owned::owned;
+
+    std::size_t size() const noexcept { return ptr_->length; }
+
+    /*floats per marker*/
+    std::size_t npt() const noexcept { return ptr_->npt; }
+
+    span<const double> timestamps() const noexcept
+    {
+        return {ptr_->timestamps, size()};
+    }
+
+    span<const uint8_t> markers() const noexcept
+    {
+        return {ptr_->markers, size() * MARKER_SIZE};
+    }
+
+    span<const uint8_t> marker(std::size_t k) const noexcept
+    {
+        return markers().subspan(k * MARKER_SIZE, MARKER_SIZE);
+    }
+
+    span<const float> data() const noexcept
+    {
+        return {ptr_->data, size() * npt()};
+    }
+
+    span<const float> values(std::size_t k) const noexcept
+    {
+        return data().subspan(k * npt(), npt());
+    }
+};
+/* ========================================================================== */
+/*chunk-by-chunk reader of a continuous (T = int16_t), real wave (float) or
+  event (double, seconds) channel, see open_channel_cursor. iterating starts
+  from the beginning of the channel, every chunk is a view of one internal
+  buffer that the next chunk overwrites*/
+template <class T>
+class Cursor : public detail::owned<SMRCursor, close_channel_cursor>
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = span<const T>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type *;
+        using reference = const value_type &;
+
+        iterator() noexcept : cursor_(nullptr) {}
+
+        explicit iterator(Cursor *cursor) : cursor_(cursor) { next(); }
+
+        reference operator*() const noexcept { return chunk_; }
+        pointer operator->() const noexcept { return &chunk_; }
+
+        iterator &operator++() { next(); return *this; }
+
+        /*only comparisons against end() are meaningful*/
+        bool operator==(const iterator &other) const noexcept
+        {
+            return cursor_ == other.cursor_;
+        }
+
+        bool operator!=(const iterator &other) const noexcept
+        {
+            return !(*this == other);
+        }
+
+    private:
+        void next()
+        {
+            if ((chunk_ = cursor_->read()).empty())
+            {
+                cursor_ = nullptr;
+            }
+        }
+
+        Cursor *cursor_;
+        value_type chunk_;
+    };
+
+    /*takes ownership of <ptr>, which is closed again if T doesn't match the
+      kind of the channel*/
+    explicit Cursor(SMRCursor *ptr) : owned(ptr)
+    {
+        if (!kind_matches(ptr->kind))
+        {
+            throw error("cursor element type does not match the channel kind");
+        }
+
+        buffer_.reset(new T[ptr->chunk]);
+    }
+
+    /*total # of items in the channel*/
+    std::size_t size() const noexcept { return ptr_->length; }
+    double sampling_rate() const noexcept { return ptr_->sampling_rate; }
+
+    /*the next chunk, empty at the end of the channel*/
+    span<const T> read()
+    {
+        int64_t n = read_cursor_chunk(ptr_.get(), buffer_.get());
+
+        if (n < 0)
+        {
+            throw error("call to read_cursor_chunk failed");
+        }
+
+        return {buffer_.get(), static_cast<std::size_t>(n)};
+    }
+
+    void rewind() noexcept { rewind_channel_cursor(ptr_.get()); }
+
+    iterator begin() { rewind(); return iterator(this); }
+    iterator end() noexcept { return iterator(); }
+
+private:
+    static bool kind_matches(uint8_t kind) noexcept
+    {
+        switch (kind)
+        {
+            case CONTINUOUS_CHANNEL: return std::is_same<T, int16_t>::value;
+            case REAL_WAVE_CHANNEL:  return std::is_same<T, float>::value;
+            default:                 return std::is_same<T, double>::value;
+        }
+    }
+
+    std::unique_ptr<T[]> buffer_;
+};
+/* ========================================================================== */
+/*an open smr file (see struct SMRFile)*/
+class File : public detail::owned<SMRFile, close_smr_file>
+{
+public:
+    /*<flags> as for open_smr_file, e.g. SMR_USE_INDEX*/
+    explicit File(const std::string &path, int flags = 0)
+        : owned(detail::check(open_smr_file(path.c_str(), flags), "open_smr_file"))
+    {}
+
+    /*channel slots in the file, valid indices are 1 - nchannel()*/
+    int nchannel() const noexcept { return ptr_->fhdr->nchannel; }
+
+    /*channel kind, 0 for unused slots*/
+    int kind(int idx) const
+    {
+        int kind = get_channel_kind(ptr_.get(), idx);
+
+        if (kind < 0)
+        {
+            throw error("channel index out of range");
+        }
+
+        return kind;
+    }
+
+    /*index of the channel titled <label> (case insensitive)*/
+    int index(const std::string &label) const
+    {
+        int idx = channel_label_file_to_index(ptr_.get(), label.c_str());
+
+        if (idx < 0)
+        {
+            throw error("no channel titled " + label);
+        }
+
+        return idx;
+    }
+
+    const SMRChannelHeader &header(int idx) const
+    {
+        return *detail::check(get_channel_header(ptr_.get(), idx),
+            "get_channel_header");
+    }
+
+    /*the block headers of channel <idx>, in file order*/
+    span<const SMRBlockHeader> blocks(int idx)
+    {
+        SMRBlockHeaderArray *bhdr = detail::check(
+            get_block_header_array(ptr_.get(), idx), "get_block_header_array");
+
+        return {bhdr->hdr, bhdr->length};
+    }
+
+    /*# of samples / events / records, the length needed by the *_into reads*/
+    std::size_t item_count(int idx) { return channel_item_count(ptr_.get(), idx); }
+
+    /* ---------------------------------------------------------------------- */
+    ContinuousChannel read_continuous(int idx)
+    {
+        return ContinuousChannel(detail::check(
+            read_continuous_channel_from_file(ptr_.get(), idx),
+            "read_continuous_channel_from_file"));
+    }
+
+    RealWaveChannel read_realwave(int idx)
+    {
+        return RealWaveChannel(detail::check(
+            read_realwave_channel_from_file(ptr_.get(), idx),
+            "read_realwave_channel_from_file"));
+    }
+
+    EventChannel read_event(int idx)
+    {
+        return EventChannel(detail::check(
+            read_event_channel_from_file(ptr_.get(), idx),
+            "read_event_channel_from_file"));
+    }
+
+    LevelChannel read_level(int idx)
+    {
+        return LevelChannel(detail::check(
+            read_level_channel_from_file(ptr_.get(), idx),
+            "read_level_channel_from_file"));
+    }
+
+    WavemarkChannel read_wavemark(int idx)
+    {
+        return WavemarkChannel(detail::check(
+            read_wavemark_channel_from_file(ptr_.get(), idx),
+            "read_wavemark_channel_from_file"));
+    }
+
+    /*only the spikes whose unit code (marker(i)[0]) is one of <codes>*/
+    WavemarkChannel read_wavemark(int idx, span<const uint8_t> codes)
+    {
+        return WavemarkChannel(detail::check(
+            read_wavemark_channel_codes_from_file(ptr_.get(), idx,
+                codes.data(), static_cast<int>(codes.size())),
+            "read_wavemark_channel_codes_from_file"));
+    }
+
+    MarkerChannel read_marker(int idx)
+    {
+        return MarkerChannel(detail::check(
+            read_marker_channel_from_file(ptr_.get(), idx),
+            "read_marker_channel_from_file"));
+    }
+
+    MarkerChannel read_marker(int idx, span<const uint8_t> codes)
+    {
+        return MarkerChannel(detail::check(
+            read_marker_channel_codes_from_file(ptr_.get(), idx,
+                codes.data(), static_cast<int>(codes.size())),
+            "read_marker_channel_codes_from_file"));
+    }
+
+    RealMarkerChannel read_realmarker(int idx)
+    {
+        return RealMarkerChannel(detail::check(
+            read_realmarker_channel_from_file(ptr_.get(), idx),
+            "read_realmarker_channel_from_file"));
+    }
+
+    /* ---------------------------------------------------------------------- */
+    /*decode into caller owned storage of at least item_count(idx) items*/
+    void read_continuous_into(int idx, span<int16_t> dest)
+    {
+        check_size(idx, dest.size());
+        detail::check(read_continuous_channel_into(ptr_.get(), idx, dest.data()),
+            "read_continuous_channel_into");
+    }
+
+    /*in volts*/
+    void read_continuous_into(int idx, span<double> dest)
+    {
+        check_size(idx, dest.size());
+        detail::check(read_continuous_channel_scaled(ptr_.get(), idx, dest.data()),
+            "read_continuous_channel_scaled");
+    }
+
+    void read_continuous_into(int idx, span<float> dest)
+    {
+        check_size(idx, dest.size());
+        detail::check(read_continuous_channel_scaled_single(ptr_.get(), idx,
+            dest.data()), "read_continuous_channel_scaled_single");
+    }
+
+    void read_event_into(int idx, span<double> dest)
+    {
+        check_size(idx, dest.size());
+        detail::check(read_event_channel_into(ptr_.get(), idx, dest.data()),
+            "read_event_channel_into");
+    }
+
+    /*the times (seconds) / raw ticks of a marker kind channel, without
+      decoding the rest of each record*/
+    void read_marker_timestamps_into(int idx, span<double> dest)
+    {
+        check_size(idx, dest.size());
+        detail::check(::read_marker_timestamps_into(ptr_.get(), idx,
+            dest.data()), "read_marker_timestamps_into");
+    }
+
+    void read_marker_ticks_into(int idx, span<int32_t> dest)
+    {
+        check_size(idx, dest.size());
+        detail::check(::read_marker_ticks_into(ptr_.get(), idx, dest.data()),
+            "read_marker_ticks_into");
+    }
+
+    EventChannel read_marker_timestamps(int idx)
+    {
+        return EventChannel(detail::check(
+            read_marker_timestamps_from_file(ptr_.get(), idx),
+            "read_marker_timestamps_from_file"));
+    }
+
+    /* ---------------------------------------------------------------------- */
+    /*<chunk> items at a time, see Cursor. the cursor reads through this file,
+      which must outlive it*/
+    template <class T>
+    Cursor<T> chunks(int idx, std::size_t chunk)
+    {
+        return Cursor<T>(detail::check(open_channel_cursor_from_file(ptr_.get(),
+            idx, chunk), "open_channel_cursor_from_file"));
+    }
+
+private:
+    void check_size(int idx, std::size_t size)
+    {
+        if (size < item_count(idx))
+        {
+            throw error("destination is smaller than the channel");
+        }
+    }
+};
+/* ========================================================================== */
+} /*namespace smr*/
+
+#endif
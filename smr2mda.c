@@ -176,50 +176,44 @@ void write_mda_header(FILE *fp, int32_t nchan, int32_t npt)
     fwrite(&npt, sizeof(npt), 1, fp);
 }
 /* -------------------------------------------------------------------------- */
-int get_channel_type(const char* smrfile, int idx)
+int get_channel_type(struct SMRFile* f, int idx)
 {
-    struct SMRChannelInfoArray* ifo = read_channel_array(smrfile);
+    struct SMRChannelHeader* chdr = get_channel_header(f, idx);
 
-    int type = -1;
-
-    if (ifo != NULL)
-    {
-        for (size_t k = 0; k < ifo->length; ++k)
-        {
-            if (ifo->ifo[k]->index == idx)
-            {
-                type = (int)ifo->ifo[k]->kind;
-                break;
-            }
-        }
-        free_channel_info_array(ifo);
-    }
-    return type;
+    return chdr != NULL ? (int)chdr->kind : -1;
 }
 /* -------------------------------------------------------------------------- */
-double get_sampling_rate(const char* smrfile, int idx)
+double get_sampling_rate(struct SMRFile* f, int idx)
 {
-    double fs = 0.0;
-
-    struct SMRFileHeader* fhdr = read_file_header(smrfile);
-
-    if (fhdr != NULL)
-    {
-        fs = MICROSECONDS / get_sample_interval(fhdr, idx);
-        free_file_header(fhdr);
-    }
-    else
+    return MICROSECONDS / get_sample_interval(f->fhdr, idx);
+}
+/* -------------------------------------------------------------------------- */
+void print_io_stats(struct SMRIOStats* st)
+{
+    double mb = (double)st->bytes_read / (1024.0 * 1024.0);
+    double total = st->parse_time + st->walk_time + st->decode_time;
+
+    printf("[STATS]: bytes read:    %llu (%.2f MB)\n", (unsigned long long)st->bytes_read, mb);
+    printf("[STATS]: read calls:    %llu\n", (unsigned long long)st->nread);
+    printf("[STATS]: seeks:         %llu\n", (unsigned long long)st->nseek);
+    printf("[STATS]: blocks:        %llu\n", (unsigned long long)st->nblock);
+    printf("[STATS]: header parse:  %.3f ms\n", st->parse_time * 1e3);
+    printf("[STATS]: block walk:    %.3f ms\n", st->walk_time * 1e3);
+    printf("[STATS]: decode:        %.3f ms\n", st->decode_time * 1e3);
+    printf("[STATS]:   convert:     %.3f ms\n", st->convert_time * 1e3);
+    printf("[STATS]: fread / fseek: %.3f ms\n", st->io_time * 1e3);
+
+    if (total > 0.0)
     {
-        printf("[WARN]: Failed to find sampling rate for channel %d", idx);
+        printf("[STATS]: throughput:    %.1f MB/s\n", mb / total);
     }
-    return fs;
 }
 /* -------------------------------------------------------------------------- */
-int write_wavemark(FILE* fp, const char* smrfile, int idx,
+int write_wavemark(FILE* fp, struct SMRFile* f, int idx,
     int write_header, size_t nchan, uint32_t* npt, double* fs)
 {
     int success = 0;
-    struct SMRWMrkChannel* wmrk = read_wavemark_channel(smrfile, idx);
+    struct SMRWMrkChannel* wmrk = read_wavemark_channel_from_file(f, idx);
 
     if (wmrk != NULL)
     {
@@ -251,18 +245,18 @@ int write_wavemark(FILE* fp, const char* smrfile, int idx,
             show_error("Not all channels have the same # of samples!");
         }
 
-        *fs = get_sampling_rate(smrfile, idx);
+        *fs = get_sampling_rate(f, idx);
         free_wavemark_channel(wmrk);
     }
 
     return success;
 }
 /* -------------------------------------------------------------------------- */
-int write_continuous(FILE* fp, const char* smrfile, int idx,
+int write_continuous(FILE* fp, struct SMRFile* f, int idx,
     int write_header, size_t nchan, uint32_t* npt, double* fs)
 {
     int success = 0;
-    struct SMRContChannel* cont = read_continuous_channel(smrfile, idx);
+    struct SMRContChannel* cont = read_continuous_channel_from_file(f, idx);
 
     if (cont != NULL)
     {
@@ -289,7 +283,8 @@ int write_continuous(FILE* fp, const char* smrfile, int idx,
     return success;
 }
 /* -------------------------------------------------------------------------- */
-int write_mda(const char* smrfile, const char* mdafile, IntArray* channels)
+int write_mda(const char* smrfile, const char* mdafile, IntArray* channels,
+    int flags)
 {
     int exit_code = 0;
 
@@ -302,6 +297,15 @@ int write_mda(const char* smrfile, const char* mdafile, IntArray* channels)
         return exit_code;
     }
 
+    struct SMRFile *f = open_smr_file(smrfile, flags);
+
+    if (f == NULL)
+    {
+        show_error("Failed to open smr file!");
+        printf("    Invalid file: %s\n", smrfile);
+        return -6;
+    }
+
     FILE *mda_fp = open_file(mdafile, FILE_WRITE_MODE);
 
     if (mda_fp != NULL)
@@ -313,12 +317,12 @@ int write_mda(const char* smrfile, const char* mdafile, IntArray* channels)
         {
             int write_header = k == 0 ? 1 : 0;
 
-            int type = get_channel_type(smrfile, channels->data[k]);
+            int type = get_channel_type(f, channels->data[k]);
 
             switch (type)
             {
                 case CONTINUOUS_CHANNEL:
-                    success = write_continuous(mda_fp, smrfile, channels->data[k],
+                    success = write_continuous(mda_fp, f, channels->data[k],
                         write_header, channels->length, &npt, &sampling_rate);
                     break;
 
@@ -330,7 +334,7 @@ int write_mda(const char* smrfile, const char* mdafile, IntArray* channels)
                     }
                     else
                     {
-                        success = write_wavemark(mda_fp, smrfile,
+                        success = write_wavemark(mda_fp, f,
                             channels->data[k], write_header, channels->length,
                             &npt, &sampling_rate);
                     }
@@ -386,6 +390,13 @@ int write_mda(const char* smrfile, const char* mdafile, IntArray* channels)
         exit_code = -2;
     }
 
+    if (flags & SMR_IO_STATS)
+    {
+        print_io_stats(get_io_stats(f));
+    }
+
+    close_smr_file(f);
+
     return exit_code;
 }
 /* -------------------------------------------------------------------------- */
@@ -397,6 +408,11 @@ void usage()
         "\n"
         "Options:\n"
         "    l       - print channel info for <smrfile> (output optional)\n"
+        "    v       - print I/O statistics after converting\n"
+        "    d       - read <smrfile> without filling the page cache (direct\n"
+        "              reads where supported), for bulk conversions on shared\n"
+        "              machines\n"
+        "              (v and d must precede all other options)\n"
         "    c [idx] - only include channels from <smrfile> with indicies\n"
         "              [idx] in output. [idx] should be a comma seperated\n"
         "              list of integer channel indicies (e.g. \"1,2\")\n"
@@ -416,12 +432,26 @@ void usage()
         "    #only convert channels 12 and 13 (NOTE: these are the channel INDICIES)\n"
         "    smr2mda -c \"12,13\" ./b1_con_006.smr ./test2.mda\n"
         "\n"
+        "    #convert all continuous channels and report where the time went\n"
+        "    smr2mda -v ./b1_con_006.smr ./test.mda\n"
+        "\n"
+        "    #nightly conversion that leaves the page cache alone\n"
+        "    smr2mda -d ./b1_con_006.smr ./test.mda\n"
+        "\n"
     );
 }
 /* -------------------------------------------------------------------------- */
 int main(int argc, char const *argv[]) {
 
     int exit_code = 0;
+    int flags = 0;
+
+    while (argc > 1 && (strcmp(argv[1], "-v") == 0 || strcmp(argv[1], "-d") == 0))
+    {
+        flags |= argv[1][1] == 'v' ? SMR_IO_STATS : SMR_IO_DIRECT;
+        ++argv;
+        --argc;
+    }
 
     if (argc < 2)
     {
@@ -449,7 +479,7 @@ int main(int argc, char const *argv[]) {
                     IntArray *channels = get_indicies_from_list(argv[2]);
                     if (channels != NULL)
                     {
-                        exit_code = write_mda(argv[3], argv[4], channels);
+                        exit_code = write_mda(argv[3], argv[4], channels, flags);
                     }
                     free_int_array(channels);
                 }
@@ -466,7 +496,7 @@ int main(int argc, char const *argv[]) {
         IntArray *channels = get_continuous_indicies(argv[1]);
         if (channels != NULL)
         {
-            exit_code = write_mda(argv[1], argv[2], channels);
+            exit_code = write_mda(argv[1], argv[2], channels, flags);
         }
         free_int_array(channels);
     }
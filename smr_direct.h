@@ -0,0 +1,279 @@
+#ifndef _SMR_DIRECT_H
+#define _SMR_DIRECT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "smr_uring.h"
+
+/* =============================================================================
+page cache friendly reads for cold bulk scans. on Linux channel data is read
+with O_DIRECT through a large aligned staging buffer and copied out to the
+decoders, on macOS the descriptor is marked F_NOCACHE instead. wherever
+direct reads are unavailable (other platforms, file systems that reject
+O_DIRECT) direct_open() returns NULL, callers stay on stdio and use
+drop_file_cache() to release the pages they read
+============================================================================= */
+#if defined(__linux__) || defined(__APPLE__)
+#define SMR_HAVE_DIRECT_IO 1
+#endif
+
+/*alignment of direct reads (offset, length and buffer), covers the logical
+  block size of any device we are likely to see*/
+#define DIRECT_ALIGN 4096
+
+/*size of the staging buffer, i.e. the largest single direct read*/
+#define DIRECT_STAGE_SIZE (4 << 20)
+
+/*reads separated by less than this are merged into one direct read, larger
+  gaps (usually other channels' blocks) are skipped*/
+#define DIRECT_MAX_GAP (64 << 10)
+
+#if defined(SMR_HAVE_DIRECT_IO)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+struct SMRDirect
+{
+    int fd;
+    uint8_t *stage;
+};
+/* -------------------------------------------------------------------------- */
+struct SMRDirect *direct_open(const char *path)
+{
+    struct SMRDirect *d;
+    void *stage = NULL;
+    int fd;
+
+#if defined(__APPLE__)
+    if ((fd = open(path, O_RDONLY)) < 0)
+    {
+        return NULL;
+    }
+
+    if (fcntl(fd, F_NOCACHE, 1) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+#else
+    /*fails with EINVAL on file systems without direct I/O (e.g. tmpfs)*/
+    if ((fd = open(path, O_RDONLY | O_DIRECT)) < 0)
+    {
+        return NULL;
+    }
+#endif
+
+    if (posix_memalign(&stage, DIRECT_ALIGN, DIRECT_STAGE_SIZE) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    d = malloc(sizeof (struct SMRDirect));
+
+    d->fd = fd;
+    d->stage = stage;
+
+    return d;
+}
+/* -------------------------------------------------------------------------- */
+void direct_close(struct SMRDirect *d)
+{
+    if (d)
+    {
+        close(d->fd);
+        free(d->stage);
+        free(d);
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*fill the staging buffer with <length> bytes (a multiple of DIRECT_ALIGN)
+  from the aligned offset <start>, returns the # of bytes actually read,
+  which is less than <length> only at the end of the file*/
+static int64_t direct_fill(struct SMRDirect *d, int64_t start, size_t length)
+{
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < length)
+    {
+        n = pread(d->fd, d->stage + done, length - done, (off_t) (start + done));
+
+        if (n < 0)
+        {
+            return -1;
+        }
+        else if (n == 0)
+        {
+            break;
+        }
+
+        done += (size_t) n;
+
+        /*a short direct read is only legal at end of file*/
+        if (done % DIRECT_ALIGN != 0)
+        {
+            break;
+        }
+    }
+
+    return (int64_t) done;
+}
+/* -------------------------------------------------------------------------- */
+/*perform the <n> reads in <reqs>, neighbouring reads are merged into one
+  aligned read of up to DIRECT_STAGE_SIZE bytes. <nread> and <nbyte> receive
+  the # of direct reads issued and bytes transferred. returns 0 on success*/
+int direct_read_all(struct SMRDirect *d, struct BlockRead *reqs, size_t n,
+    uint64_t *nread, uint64_t *nbyte)
+{
+    size_t k = 0;
+    size_t j, last;
+    int64_t start, end, got;
+    int64_t offset;
+    size_t length, copied;
+
+    while (k < n)
+    {
+        if (reqs[k].length == 0)
+        {
+            ++k;
+            continue;
+        }
+
+        start = reqs[k].offset - (reqs[k].offset % DIRECT_ALIGN);
+        end = reqs[k].offset + (int64_t) reqs[k].length;
+        last = k;
+
+        /*extend the window over following reads that are close by*/
+        for (j = k + 1; j < n; ++j)
+        {
+            int64_t stop = reqs[j].offset + (int64_t) reqs[j].length;
+
+            if (reqs[j].offset < end || reqs[j].offset - end > DIRECT_MAX_GAP ||
+                stop - start > DIRECT_STAGE_SIZE)
+            {
+                break;
+            }
+
+            end = stop;
+            last = j;
+        }
+
+        if (end - start > DIRECT_STAGE_SIZE)
+        {
+            /*a single read larger than the staging buffer: stream it through
+              in buffer sized pieces*/
+            offset = reqs[k].offset;
+            copied = 0;
+
+            while (copied < reqs[k].length)
+            {
+                start = offset - (offset % DIRECT_ALIGN);
+                got = direct_fill(d, start, DIRECT_STAGE_SIZE);
+
+                length = reqs[k].length - copied;
+                if ((int64_t) length > start + DIRECT_STAGE_SIZE - offset)
+                {
+                    length = (size_t) (start + DIRECT_STAGE_SIZE - offset);
+                }
+
+                if (got < offset - start + (int64_t) length)
+                {
+                    return -1;
+                }
+
+                memcpy(reqs[k].dest + copied, d->stage + (offset - start), length);
+
+                copied += length;
+                offset += (int64_t) length;
+
+                *nread += 1;
+                *nbyte += (uint64_t) got;
+            }
+
+            ++k;
+            continue;
+        }
+
+        length = (size_t) (end - start);
+        length += (DIRECT_ALIGN - (length % DIRECT_ALIGN)) % DIRECT_ALIGN;
+
+        got = direct_fill(d, start, length);
+
+        if (got < end - start)
+        {
+            return -1;
+        }
+
+        *nread += 1;
+        *nbyte += (uint64_t) got;
+
+        for (j = k; j <= last; ++j)
+        {
+            memcpy(reqs[j].dest, d->stage + (reqs[j].offset - start), reqs[j].length);
+        }
+
+        k = last + 1;
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
+/*hint that <fp> will be read front to back*/
+void advise_sequential(FILE *fp)
+{
+#if defined(__linux__)
+    posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+    (void) fp;
+#endif
+}
+/* -------------------------------------------------------------------------- */
+/*release any pages of <fp> held in the page cache*/
+void drop_file_cache(FILE *fp)
+{
+#if defined(__linux__)
+    posix_fadvise(fileno(fp), 0, 0, POSIX_FADV_DONTNEED);
+#else
+    (void) fp;
+#endif
+}
+/* -------------------------------------------------------------------------- */
+#else
+
+struct SMRDirect;
+/* -------------------------------------------------------------------------- */
+struct SMRDirect *direct_open(const char *path)
+{
+    (void) path;
+    return NULL;
+}
+/* -------------------------------------------------------------------------- */
+void direct_close(struct SMRDirect *d)
+{
+    (void) d;
+}
+/* -------------------------------------------------------------------------- */
+int direct_read_all(struct SMRDirect *d, struct BlockRead *reqs, size_t n,
+    uint64_t *nread, uint64_t *nbyte)
+{
+    (void) d; (void) reqs; (void) n; (void) nread; (void) nbyte;
+    return -1;
+}
+/* -------------------------------------------------------------------------- */
+void advise_sequential(FILE *fp)
+{
+    (void) fp;
+}
+/* -------------------------------------------------------------------------- */
+void drop_file_cache(FILE *fp)
+{
+    (void) fp;
+}
+/* -------------------------------------------------------------------------- */
+#endif
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef _SMR_FILTER_H
+#define _SMR_FILTER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* =============================================================================
+filter design and application for the streaming continuous channel readers:
+linear phase (symmetric) windowed-sinc FIR filters, whose dot product uses
+SSE / NEON where available, and Butterworth IIR filters as cascades of
+second order sections
+============================================================================= */
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define SMR_HAVE_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SMR_HAVE_NEON 1
+#endif
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/*# of zero crossings of the anti-alias filter on either side of its center,
+  the filter is 2 * DECIMATE_ZEROS * factor + 1 taps long*/
+#define DECIMATE_ZEROS 12
+
+/*largest decimation factor, i.e. an anti-alias filter of at most ~1.2 MB*/
+#define DECIMATE_MAX_FACTOR 12500
+
+/*anti-alias cutoff as a fraction of the output Nyquist frequency*/
+#define DECIMATE_CUTOFF 0.8
+
+/*a second order section in transposed direct form II, <z1> and <z2> carry
+  the filter state from one sample (and block) to the next*/
+struct Biquad
+{
+    double b0, b1, b2;
+    double a1, a2;
+    double z1, z2;
+};
+
+/* -------------------------------------------------------------------------- */
+/*<ntap> (odd) tap Blackman windowed-sinc low pass filter with cutoff
+  <cutoff> in cycles per sample (0 - 0.5), normalized to unity gain at DC*/
+float *lowpass_fir(double cutoff, size_t ntap)
+{
+    float *h = malloc(sizeof (float) * ntap);
+    double center = (double) (ntap - 1) / 2.0;
+    double total = 0.0;
+    double x, w;
+    size_t k;
+
+    for (k = 0; k < ntap; ++k)
+    {
+        x = (double) k - center;
+        w = 0.42 - 0.5 * cos(2.0 * M_PI * (double) k / (double) (ntap - 1)) +
+            0.08 * cos(4.0 * M_PI * (double) k / (double) (ntap - 1));
+
+        if (x == 0.0)
+        {
+            h[k] = (float) (2.0 * cutoff * w);
+        }
+        else
+        {
+            h[k] = (float) (sin(2.0 * M_PI * cutoff * x) / (M_PI * x) * w);
+        }
+
+        total += (double) h[k];
+    }
+
+    for (k = 0; k < ntap; ++k)
+    {
+        h[k] = (float) ((double) h[k] / total);
+    }
+
+    return h;
+}
+/* -------------------------------------------------------------------------- */
+/*sum(a .* b) over <n> elements*/
+float fir_dot(const float *a, const float *b, size_t n)
+{
+    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float total;
+    size_t k = 0;
+
+#if defined(SMR_HAVE_SSE)
+    __m128 acc = _mm_setzero_ps();
+
+    for (; k + 4 <= n; k += 4)
+    {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + k), _mm_loadu_ps(b + k)));
+    }
+
+    _mm_storeu_ps(lanes, acc);
+#elif defined(SMR_HAVE_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+
+    for (; k + 4 <= n; k += 4)
+    {
+        acc = vmlaq_f32(acc, vld1q_f32(a + k), vld1q_f32(b + k));
+    }
+
+    vst1q_f32(lanes, acc);
+#else
+    for (; k + 4 <= n; k += 4)
+    {
+        lanes[0] += a[k] * b[k];
+        lanes[1] += a[k+1] * b[k+1];
+        lanes[2] += a[k+2] * b[k+2];
+        lanes[3] += a[k+3] * b[k+3];
+    }
+#endif
+
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+
+    for (; k < n; ++k)
+    {
+        total += a[k] * b[k];
+    }
+
+    return total;
+}
+/* -------------------------------------------------------------------------- */
+/*round and saturate to the int16 range of continuous channels*/
+int16_t saturate_int16(float x)
+{
+    x = x < 0.0f ? x - 0.5f : x + 0.5f;
+
+    if (x >= 32767.0f)
+    {
+        return INT16_MAX;
+    }
+    else if (x <= -32768.0f)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t) x;
+}
+/* -------------------------------------------------------------------------- */
+/*append the <order> / 2 sections of a Butterworth high (<highpass> != 0) or
+  low pass filter with corner <fc> Hz at sampling rate <fs> to <s>, returns
+  the # of sections written*/
+int butterworth_sections(struct Biquad *s, int order, double fc, double fs,
+    int highpass)
+{
+    double w0 = 2.0 * M_PI * fc / fs;
+    double cw = cos(w0);
+    double alpha, a0, q;
+    int k;
+
+    for (k = 0; k < order / 2; ++k)
+    {
+        /*pole pair k of the analog prototype, the bilinear transform is
+          prewarped at <fc> for every section*/
+        q = 1.0 / (2.0 * cos(M_PI * (double) (2 * k + 1) / (double) (2 * order)));
+        alpha = sin(w0) / (2.0 * q);
+        a0 = 1.0 + alpha;
+
+        if (highpass)
+        {
+            s[k].b0 = (1.0 + cw) / 2.0 / a0;
+            s[k].b1 = -(1.0 + cw) / a0;
+        }
+        else
+        {
+            s[k].b0 = (1.0 - cw) / 2.0 / a0;
+            s[k].b1 = (1.0 - cw) / a0;
+        }
+
+        s[k].b2 = s[k].b0;
+        s[k].a1 = -2.0 * cw / a0;
+        s[k].a2 = (1.0 - alpha) / a0;
+        s[k].z1 = 0.0;
+        s[k].z2 = 0.0;
+    }
+
+    return order / 2;
+}
+/* -------------------------------------------------------------------------- */
+/*set the state of the cascade to its steady state for a constant input <x>,
+  so that e.g. a DC offset at the start of a recording doesn't ring*/
+void biquad_settle(struct Biquad *s, int n, double x)
+{
+    double y;
+    int k;
+
+    for (k = 0; k < n; ++k)
+    {
+        y = x * (s[k].b0 + s[k].b1 + s[k].b2) / (1.0 + s[k].a1 + s[k].a2);
+
+        s[k].z2 = s[k].b2 * x - s[k].a2 * y;
+        s[k].z1 = s[k].b1 * x - s[k].a1 * y + s[k].z2;
+
+        x = y;
+    }
+}
+/* -------------------------------------------------------------------------- */
+/*filter the <n> samples in <x> in place through the <nsec> sections*/
+void biquad_filter(struct Biquad *s, int nsec, double *x, size_t n)
+{
+    double b0, b1, b2, a1, a2, z1, z2, y;
+    size_t j;
+    int k;
+
+    /*one section at a time over the whole block keeps the coefficients and
+      state in registers*/
+    for (k = 0; k < nsec; ++k)
+    {
+        b0 = s[k].b0; b1 = s[k].b1; b2 = s[k].b2;
+        a1 = s[k].a1; a2 = s[k].a2;
+        z1 = s[k].z1; z2 = s[k].z2;
+
+        for (j = 0; j < n; ++j)
+        {
+            y = b0 * x[j] + z1;
+            z1 = b1 * x[j] - a1 * y + z2;
+            z2 = b2 * x[j] - a2 * y;
+            x[j] = y;
+        }
+
+        s[k].z1 = z1;
+        s[k].z2 = z2;
+    }
+}
+/* -------------------------------------------------------------------------- */
+#endif
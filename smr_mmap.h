@@ -0,0 +1,135 @@
+#ifndef _SMR_MMAP_H
+#define _SMR_MMAP_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+/* =============================================================================
+read-only memory maps of an open smr file, for readers that pick a few bytes
+out of every record (e.g. the ticks of wavemark records) and would otherwise
+copy whole block payloads out of the page cache. map_file() returns NULL
+wherever mapping is unavailable or fails, callers then fall back to reading
+the blocks through stdio
+============================================================================= */
+#if defined(__linux__) || defined(__APPLE__)
+#define SMR_HAVE_MMAP 1
+#endif
+
+struct SMRMap
+{
+    const uint8_t *base;
+    size_t size;
+
+#if defined(_WIN32)
+    void *mapping;
+#endif
+};
+
+#if defined(SMR_HAVE_MMAP)
+
+#include <sys/mman.h>
+/* -------------------------------------------------------------------------- */
+/*map the first <size> bytes of <fp>*/
+struct SMRMap *map_file(FILE *fp, int64_t size)
+{
+    struct SMRMap *m;
+    void *ptr;
+
+    if (size <= 0)
+    {
+        return NULL;
+    }
+
+    ptr = mmap(NULL, (size_t) size, PROT_READ, MAP_SHARED, fileno(fp), 0);
+
+    if (ptr == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    /*records are visited front to back*/
+    madvise(ptr, (size_t) size, MADV_SEQUENTIAL);
+
+    m = malloc(sizeof (struct SMRMap));
+
+    m->base = ptr;
+    m->size = (size_t) size;
+
+    return m;
+}
+/* -------------------------------------------------------------------------- */
+void unmap_file(struct SMRMap *m)
+{
+    if (m)
+    {
+        munmap((void *) m->base, m->size);
+        free(m);
+    }
+}
+/* -------------------------------------------------------------------------- */
+#elif defined(_WIN32)
+
+#include <windows.h>
+#include <io.h>
+/* -------------------------------------------------------------------------- */
+struct SMRMap *map_file(FILE *fp, int64_t size)
+{
+    struct SMRMap *m;
+    HANDLE mapping;
+    void *ptr;
+
+    if (size <= 0 || (uint64_t) size > (uint64_t) SIZE_MAX)
+    {
+        return NULL;
+    }
+
+    mapping = CreateFileMappingA((HANDLE) _get_osfhandle(_fileno(fp)), NULL,
+        PAGE_READONLY, 0, 0, NULL);
+
+    if (mapping == NULL)
+    {
+        return NULL;
+    }
+
+    if ((ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T) size)) == NULL)
+    {
+        CloseHandle(mapping);
+        return NULL;
+    }
+
+    m = malloc(sizeof (struct SMRMap));
+
+    m->base = ptr;
+    m->size = (size_t) size;
+    m->mapping = mapping;
+
+    return m;
+}
+/* -------------------------------------------------------------------------- */
+void unmap_file(struct SMRMap *m)
+{
+    if (m)
+    {
+        UnmapViewOfFile(m->base);
+        CloseHandle(m->mapping);
+        free(m);
+    }
+}
+/* -------------------------------------------------------------------------- */
+#else
+/* -------------------------------------------------------------------------- */
+struct SMRMap *map_file(FILE *fp, int64_t size)
+{
+    (void) fp; (void) size;
+    return NULL;
+}
+/* -------------------------------------------------------------------------- */
+void unmap_file(struct SMRMap *m)
+{
+    (void) m;
+}
+/* -------------------------------------------------------------------------- */
+#endif
+
+#endif
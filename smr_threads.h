@@ -0,0 +1,102 @@
+#ifndef _SMR_THREADS_H
+#define _SMR_THREADS_H
+
+/* =============================================================================
+minimal portable threading layer: statically initializable mutexes and
+condition variables plus thread create / join. pthreads everywhere except
+Windows, where slim reader / writer locks and condition variables are used
+============================================================================= */
+#if defined(_WIN32)
+
+#include <windows.h>
+
+typedef SRWLOCK smr_mutex_t;
+typedef CONDITION_VARIABLE smr_cond_t;
+typedef HANDLE smr_thread_t;
+
+#define SMR_MUTEX_INIT SRWLOCK_INIT
+#define SMR_COND_INIT CONDITION_VARIABLE_INIT
+
+/*declare / define a thread entry point taking a single void pointer <arg>*/
+#define SMR_THREAD_FUNC(name) DWORD WINAPI name(LPVOID arg)
+#define SMR_THREAD_RETURN return 0
+
+#else
+
+#include <pthread.h>
+
+typedef pthread_mutex_t smr_mutex_t;
+typedef pthread_cond_t smr_cond_t;
+typedef pthread_t smr_thread_t;
+
+#define SMR_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+#define SMR_COND_INIT PTHREAD_COND_INITIALIZER
+
+#define SMR_THREAD_FUNC(name) void *name(void *arg)
+#define SMR_THREAD_RETURN return NULL
+
+#endif
+/* ========================================================================= */
+void mutex_lock(smr_mutex_t *m)
+{
+#if defined(_WIN32)
+    AcquireSRWLockExclusive(m);
+#else
+    pthread_mutex_lock(m);
+#endif
+}
+/* ------------------------------------------------------------------------- */
+void mutex_unlock(smr_mutex_t *m)
+{
+#if defined(_WIN32)
+    ReleaseSRWLockExclusive(m);
+#else
+    pthread_mutex_unlock(m);
+#endif
+}
+/* ------------------------------------------------------------------------- */
+/*<m> must be locked by the caller*/
+void cond_wait(smr_cond_t *c, smr_mutex_t *m)
+{
+#if defined(_WIN32)
+    SleepConditionVariableSRW(c, m, INFINITE, 0);
+#else
+    pthread_cond_wait(c, m);
+#endif
+}
+/* ------------------------------------------------------------------------- */
+void cond_broadcast(smr_cond_t *c)
+{
+#if defined(_WIN32)
+    WakeAllConditionVariable(c);
+#else
+    pthread_cond_broadcast(c);
+#endif
+}
+/* ------------------------------------------------------------------------- */
+/*returns 0 on success*/
+#if defined(_WIN32)
+int thread_create(smr_thread_t *t, LPTHREAD_START_ROUTINE func, void *arg)
+{
+    *t = CreateThread(NULL, 0, func, arg, 0, NULL);
+
+    return *t != NULL ? 0 : -1;
+}
+#else
+int thread_create(smr_thread_t *t, void *(*func)(void *), void *arg)
+{
+    return pthread_create(t, NULL, func, arg);
+}
+#endif
+/* ------------------------------------------------------------------------- */
+void thread_join(smr_thread_t t)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(t, INFINITE);
+    CloseHandle(t);
+#else
+    pthread_join(t, NULL);
+#endif
+}
+/* ========================================================================= */
+#endif
@@ -0,0 +1,291 @@
+#ifndef _SMR_URING_H
+#define _SMR_URING_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/* =============================================================================
+minimal io_uring driver (raw syscalls, no liburing) used to fetch the data
+blocks of a channel with many reads in flight at once. only built on Linux
+when the kernel headers provide <linux/io_uring.h>, elsewhere uring_open()
+returns NULL and callers stay on stdio
+============================================================================= */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define SMR_HAVE_IO_URING 1
+#endif
+#endif
+
+/*# of reads kept in flight*/
+#define URING_QUEUE_DEPTH 64
+
+/*a single positioned read: <length> bytes at file offset <offset> to <dest>*/
+struct BlockRead
+{
+    int64_t offset;
+    size_t length;
+    uint8_t *dest;
+};
+
+#if defined(SMR_HAVE_IO_URING)
+
+#include <errno.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+struct SMRUring
+{
+    int fd;
+    unsigned int depth;
+
+    uint8_t *sq_ptr;
+    size_t sq_size;
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_mask;
+    unsigned int *sq_array;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    uint8_t *cq_ptr;
+    size_t cq_size;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_mask;
+    struct io_uring_cqe *cqes;
+};
+/* ========================================================================= */
+void uring_close(struct SMRUring *ring)
+{
+    if (ring)
+    {
+        if (ring->sqes != NULL) { munmap(ring->sqes, ring->sqes_size); }
+
+        if (ring->cq_ptr != NULL && ring->cq_ptr != ring->sq_ptr)
+        {
+            munmap(ring->cq_ptr, ring->cq_size);
+        }
+
+        if (ring->sq_ptr != NULL) { munmap(ring->sq_ptr, ring->sq_size); }
+
+        if (ring->fd >= 0) { close(ring->fd); }
+
+        free(ring);
+    }
+}
+/* ------------------------------------------------------------------------- */
+/*NULL if io_uring is not available (old kernel, seccomp, ...)*/
+struct SMRUring *uring_open(unsigned int depth)
+{
+    struct io_uring_params p;
+    struct SMRUring *ring = calloc(1, sizeof (struct SMRUring));
+    void *ptr;
+
+    memset(&p, 0, sizeof (p));
+
+    ring->depth = depth;
+    ring->fd = (int) syscall(__NR_io_uring_setup, depth, &p);
+
+    if (ring->fd < 0)
+    {
+        free(ring);
+        return NULL;
+    }
+
+    ring->sq_size = p.sq_off.array + (p.sq_entries * sizeof (unsigned int));
+    ring->cq_size = p.cq_off.cqes + (p.cq_entries * sizeof (struct io_uring_cqe));
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (ring->cq_size > ring->sq_size) { ring->sq_size = ring->cq_size; }
+        ring->cq_size = ring->sq_size;
+    }
+
+    ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+
+    if (ptr == MAP_FAILED) { uring_close(ring); return NULL; }
+
+    ring->sq_ptr = ptr;
+
+    if (p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        ring->cq_ptr = ring->sq_ptr;
+    }
+    else
+    {
+        ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+
+        if (ptr == MAP_FAILED) { uring_close(ring); return NULL; }
+
+        ring->cq_ptr = ptr;
+    }
+
+    ring->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+
+    ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+
+    if (ptr == MAP_FAILED) { uring_close(ring); return NULL; }
+
+    ring->sqes = ptr;
+
+    ring->sq_head = (unsigned int *) (ring->sq_ptr + p.sq_off.head);
+    ring->sq_tail = (unsigned int *) (ring->sq_ptr + p.sq_off.tail);
+    ring->sq_mask = (unsigned int *) (ring->sq_ptr + p.sq_off.ring_mask);
+    ring->sq_array = (unsigned int *) (ring->sq_ptr + p.sq_off.array);
+
+    ring->cq_head = (unsigned int *) (ring->cq_ptr + p.cq_off.head);
+    ring->cq_tail = (unsigned int *) (ring->cq_ptr + p.cq_off.tail);
+    ring->cq_mask = (unsigned int *) (ring->cq_ptr + p.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe *) (ring->cq_ptr + p.cq_off.cqes);
+
+    return ring;
+}
+/* ------------------------------------------------------------------------- */
+/*perform all <n> reads from <fp> (bypassing its stdio buffer), keeping up to <ring->depth> in flight and
+  completing them in whatever order the kernel finishes them. short reads are
+  finished with pread. returns 0 on success, on failure every read that was
+  submitted has still completed (the destinations are no longer written to)*/
+int uring_read_all(struct SMRUring *ring, FILE *fp, struct BlockRead *reqs,
+    size_t n)
+{
+    int fd = fileno(fp);
+    size_t next = 0;
+    size_t inflight = 0;
+    unsigned int pending = 0; /*queued but not yet accepted by the kernel*/
+    unsigned int head;
+    unsigned int tail;
+    int err = 0;
+    int dead = 0;
+    int ret;
+
+    while (inflight > 0 || (next < n && !err))
+    {
+        /*queue as many reads as the ring has room for*/
+        tail = *ring->sq_tail;
+        head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+
+        while (!err && next < n && inflight < ring->depth &&
+            (tail - head) <= *ring->sq_mask)
+        {
+            unsigned int slot = tail & *ring->sq_mask;
+            struct io_uring_sqe *sqe = ring->sqes + slot;
+
+            memset(sqe, 0, sizeof (struct io_uring_sqe));
+
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fd;
+            sqe->off = (uint64_t) reqs[next].offset;
+            sqe->addr = (uint64_t) (uintptr_t) reqs[next].dest;
+            sqe->len = (uint32_t) reqs[next].length;
+            sqe->user_data = (uint64_t) next;
+
+            ring->sq_array[slot] = slot;
+
+            ++tail;
+            ++next;
+            ++inflight;
+            ++pending;
+        }
+
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+        if (!dead)
+        {
+            ret = (int) syscall(__NR_io_uring_enter, ring->fd, pending, 1,
+                IORING_ENTER_GETEVENTS, NULL, 0);
+
+            if (ret >= 0)
+            {
+                pending -= (unsigned int) ret;
+            }
+            else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+            {
+                /*retract what the kernel has not picked up (it only reads
+                  the submission queue inside io_uring_enter) and wait for
+                  the rest by polling the completion queue below*/
+                __atomic_store_n(ring->sq_tail, *ring->sq_head, __ATOMIC_RELEASE);
+                inflight -= pending;
+                pending = 0;
+                dead = 1;
+                err = 1;
+            }
+        }
+        else
+        {
+            sched_yield();
+        }
+
+        /*reap completions*/
+        head = *ring->cq_head;
+        tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+
+        while (head != tail)
+        {
+            struct io_uring_cqe *cqe = ring->cqes + (head & *ring->cq_mask);
+            struct BlockRead *req = reqs + cqe->user_data;
+            int res = cqe->res;
+
+            if (res < 0)
+            {
+                err = 1;
+            }
+            else if ((size_t) res < req->length)
+            {
+                size_t done = (size_t) res;
+
+                while (done < req->length)
+                {
+                    ssize_t nr = pread(fd, req->dest + done,
+                        req->length - done, (off_t) (req->offset + done));
+
+                    if (nr <= 0) { err = 1; break; }
+
+                    done += (size_t) nr;
+                }
+            }
+
+            ++head;
+            --inflight;
+        }
+
+        __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    return err ? -1 : 0;
+}
+/* ========================================================================= */
+#else
+/* ========================================================================= */
+struct SMRUring
+{
+    int fd;
+};
+/* ------------------------------------------------------------------------- */
+struct SMRUring *uring_open(unsigned int depth)
+{
+    (void) depth;
+    return NULL;
+}
+/* ------------------------------------------------------------------------- */
+void uring_close(struct SMRUring *ring)
+{
+    (void) ring;
+}
+/* ------------------------------------------------------------------------- */
+int uring_read_all(struct SMRUring *ring, FILE *fp, struct BlockRead *reqs,
+    size_t n)
+{
+    (void) ring; (void) fp; (void) reqs; (void) n;
+    return -1;
+}
+/* ========================================================================= */
+#endif
+#endif
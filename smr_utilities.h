@@ -6,6 +6,17 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "smr.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
 
 /* NOTE
     mode to open smr file for reading, on windows this *MUST* be "rb" as just
@@ -14,6 +25,7 @@
     see: <http://stackoverflow.com/questions/3187693/fread-ftell-apparently-broken-under-windows-works-fine-under-linux>
 */
 #define FILE_READ_MODE "rb"
+#define FILE_WRITE_MODE "wb"
 
 #define gotto() (printf("GOTO: %s [%d]\n", __FUNCTION__, __LINE__))
 #define show(v, fmt) (printf(#v " = " fmt "\n", v))
@@ -32,6 +44,108 @@ FILE * open_file(const char *ifile, const char *mode)
     return fp;
 }
 /* ========================================================================= */
+/* the stamp (see struct SMRFileStamp) of <ifile>, used to validate caches of
+   data derived from an smr file. returns 0 on success */
+int get_file_stat(const char *ifile, struct SMRFileStamp *stamp)
+{
+#if defined(_WIN32)
+    HANDLE h;
+    BY_HANDLE_FILE_INFORMATION info;
+    FILE_BASIC_INFO basic;
+    BOOL ok;
+
+    h = CreateFileA(ifile, FILE_READ_ATTRIBUTES,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if (h == INVALID_HANDLE_VALUE) { return -1; }
+
+    ok = GetFileInformationByHandle(h, &info) &&
+        GetFileInformationByHandleEx(h, FileBasicInfo, &basic, sizeof (basic));
+
+    CloseHandle(h);
+
+    if (!ok) { return -1; }
+
+    stamp->size = (int64_t) (((uint64_t) info.nFileSizeHigh << 32) |
+        info.nFileSizeLow);
+
+    /*FILETIMEs count 100 ns intervals*/
+    stamp->mtime = basic.LastWriteTime.QuadPart * 100;
+    stamp->ctime = basic.ChangeTime.QuadPart * 100;
+    stamp->inode = ((uint64_t) info.nFileIndexHigh << 32) | info.nFileIndexLow;
+#else
+    struct stat st;
+
+    if (stat(ifile, &st) != 0) { return -1; }
+
+    stamp->size = (int64_t) st.st_size;
+
+#if defined(__APPLE__)
+    stamp->mtime = (int64_t) st.st_mtimespec.tv_sec * 1000000000 +
+        st.st_mtimespec.tv_nsec;
+    stamp->ctime = (int64_t) st.st_ctimespec.tv_sec * 1000000000 +
+        st.st_ctimespec.tv_nsec;
+#else
+    stamp->mtime = (int64_t) st.st_mtim.tv_sec * 1000000000 +
+        st.st_mtim.tv_nsec;
+    stamp->ctime = (int64_t) st.st_ctim.tv_sec * 1000000000 +
+        st.st_ctim.tv_nsec;
+#endif
+
+    stamp->inode = (uint64_t) st.st_ino;
+#endif
+
+    return 0;
+}
+/* ========================================================================= */
+int same_file_stamp(const struct SMRFileStamp *a, const struct SMRFileStamp *b)
+{
+    return a->size == b->size && a->mtime == b->mtime &&
+        a->ctime == b->ctime && a->inode == b->inode;
+}
+/* ========================================================================= */
+/* rename <src> to <dst>, replacing <dst> if it exists, such that readers of
+   <dst> see either the old or the new file but never a partial one. returns
+   0 on success */
+int replace_file(const char *src, const char *dst)
+{
+#if defined(_WIN32)
+    return MoveFileExA(src, dst, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+#else
+    return rename(src, dst);
+#endif
+}
+/* ========================================================================= */
+unsigned long process_id()
+{
+#if defined(_WIN32)
+    return (unsigned long) GetCurrentProcessId();
+#else
+    return (unsigned long) getpid();
+#endif
+}
+/* ========================================================================= */
+/* monotonic wall clock time in seconds, only differences are meaningful */
+double get_time()
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+
+    return (double) count.QuadPart / (double) freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+#endif
+}
+/* ========================================================================= */
 char *copy_string(const char *src)
 {
     size_t nchar;
@@ -49,16 +163,6 @@ char *copy_string(const char *src)
 
     dest[nchar-1] = '\0';
     return dest;
-}
-/* ========================================================================= */
-void read_chars(FILE *fp, const char *mode, char *buf, size_t len)
-{
-#if defined(_WIN32) && ! defined(__MINGW32__)
-    fscanf_s(fp, mode, buf, len);
-#else
-    fscanf(fp, mode, buf);
-#endif
-
 }
 /* ========================================================================= */
 void strtrim(char *str)
@@ -102,35 +206,6 @@ void strtrim(char *str)
     }
 }
 /* ------------------------------------------------------------------------- */
-char *fill_string(FILE *fp, int32_t pad)
-{
-    uint8_t n;
-    char *pt;
-    int32_t loc;
-
-    fread(&n, sizeof (uint8_t), (size_t)1, fp);
-
-    loc = ftell(fp);
-
-    if (n > 0)
-    {
-        pt = malloc(sizeof (char) * n+1);
-
-        fread(pt, sizeof (char), n, fp);
-        pt[n] = '\0';
-        strtrim(pt);
-
-    }
-    else
-    {
-        pt = NULL;
-    }
-
-    fseek(fp, loc+pad, SEEK_SET);
-
-    return pt;
-}
-/* ------------------------------------------------------------------------- */
 char lower_char(const char c)
 {
     return (c > 64 && c < 91) ? c+32 : c;
@@ -0,0 +1,1525 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "smr.h"
+#include "smr_synth.h"
+
+/* =============================================================================
+Throughput / latency benchmark for the channel readers
+
+Generates a synthetic file (see smr_synth.h) or uses an existing one, then
+times every reader on every channel both through the path based API (which
+re-opens and re-walks the file each call) and through an SMRFile handle that
+loads the sidecar index. Reported figures are the minimum and median wall
+time over <nrep> repetitions, throughput in MB/s of record payload (as given
+by the block headers) and items (samples / events / markers) per second.
+
+Before timing a generated file every reader's output is compared against the
+records smr_synth.h wrote, through both APIs and with every open flag, and
+the benchmark exits with an error if any of them differ ('make check').
+readers that derive data from a channel (cursors, snippets, epochs,
+summaries, scaled / matrix fills, async reads) are compared against slices
+or brute force reductions of the records, the decimator and filter against
+the gain of the synthetic 7 Hz sine.
+============================================================================= */
+#define BENCH_MAX_REP 1024
+
+typedef uint64_t (*bench_fn)(struct SMRFile *, const char *, int);
+
+struct BenchResult
+{
+    double min;
+    double median;
+};
+/* -------------------------------------------------------------------------- */
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + ((double) ts.tv_nsec * 1e-9);
+}
+/* -------------------------------------------------------------------------- */
+static int compare_double(const void *a, const void *b)
+{
+    double x = *((const double *) a);
+    double y = *((const double *) b);
+    return (x > y) - (x < y);
+}
+/* -------------------------------------------------------------------------- */
+static struct BenchResult summarize(double *times, int nrep)
+{
+    struct BenchResult res;
+
+    qsort(times, nrep, sizeof(double), compare_double);
+
+    res.min = times[0];
+    if (nrep % 2 == 0)
+    {
+        res.median = (times[nrep/2 - 1] + times[nrep/2]) / 2.0;
+    }
+    else
+    {
+        res.median = times[nrep/2];
+    }
+
+    return res;
+}
+/* -------------------------------------------------------------------------- */
+/* each bench_read_* reads and frees a channel returning the number of items
+ * read (0 on failure), the path is used when f is NULL */
+static uint64_t bench_read_continuous(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMRContChannel *c = f ? read_continuous_channel_from_file(f, idx) :
+                                   read_continuous_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_continuous_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t bench_read_realwave(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMRRealWaveChannel *c = f ? read_realwave_channel_from_file(f, idx) :
+                                       read_realwave_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_realwave_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t bench_read_event(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMREventChannel *c = f ? read_event_channel_from_file(f, idx) :
+                                    read_event_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_event_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t bench_read_level(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMRLevelChannel *c = f ? read_level_channel_from_file(f, idx) :
+                                    read_level_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_level_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t bench_read_marker(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMRMarkerChannel *c = f ? read_marker_channel_from_file(f, idx) :
+                                     read_marker_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_marker_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t bench_read_wavemark(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMRWMrkChannel *c = f ? read_wavemark_channel_from_file(f, idx) :
+                                   read_wavemark_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_wavemark_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t bench_read_realmarker(struct SMRFile *f, const char *path, int idx)
+{
+    uint64_t n = 0;
+    struct SMRRealMarkerChannel *c = f ? read_realmarker_channel_from_file(f, idx) :
+                                         read_realmarker_channel(path, idx);
+    if (c != NULL)
+    {
+        n = c->length;
+        free_realmarker_channel(c);
+    }
+    return n;
+}
+/* -------------------------------------------------------------------------- */
+static bench_fn get_bench_function(uint8_t kind, const char **name)
+{
+    switch (kind)
+    {
+        case CONTINUOUS_CHANNEL:  *name = "continuous"; return bench_read_continuous;
+        case EVENT_2_CHANNEL:
+        case EVENT_3_CHANNEL:     *name = "event";      return bench_read_event;
+        case EVENT_4_CHANNEL:     *name = "level";      return bench_read_level;
+        case MARKER_CHANNEL:
+        case TEXT_MARKER_CHANNEL: *name = "marker";     return bench_read_marker;
+        case ADC_MARKER_CHANNEL:  *name = "wavemark";   return bench_read_wavemark;
+        case REAL_MARKER_CHANNEL: *name = "realmarker"; return bench_read_realmarker;
+        case REAL_WAVE_CHANNEL:   *name = "realwave";   return bench_read_realwave;
+        default:                  *name = "";           return NULL;
+    }
+}
+/* -------------------------------------------------------------------------- */
+static uint64_t payload_bytes(struct SMRChannelHeader *chdr,
+    struct SMRBlockHeaderArray *bhdr)
+{
+    uint64_t total = 0;
+    uint64_t size;
+    unsigned int k;
+
+    switch (chdr->kind)
+    {
+        case CONTINUOUS_CHANNEL: size = sizeof(int16_t); break;
+        case REAL_WAVE_CHANNEL:  size = sizeof(float); break;
+        case EVENT_2_CHANNEL:
+        case EVENT_3_CHANNEL:
+        case EVENT_4_CHANNEL:    size = sizeof(int32_t); break;
+        default:                 size = sizeof(int32_t) + MARKER_SIZE + chdr->nextra; break;
+    }
+
+    for (k = 0; k < bhdr->length; ++k)
+    {
+        total += (uint64_t) bhdr->hdr[k].nitem * size;
+    }
+
+    return total;
+}
+/* -------------------------------------------------------------------------- */
+static void print_result(const char *name, int idx, const char *api,
+    uint64_t items, uint64_t bytes, struct BenchResult res)
+{
+    double mb = (double) bytes / (1024.0 * 1024.0);
+    double t = res.median > 0 ? res.median : 1e-9;
+
+    printf("%-12s %4d %-7s %12lu %9.2f %10.3f %10.3f %10.1f %12.4g\n",
+        name, idx, api, items, mb, res.min * 1e3, res.median * 1e3, mb / t,
+        (double) items / t);
+}
+/* -------------------------------------------------------------------------- */
+static void bench_open(const char *ifile, int nrep)
+{
+    double times[BENCH_MAX_REP];
+    struct BenchResult res;
+    struct SMRFile *f;
+    char *idx_file;
+    size_t len;
+    double t0;
+    int k;
+
+    len = strlen(ifile) + strlen(INDEX_EXT) + 1;
+    idx_file = malloc(len);
+    snprintf(idx_file, len, "%s%s", ifile, INDEX_EXT);
+
+    /* full header + block walk every time */
+    for (k = 0; k < nrep; ++k)
+    {
+        int idx;
+        t0 = bench_now();
+        f = open_smr_file(ifile, 0);
+        for (idx = 1; f != NULL && idx <= f->fhdr->nchannel; ++idx)
+        {
+            get_block_header_array(f, idx);
+        }
+        times[k] = bench_now() - t0;
+        close_smr_file(f);
+    }
+    res = summarize(times, nrep);
+    printf("%-24s %10.3f %10.3f\n", "open (walk)", res.min * 1e3, res.median * 1e3);
+
+    /* walk + block stats + index write */
+    for (k = 0; k < nrep; ++k)
+    {
+        remove(idx_file);
+        t0 = bench_now();
+        f = open_smr_file(ifile, SMR_USE_INDEX);
+        times[k] = bench_now() - t0;
+        close_smr_file(f);
+    }
+    res = summarize(times, nrep);
+    printf("%-24s %10.3f %10.3f\n", "open (build index)", res.min * 1e3, res.median * 1e3);
+
+    /* index load only */
+    for (k = 0; k < nrep; ++k)
+    {
+        t0 = bench_now();
+        f = open_smr_file(ifile, SMR_USE_INDEX);
+        times[k] = bench_now() - t0;
+        close_smr_file(f);
+    }
+    res = summarize(times, nrep);
+    printf("%-24s %10.3f %10.3f\n", "open (load index)", res.min * 1e3, res.median * 1e3);
+
+    free(idx_file);
+}
+/* -------------------------------------------------------------------------- */
+static void bench_readers(const char *ifile, int nrep, int flags)
+{
+    double times[BENCH_MAX_REP];
+    struct SMRFile *f;
+    uint64_t items = 0;
+    int api, idx, k;
+    double t0;
+
+    f = open_smr_file(ifile, SMR_USE_INDEX | flags);
+    if (f == NULL)
+    {
+        return;
+    }
+
+    printf("%-12s %4s %-7s %12s %9s %10s %10s %10s %12s\n", "reader", "chan",
+        "api", "items", "MB", "min ms", "median ms", "MB/s", "items/s");
+
+    for (idx = 1; idx <= f->fhdr->nchannel; ++idx)
+    {
+        struct SMRChannelHeader *chdr = get_channel_header(f, idx);
+        struct SMRBlockHeaderArray *bhdr = get_block_header_array(f, idx);
+        const char *name;
+        bench_fn fn;
+
+        if (chdr == NULL || bhdr == NULL)
+        {
+            continue;
+        }
+
+        fn = get_bench_function(chdr->kind, &name);
+        if (fn == NULL)
+        {
+            continue;
+        }
+
+        for (api = 0; api < 2; ++api)
+        {
+            for (k = 0; k < nrep; ++k)
+            {
+                t0 = bench_now();
+                items = fn(api == 0 ? NULL : f, ifile, idx);
+                times[k] = bench_now() - t0;
+            }
+
+            print_result(name, idx, api == 0 ? "path" : "handle", items,
+                payload_bytes(chdr, bhdr), summarize(times, nrep));
+        }
+
+        if (chdr->kind == CONTINUOUS_CHANNEL)
+        {
+            for (k = 0; k < nrep; ++k)
+            {
+                struct SMRSummary *sum;
+                t0 = bench_now();
+                sum = build_continuous_summary_from_file(f, idx);
+                times[k] = bench_now() - t0;
+                items = sum != NULL ? sum->nsample : 0;
+                free_continuous_summary(sum);
+            }
+
+            print_result("summary", idx, "handle", items,
+                payload_bytes(chdr, bhdr), summarize(times, nrep));
+        }
+    }
+
+    close_smr_file(f);
+}
+/* -------------------------------------------------------------------------- */
+static double check_seconds(const uint8_t *record, int16_t uspertime)
+{
+    int32_t tick;
+    memcpy(&tick, record, sizeof (int32_t));
+
+    /*same operation order as the library, so the comparison can be exact*/
+    return (double) tick * (double) uspertime * 1e-6;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if the <length> decoded records match those of <rec> whose first marker
+ * byte is <code> (any code if < 0). <markers> and <extra> may be NULL to skip
+ * comparing the marker codes / the <nextra> bytes that follow them */
+static int check_records(struct SynthRecords *rec, int16_t uspertime, int code,
+    uint64_t length, const double *ts, const uint8_t *markers,
+    const uint8_t *extra, size_t nextra)
+{
+    const uint8_t *src;
+    uint64_t k;
+    uint64_t n = 0;
+
+    if (length > 0 && ts == NULL)
+    {
+        return 0;
+    }
+
+    for (k = 0; k < rec->nrecord; ++k)
+    {
+        src = rec->data + (k * rec->record_size);
+
+        if (code >= 0 && src[sizeof (int32_t)] != (uint8_t) code)
+        {
+            continue;
+        }
+
+        if (n >= length || ts[n] != check_seconds(src, uspertime))
+        {
+            return 0;
+        }
+
+        if (markers != NULL && memcmp(markers + (n * MARKER_SIZE),
+            src + sizeof (int32_t), MARKER_SIZE) != 0)
+        {
+            return 0;
+        }
+
+        if (extra != NULL && memcmp(extra + (n * nextra),
+            src + sizeof (int32_t) + MARKER_SIZE, nextra) != 0)
+        {
+            return 0;
+        }
+
+        ++n;
+    }
+
+    return n == length;
+}
+/* -------------------------------------------------------------------------- */
+static int check_level(struct SynthRecords *rec, int16_t uspertime,
+    struct SMRLevelChannel *c)
+{
+    uint64_t k;
+    double t;
+
+    /*synthetic level channels start low, so edges pair up as rising /
+      falling and a trailing rising edge is closed at the file's max time*/
+    if (c == NULL || !c->init_low || c->length != (rec->nrecord + 1) / 2)
+    {
+        return 0;
+    }
+
+    for (k = 0; k < rec->nrecord; ++k)
+    {
+        t = check_seconds(rec->data + (k * rec->record_size), uspertime);
+
+        if (t != (k % 2 == 0 ? c->start[k/2] : c->stop[k/2]))
+        {
+            return 0;
+        }
+    }
+
+    t = (double) rec->maxtime * (double) uspertime * 1e-6;
+
+    return rec->nrecord % 2 == 0 || c->stop[c->length-1] == t;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if the <ncol> columns of <npt> samples in <cols> are the slices of the
+ * <n> samples <x> that start <npre> samples before <times> (synthetic
+ * channels start at time 0), with samples outside of <x> being 0 */
+static int check_slices(const int16_t *x, uint64_t n, const double *times,
+    uint64_t ncol, double rate, int64_t npre, uint64_t npt,
+    const int16_t *cols)
+{
+    int64_t start, s;
+    uint64_t k, j;
+
+    if (ncol > 0 && cols == NULL)
+    {
+        return 0;
+    }
+
+    for (k = 0; k < ncol; ++k)
+    {
+        start = (int64_t) llround(times[k] * rate) - npre;
+
+        for (j = 0; j < npt; ++j)
+        {
+            s = start + (int64_t) j;
+
+            if (cols[(k * npt) + j] != (s >= 0 && s < (int64_t) n ? x[s] : 0))
+            {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if the events of every trial in <c> are the records of <rec> within
+ * [triggers[k] - pre, triggers[k] + post], relative to the trigger */
+static int check_epoch_events(struct SynthRecords *rec, int16_t uspertime,
+    struct SMREpochChannel *c, const double *triggers, uint64_t ntrial,
+    double pre, double post)
+{
+    const uint8_t *src;
+    uint64_t n = 0;
+    uint64_t k, j;
+    double t;
+
+    for (k = 0; k < ntrial; ++k)
+    {
+        if (c->offsets[k] != n)
+        {
+            return 0;
+        }
+
+        for (j = 0; j < rec->nrecord; ++j)
+        {
+            src = rec->data + (j * rec->record_size);
+            t = check_seconds(src, uspertime);
+
+            /*same comparisons as the library, so boundaries agree*/
+            if (triggers[k] < t - post || triggers[k] > t + pre)
+            {
+                continue;
+            }
+
+            if (n >= c->nevent || c->times[n] != t - triggers[k])
+            {
+                return 0;
+            }
+
+            if (c->markers != NULL && memcmp(c->markers + (n * MARKER_SIZE),
+                src + sizeof (int32_t), MARKER_SIZE) != 0)
+            {
+                return 0;
+            }
+
+            if (c->data != NULL && memcmp(c->data + (n * c->npt),
+                src + sizeof (int32_t) + MARKER_SIZE, c->npt * sizeof (int16_t)) != 0)
+            {
+                return 0;
+            }
+
+            ++n;
+        }
+    }
+
+    return n == c->nevent && c->offsets[ntrial] == n &&
+        (c->markers != NULL) == (rec->kind >= MARKER_CHANNEL);
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if a cursor walks channel <idx> in chunks that concatenate to <rec>, and
+ * starts over when rewound */
+static int check_cursor(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, int16_t uspertime)
+{
+    const uint64_t chunk = 1000;
+
+    struct SMRCursor *c;
+    size_t size = rec->kind == CONTINUOUS_CHANNEL ? sizeof (int16_t) :
+        rec->kind == REAL_WAVE_CHANNEL ? sizeof (float) : sizeof (double);
+    uint8_t *data = malloc(size * (rec->nrecord + chunk));
+    uint64_t total = 0;
+    int64_t n;
+    int ok;
+
+    c = f ? open_channel_cursor_from_file(f, idx, chunk) :
+            open_channel_cursor(path, idx, chunk);
+
+    if (c == NULL || c->length != rec->nrecord)
+    {
+        close_channel_cursor(c);
+        free(data);
+
+        return 0;
+    }
+
+    while ((n = read_cursor_chunk(c, data + (total * size))) > 0)
+    {
+        if ((uint64_t) n > chunk || (total += (uint64_t) n) != c->position ||
+            total > rec->nrecord)
+        {
+            break;
+        }
+    }
+
+    if (size == sizeof (double))
+    {
+        ok = n == 0 && check_records(rec, uspertime, -1, total,
+            (double *) data, NULL, NULL, 0);
+    }
+    else
+    {
+        ok = n == 0 && total == rec->nrecord &&
+            memcmp(data, rec->data, total * size) == 0;
+    }
+
+    /*the first chunk again after a rewind*/
+    rewind_channel_cursor(c);
+
+    n = read_cursor_chunk(c, data);
+
+    ok = ok && n == (int64_t) (rec->nrecord < chunk ? rec->nrecord : chunk) &&
+        c->position == (uint64_t) n && (size == sizeof (double) ||
+            memcmp(data, rec->data, (size_t) n * size) == 0);
+
+    close_channel_cursor(c);
+    free(data);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if every bin of the summary of channel <idx> holds the brute force
+ * min / max / mean of its samples, and windows of it bound the samples */
+static int check_summary(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, double rate)
+{
+    const int16_t *x = (const int16_t *) rec->data;
+    const uint64_t n = rec->nrecord;
+    const uint32_t npixel = 50;
+
+    struct SMRSummary *sum;
+    struct SMREnvelope *env;
+    struct SMRSummaryLevel *lvl;
+    int16_t lo, hi;
+    uint64_t k, j, s, end;
+    double total, s0, spp;
+    unsigned int l;
+    int ok = 1;
+
+    sum = f ? build_continuous_summary_from_file(f, idx) :
+              read_continuous_summary(path, idx, 0);
+
+    if (sum == NULL || sum->nsample != n || n == 0)
+    {
+        free_continuous_summary(sum);
+        return 0;
+    }
+
+    for (l = 0; ok && l < sum->nlevel; ++l)
+    {
+        lvl = sum->level + l;
+
+        ok = lvl->length == (n + lvl->binsize - 1) / lvl->binsize;
+
+        for (k = 0; ok && k < lvl->length; ++k)
+        {
+            end = (k + 1) * lvl->binsize < n ? (k + 1) * lvl->binsize : n;
+            lo = hi = x[k * lvl->binsize];
+            total = 0.0;
+
+            for (s = k * lvl->binsize; s < end; ++s)
+            {
+                if (x[s] < lo) { lo = x[s]; }
+                if (x[s] > hi) { hi = x[s]; }
+                total += (double) x[s];
+            }
+
+            total /= (double) (end - (k * lvl->binsize));
+
+            ok = lvl->min[k] == lo && lvl->max[k] == hi &&
+                fabs((double) lvl->mean[k] - total) <= 1e-4 * (fabs(total) + 1.0);
+        }
+    }
+
+    /*a single pixel spans every bin*/
+    env = read_summary_window(sum, sum->start_time,
+        sum->start_time + ((double) n / rate), 1);
+
+    for (s = 0, lo = hi = x[0]; s < n; ++s)
+    {
+        if (x[s] < lo) { lo = x[s]; }
+        if (x[s] > hi) { hi = x[s]; }
+    }
+
+    ok = ok && env->length == 1 && env->min[0] == lo && env->max[0] == hi;
+
+    free_summary_window(env);
+
+    /*pixels merge whole bins, so they bound the samples that fall in them*/
+    env = read_summary_window(sum, sum->start_time + ((double) n / rate / 4.0),
+        sum->start_time + ((double) n / rate / 2.0), npixel);
+
+    s0 = (double) n / 4.0;
+    spp = ((double) n / 4.0) / (double) npixel;
+
+    ok = ok && env->length == npixel;
+
+    for (k = 0; ok && k < npixel; ++k)
+    {
+        s = (uint64_t) ceil(s0 + ((double) k * spp) + 1e-6);
+        end = (uint64_t) floor(s0 + ((double) (k + 1) * spp) - 1e-6);
+
+        for (j = s; j <= end && j < n; ++j)
+        {
+            ok = ok && env->min[k] <= x[j] && env->max[k] >= x[j];
+        }
+    }
+
+    free_summary_window(env);
+    free_continuous_summary(sum);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* gain of <y> relative to every <step>th sample of <x> (least squares) */
+static double check_gain(const int16_t *x, uint64_t n, const float *y,
+    const int16_t *yi, uint64_t step)
+{
+    double xy = 0.0;
+    double xx = 0.0;
+    double v;
+    uint64_t k;
+
+    for (k = 0; k * step < n; ++k)
+    {
+        v = y ? (double) y[k] : (double) yi[k];
+
+        xy += v * (double) x[k * step];
+        xx += (double) x[k * step] * (double) x[k * step];
+    }
+
+    return xx > 0.0 ? xy / xx : 0.0;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if decimating the (7 Hz sine) channel <idx> keeps its gain and rate, a
+ * factor of 1 being the raw channel */
+static int check_decimated(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, double rate)
+{
+    const int factor = 25;
+
+    struct SMRContChannel *c;
+    int ok;
+
+    c = f ? read_continuous_channel_decimated_from_file(f, idx, factor) :
+            read_continuous_channel_decimated(path, idx, factor);
+
+    ok = c != NULL && c->length == (rec->nrecord + factor - 1) / factor &&
+        fabs((c->sampling_rate * factor) - rate) <= 1e-9 * rate &&
+        fabs(check_gain((int16_t *) rec->data, rec->nrecord, NULL, c->data,
+            factor) - 1.0) < 0.05;
+
+    free_continuous_channel(c);
+
+    c = f ? read_continuous_channel_decimated_from_file(f, idx, 1) :
+            read_continuous_channel_decimated(path, idx, 1);
+
+    ok = ok && c != NULL && c->length == rec->nrecord &&
+        memcmp(c->data, rec->data, rec->nrecord * sizeof (int16_t)) == 0;
+
+    free_continuous_channel(c);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if low-passing the (7 Hz sine) channel <idx> keeps its gain, crossings
+ * are the upward threshold crossings of the filtered data and band-passing
+ * above the sine rejects it */
+static int check_filtered(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, double rate)
+{
+    const int16_t *x = (const int16_t *) rec->data;
+
+    struct SMRFilterConfig cfg;
+    struct SMRFilteredChannel *c;
+    uint64_t dead;
+    uint64_t last = 0;
+    uint64_t n = 0;
+    uint64_t k;
+    double rms = 0.0;
+    double raw = 0.0;
+    int ok;
+
+    default_filter_config(&cfg);
+
+    cfg.low = 0.0;
+    cfg.high = 200.0;
+    cfg.threshold = 4000.0;
+    cfg.dead_time = 0.01;
+    cfg.emit = SMR_EMIT_DATA | SMR_EMIT_CROSSINGS;
+
+    c = f ? read_filtered_channel_from_file(f, idx, &cfg) :
+            read_filtered_channel(path, idx, &cfg);
+
+    ok = c != NULL && c->length == rec->nrecord &&
+        fabs(c->sampling_rate - rate) <= 1e-9 * rate &&
+        fabs(check_gain(x, rec->nrecord, c->data, NULL, 1) - 1.0) < 0.05;
+
+    /*same detector as the library, on the filtered samples it returned*/
+    dead = (uint64_t) ceil(cfg.dead_time * rate);
+
+    for (k = 1; ok && k < c->length; ++k)
+    {
+        if (c->data[k] >= cfg.threshold && c->data[k-1] < cfg.threshold &&
+            (n == 0 || k - last >= dead))
+        {
+            ok = n < c->ncrossing && llround(c->crossings[n] * rate) == (long long) k;
+
+            last = k;
+            ++n;
+        }
+    }
+
+    ok = ok && n == c->ncrossing && n > 0;
+
+    free_filtered_channel(c);
+
+    default_filter_config(&cfg);
+
+    c = f ? read_filtered_channel_from_file(f, idx, &cfg) :
+            read_filtered_channel(path, idx, &cfg);
+
+    for (k = 0; ok && c != NULL && k < c->length; ++k)
+    {
+        rms += (double) c->data[k] * (double) c->data[k];
+        raw += (double) x[k] * (double) x[k];
+    }
+
+    ok = ok && c != NULL && c->length == rec->nrecord && rms < 0.01 * raw;
+
+    free_filtered_channel(c);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* times (in seconds) of samples around both ends and within the <n> samples
+ * of a continuous channel, including some outside of it. returns the # of
+ * times (at most 7) */
+static uint64_t check_slice_times(uint64_t n, double rate, double *times)
+{
+    const int64_t sample[] = {(int64_t) n / 2, 0, (int64_t) n - 5,
+        (int64_t) n + 3, -3, (int64_t) n + 100, (int64_t) n / 3};
+    uint64_t k;
+
+    for (k = 0; k < 7; ++k)
+    {
+        times[k] = (double) sample[k] / rate;
+    }
+
+    return 7;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if the snippets around check_slice_times are slices of the channel */
+static int check_snippets(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, double rate)
+{
+    struct SMRWMrkChannel *c;
+    double times[7];
+    uint64_t n = check_slice_times(rec->nrecord, rate, times);
+    int ok;
+
+    c = f ? read_continuous_snippets_from_file(f, idx, times, n, 10.0 / rate, 20.0 / rate) :
+            read_continuous_snippets(path, idx, times, n, 10.0 / rate, 20.0 / rate);
+
+    ok = c != NULL && c->length == n && c->npt == 30 &&
+        memcmp(c->timestamps, times, n * sizeof (double)) == 0 &&
+        check_slices((int16_t *) rec->data, rec->nrecord, times, n, rate, 10,
+            c->npt, c->wavemarks);
+
+    free_wavemark_channel(c);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if epochs of channel <idx> (alone) match <rec>, continuous ones around
+ * check_slice_times and the others around triggers spread over the file */
+static int check_epochs(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, int16_t uspertime, double rate)
+{
+    struct SMREpochs *ep;
+    double triggers[7];
+    double duration;
+    double pre, post;
+    uint64_t ntrial;
+    int ok;
+
+    if (rec->kind == CONTINUOUS_CHANNEL)
+    {
+        ntrial = check_slice_times(rec->nrecord, rate, triggers);
+        pre = 10.0 / rate;
+        post = 20.0 / rate;
+    }
+    else
+    {
+        duration = (double) rec->maxtime * (double) uspertime * 1e-6;
+
+        triggers[0] = duration / 2.0;
+        triggers[1] = 0.0;
+        triggers[2] = duration;
+        triggers[3] = duration / 3.0;
+        triggers[4] = duration * 0.9;
+
+        ntrial = 5;
+        pre = duration / 20.0;
+        post = duration / 10.0;
+    }
+
+    ep = f ? read_epochs_from_file(f, &idx, 1, triggers, ntrial, pre, post) :
+             read_epochs(path, &idx, 1, triggers, ntrial, pre, post);
+
+    if (ep == NULL || ep->nchannel != 1 || ep->ntrial != ntrial ||
+        ep->channels[0].kind != rec->kind)
+    {
+        ok = 0;
+    }
+    else if (rec->kind == CONTINUOUS_CHANNEL)
+    {
+        ok = ep->channels[0].npt == 30 && check_slices((int16_t *) rec->data,
+            rec->nrecord, triggers, ntrial, rate, 10, 30, ep->channels[0].data);
+    }
+    else
+    {
+        ok = check_epoch_events(rec, uspertime, ep->channels, triggers, ntrial,
+            pre, post);
+    }
+
+    free_epochs(ep);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* 1 if the volts of channel <idx> (double and single) are the scaled <rec>,
+ * and matrices of the channel twice hold it (raw and in volts) in both
+ * columns */
+static int check_scaled(struct SMRFile *f, int idx, struct SynthRecords *rec)
+{
+    const int16_t *x = (const int16_t *) rec->data;
+
+    struct SMRChannelHeader *chdr = get_channel_header(f, idx);
+    double *volts = malloc(sizeof (double) * (rec->nrecord + 1));
+    float *single = malloc(sizeof (float) * (rec->nrecord + 1));
+    int16_t *matrix = malloc(sizeof (int16_t) * 2 * (rec->nrecord + 1));
+    double *vmatrix = malloc(sizeof (double) * 2 * (rec->nrecord + 1));
+    double scale, offset, v;
+    uint64_t k;
+    int pair[2];
+    int ok;
+
+    pair[0] = idx;
+    pair[1] = idx;
+
+    ok = chdr != NULL && read_continuous_channel_scaled(f, idx, volts) == 0 &&
+        read_continuous_channel_scaled_single(f, idx, single) == 0 &&
+        read_continuous_matrix(f, pair, 2, matrix, rec->nrecord, SMR_FILL_INT16) == 0 &&
+        read_continuous_matrix(f, pair, 2, vmatrix, rec->nrecord, SMR_FILL_DOUBLE) == 0 &&
+        memcmp(matrix, x, rec->nrecord * sizeof (int16_t)) == 0 &&
+        memcmp(matrix + rec->nrecord, x, rec->nrecord * sizeof (int16_t)) == 0;
+
+    if (ok)
+    {
+        /*same conversion as the library, so the comparison can be exact*/
+        scale = (double) chdr->scale / 6553.6;
+        offset = (double) chdr->offset;
+
+        for (k = 0; ok && k < rec->nrecord; ++k)
+        {
+            v = (double) x[k] * scale + offset;
+            ok = volts[k] == v && single[k] == (float) v &&
+                vmatrix[k] == v && vmatrix[rec->nrecord + k] == v;
+        }
+    }
+
+    free(volts);
+    free(single);
+    free(matrix);
+    free(vmatrix);
+
+    return ok;
+}
+/* -------------------------------------------------------------------------- */
+/* the result of reading channel <idx> as <type> on a read thread */
+static void *check_async(const char *path, int idx, int type)
+{
+    struct SMRAsyncRead *req = submit_channel_read(path, idx, type, NULL, NULL);
+    void *result = req ? wait_channel_read(req) : NULL;
+
+    free_channel_read(req);
+
+    return result;
+}
+/* -------------------------------------------------------------------------- */
+/* run every reader of channel <idx> through <f> (the path API when NULL) and
+ * compare against <rec>, returns the number of readers that failed */
+static int check_channel(struct SMRFile *f, const char *path, int idx,
+    struct SynthRecords *rec, int16_t uspertime, const char *api)
+{
+    const char *failed[16];
+    double rate = 0.0;
+    int nfail = 0;
+    int k;
+
+    /*the first record's code, for the code filtered readers*/
+    int code = rec->nrecord > 0 ? rec->data[sizeof (int32_t)] : 0;
+    uint8_t codes[1];
+
+    codes[0] = (uint8_t) code;
+
+    switch (rec->kind)
+    {
+        case CONTINUOUS_CHANNEL:
+        {
+            struct SMRContChannel *c = f ? read_continuous_channel_from_file(f, idx) :
+                                           read_continuous_channel(path, idx);
+
+            if (c == NULL || c->length != rec->nrecord ||
+                memcmp(c->data, rec->data, rec->nrecord * sizeof (int16_t)) != 0)
+            {
+                failed[nfail++] = "continuous";
+            }
+
+            rate = c ? c->sampling_rate : 0.0;
+
+            free_continuous_channel(c);
+
+            if (f != NULL)
+            {
+                int16_t *data = malloc(sizeof (int16_t) * (rec->nrecord + 1));
+
+                if (read_continuous_channel_into(f, idx, data) != 0 ||
+                    memcmp(data, rec->data, rec->nrecord * sizeof (int16_t)) != 0)
+                {
+                    failed[nfail++] = "continuous_into";
+                }
+
+                free(data);
+
+                if (!check_scaled(f, idx, rec))
+                {
+                    failed[nfail++] = "continuous_scaled";
+                }
+            }
+            else
+            {
+                struct SMRFileHeader *fhdr = read_file_header(path);
+                struct SMRChannelHeader *chdr = fhdr ? read_channel_header(fhdr, idx) : NULL;
+
+                c = chdr ? read_continuous_channel_from_header(fhdr, chdr) : NULL;
+
+                if (c == NULL || c->length != rec->nrecord ||
+                    memcmp(c->data, rec->data, rec->nrecord * sizeof (int16_t)) != 0)
+                {
+                    failed[nfail++] = "continuous_from_header";
+                }
+
+                free_continuous_channel(c);
+                free_channel_header(chdr);
+                free_file_header(fhdr);
+
+                c = check_async(path, idx, CONTINUOUS_DATA);
+
+                if (c == NULL || c->length != rec->nrecord ||
+                    memcmp(c->data, rec->data, rec->nrecord * sizeof (int16_t)) != 0)
+                {
+                    failed[nfail++] = "continuous_async";
+                }
+
+                free_continuous_channel(c);
+            }
+
+            if (!check_decimated(f, path, idx, rec, rate))
+            {
+                failed[nfail++] = "decimated";
+            }
+
+            if (!check_filtered(f, path, idx, rec, rate))
+            {
+                failed[nfail++] = "filtered";
+            }
+
+            if (!check_snippets(f, path, idx, rec, rate))
+            {
+                failed[nfail++] = "snippets";
+            }
+
+            if (!check_summary(f, path, idx, rec, rate))
+            {
+                failed[nfail++] = "summary";
+            }
+            break;
+        }
+        case REAL_WAVE_CHANNEL:
+        {
+            struct SMRRealWaveChannel *c = f ? read_realwave_channel_from_file(f, idx) :
+                                               read_realwave_channel(path, idx);
+
+            if (c == NULL || c->length != rec->nrecord ||
+                memcmp(c->data, rec->data, rec->nrecord * sizeof (float)) != 0)
+            {
+                failed[nfail++] = "realwave";
+            }
+
+            free_realwave_channel(c);
+
+            if (f == NULL)
+            {
+                struct SMRFileHeader *fhdr = read_file_header(path);
+                struct SMRChannelHeader *chdr = fhdr ? read_channel_header(fhdr, idx) : NULL;
+
+                c = chdr ? read_realwave_channel_from_header(fhdr, chdr) : NULL;
+
+                if (c == NULL || c->length != rec->nrecord ||
+                    memcmp(c->data, rec->data, rec->nrecord * sizeof (float)) != 0)
+                {
+                    failed[nfail++] = "realwave_from_header";
+                }
+
+                free_realwave_channel(c);
+                free_channel_header(chdr);
+                free_file_header(fhdr);
+            }
+            break;
+        }
+        case EVENT_2_CHANNEL:
+        case EVENT_3_CHANNEL:
+        {
+            struct SMREventChannel *c = f ? read_event_channel_from_file(f, idx) :
+                                            read_event_channel(path, idx);
+
+            if (c == NULL || !check_records(rec, uspertime, -1, c->length,
+                c->data, NULL, NULL, 0))
+            {
+                failed[nfail++] = "event";
+            }
+
+            free_event_channel(c);
+
+            if (f != NULL)
+            {
+                double *data = malloc(sizeof (double) * (rec->nrecord + 1));
+
+                if (read_event_channel_into(f, idx, data) != 0 ||
+                    !check_records(rec, uspertime, -1, rec->nrecord, data, NULL,
+                        NULL, 0))
+                {
+                    failed[nfail++] = "event_into";
+                }
+
+                free(data);
+            }
+            else
+            {
+                c = check_async(path, idx, EVENT_DATA);
+
+                if (c == NULL || !check_records(rec, uspertime, -1, c->length,
+                    c->data, NULL, NULL, 0))
+                {
+                    failed[nfail++] = "event_async";
+                }
+
+                free_event_channel(c);
+            }
+            break;
+        }
+        case EVENT_4_CHANNEL:
+        {
+            struct SMRLevelChannel *c = f ? read_level_channel_from_file(f, idx) :
+                                            read_level_channel(path, idx);
+
+            if (!check_level(rec, uspertime, c))
+            {
+                failed[nfail++] = "level";
+            }
+
+            free_level_channel(c);
+
+            if (f == NULL)
+            {
+                c = check_async(path, idx, LEVEL_DATA);
+
+                if (!check_level(rec, uspertime, c))
+                {
+                    failed[nfail++] = "level_async";
+                }
+
+                free_level_channel(c);
+            }
+            break;
+        }
+        case MARKER_CHANNEL:
+        case TEXT_MARKER_CHANNEL:
+        {
+            struct SMRMarkerChannel *c = f ? read_marker_channel_from_file(f, idx) :
+                                             read_marker_channel(path, idx);
+
+            /*markers without text still get one (zeroed) character each*/
+            if (c == NULL || c->npt != (rec->nextra > 0 ? (uint64_t) rec->nextra : 1) ||
+                !check_records(rec, uspertime, -1, c->length, c->timestamps,
+                    c->markers, rec->nextra > 0 ? c->text : NULL,
+                    (size_t) rec->nextra) ||
+                (rec->nextra == 0 && c->length > 0 &&
+                    (c->text[0] != 0 || memcmp(c->text, c->text + 1, c->length - 1) != 0)))
+            {
+                failed[nfail++] = "marker";
+            }
+
+            free_marker_channel(c);
+
+            c = f ? read_marker_channel_codes_from_file(f, idx, codes, 1) :
+                    read_marker_channel_codes(path, idx, codes, 1);
+
+            if (c == NULL || !check_records(rec, uspertime, code, c->length,
+                c->timestamps, c->markers, c->text, (size_t) rec->nextra))
+            {
+                failed[nfail++] = "marker_codes";
+            }
+
+            free_marker_channel(c);
+
+            if (f == NULL)
+            {
+                c = check_async(path, idx, MARKER_DATA);
+
+                if (c == NULL || !check_records(rec, uspertime, -1, c->length,
+                    c->timestamps, c->markers, NULL, 0))
+                {
+                    failed[nfail++] = "marker_async";
+                }
+
+                free_marker_channel(c);
+            }
+            break;
+        }
+        case ADC_MARKER_CHANNEL:
+        {
+            struct SMRWMrkChannel *c = f ? read_wavemark_channel_from_file(f, idx) :
+                                           read_wavemark_channel(path, idx);
+
+            if (c == NULL || c->npt * sizeof (int16_t) != (uint64_t) rec->nextra ||
+                !check_records(rec, uspertime, -1, c->length, c->timestamps,
+                    c->markers, (uint8_t *) c->wavemarks, (size_t) rec->nextra))
+            {
+                failed[nfail++] = "wavemark";
+            }
+
+            free_wavemark_channel(c);
+
+            c = f ? read_wavemark_channel_codes_from_file(f, idx, codes, 1) :
+                    read_wavemark_channel_codes(path, idx, codes, 1);
+
+            if (c == NULL || !check_records(rec, uspertime, code, c->length,
+                c->timestamps, c->markers, (uint8_t *) c->wavemarks,
+                (size_t) rec->nextra))
+            {
+                failed[nfail++] = "wavemark_codes";
+            }
+
+            free_wavemark_channel(c);
+            break;
+        }
+        case REAL_MARKER_CHANNEL:
+        {
+            struct SMRRealMarkerChannel *c = f ? read_realmarker_channel_from_file(f, idx) :
+                                                 read_realmarker_channel(path, idx);
+
+            if (c == NULL || c->npt * sizeof (float) != (uint64_t) rec->nextra ||
+                !check_records(rec, uspertime, -1, c->length, c->timestamps,
+                    c->markers, (uint8_t *) c->data, (size_t) rec->nextra))
+            {
+                failed[nfail++] = "realmarker";
+            }
+
+            free_realmarker_channel(c);
+            break;
+        }
+        default:
+            break;
+    }
+
+    if (rec->kind >= MARKER_CHANNEL && rec->kind <= REAL_MARKER_CHANNEL)
+    {
+        struct SMREventChannel *c = f ? read_marker_timestamps_from_file(f, idx) :
+                                        read_marker_timestamps(path, idx);
+
+        if (c == NULL || !check_records(rec, uspertime, -1, c->length, c->data,
+            NULL, NULL, 0))
+        {
+            failed[nfail++] = "marker_timestamps";
+        }
+
+        free_event_channel(c);
+    }
+
+    if (rec->kind <= EVENT_4_CHANNEL || rec->kind == REAL_WAVE_CHANNEL)
+    {
+        if (!check_cursor(f, path, idx, rec, uspertime))
+        {
+            failed[nfail++] = "cursor";
+        }
+    }
+
+    if (rec->kind != REAL_WAVE_CHANNEL && !check_epochs(f, path, idx, rec,
+        uspertime, rate))
+    {
+        failed[nfail++] = "epochs";
+    }
+
+    for (k = 0; k < nfail; ++k)
+    {
+        fprintf(stderr, "[ERROR]: %s reader of channel %d (%s) does not match the generated data\n",
+            failed[k], idx, api);
+    }
+
+    return nfail;
+}
+/* -------------------------------------------------------------------------- */
+/* check every reader against the content <cfg> generates, through the path
+ * API and a handle, once per open flag (and once more with the channel cache
+ * on). returns the number of failures */
+static int check_readers(const char *ifile, struct SynthConfig *cfg)
+{
+    const int flags[] = {0, SMR_USE_INDEX, SMR_IO_URING, SMR_IO_DIRECT,
+        SMR_IO_STATS};
+    const char *names[] = {"default", "index", "io_uring", "direct", "stats"};
+    const int nflag = (int) (sizeof (flags) / sizeof (flags[0]));
+
+    struct SynthRecords *rec;
+    struct SMRFile *f;
+    char api[32];
+    int16_t uspertime;
+    int defaults = get_default_open_flags();
+    int nfail = 0;
+    int idx, k;
+
+    if ((rec = synth_channel_records(cfg, &uspertime)) == NULL)
+    {
+        return 1;
+    }
+
+    for (k = 0; k < nflag; ++k)
+    {
+        /*the path based readers open files with the default flags*/
+        set_default_open_flags(flags[k]);
+
+        if ((f = open_smr_file(ifile, flags[k])) == NULL)
+        {
+            ++nfail;
+            continue;
+        }
+
+        for (idx = 1; idx <= cfg->nchannel; ++idx)
+        {
+            snprintf(api, sizeof(api), "path, %s", names[k]);
+            nfail += check_channel(NULL, ifile, idx, rec + idx - 1, uspertime, api);
+
+            snprintf(api, sizeof(api), "handle, %s", names[k]);
+            nfail += check_channel(f, ifile, idx, rec + idx - 1, uspertime, api);
+        }
+
+        close_smr_file(f);
+    }
+
+    set_default_open_flags(defaults);
+
+    /*first pass fills the cache, the second is served from it*/
+    set_channel_cache_size(256 * 1024 * 1024);
+
+    for (k = 0; k < 2; ++k)
+    {
+        for (idx = 1; idx <= cfg->nchannel; ++idx)
+        {
+            nfail += check_channel(NULL, ifile, idx, rec + idx - 1, uspertime,
+                k == 0 ? "path, cache miss" : "path, cache hit");
+        }
+    }
+
+    set_channel_cache_size(0);
+
+    synth_free_records(rec, cfg->nchannel);
+
+    return nfail;
+}
+/* -------------------------------------------------------------------------- */
+static void bench_smr2mda(const char *exe, const char *ifile, int nrep)
+{
+    double times[BENCH_MAX_REP];
+    struct BenchResult res;
+    char *ofile, *cmd;
+    size_t len;
+    double t0;
+    int k;
+
+    len = strlen(ifile) + 5;
+    ofile = malloc(len);
+    snprintf(ofile, len, "%s.mda", ifile);
+
+    len = strlen(exe) + strlen(ifile) + strlen(ofile) + 32;
+    cmd = malloc(len);
+    snprintf(cmd, len, "\"%s\" \"%s\" \"%s\" > /dev/null", exe, ifile, ofile);
+
+    for (k = 0; k < nrep; ++k)
+    {
+        t0 = bench_now();
+        if (system(cmd) != 0)
+        {
+            fprintf(stderr, "[ERROR]: \"%s\" failed\n", cmd);
+            break;
+        }
+        times[k] = bench_now() - t0;
+    }
+
+    if (k == nrep)
+    {
+        res = summarize(times, nrep);
+        printf("%-24s %10.3f %10.3f\n", "smr2mda", res.min * 1e3, res.median * 1e3);
+    }
+
+    remove(ofile);
+    free(ofile);
+    free(cmd);
+}
+/* -------------------------------------------------------------------------- */
+void usage()
+{
+    printf(
+        "\nUsage:\n"
+        "smr_bench [options]\n"
+        "\n"
+        "Options:\n"
+        "    -f [path]  - benchmark an existing file instead of generating one\n"
+        "    -o [path]  - where to write the synthetic file (default\n"
+        "                 ./smr_bench.smr, removed on exit)\n"
+        "    -i [n]     - number of repetitions per measurement (default 5)\n"
+        "    -m [path]  - also time the given smr2mda executable\n"
+        "    -u [0|1]   - fetch blocks through io_uring in the handle API\n"
+        "                 (Linux only, default 0)\n"
+        "    -c [0|1]   - only check the readers, no timing (default 0). every\n"
+        "                 reader is checked against the generated data before\n"
+        "                 timing unless -f is given\n"
+        "    -s, -n, -k, -b, -p, -r, -e, -S\n"
+        "               - synthetic file options, see smr_gen -h\n"
+        "    -h         - print documentation\n"
+        "\n"
+        "Examples:\n"
+        "    #1GB of 64 continuous channels, time smr2mda as well\n"
+        "    smr_bench -s 1024 -n 64 -k 1 -m ./bin/smr2mda\n"
+        "\n"
+    );
+}
+/* -------------------------------------------------------------------------- */
+int main(int argc, char const *argv[])
+{
+    struct SynthConfig cfg;
+    const char *ifile = NULL;
+    const char *ofile = "./smr_bench.smr";
+    const char *exe = NULL;
+    int nrep = 5;
+    int flags = 0;
+    int check_only = 0;
+    int nfail;
+    int k;
+
+    synth_default_config(&cfg);
+
+    for (k = 1; k < argc; ++k)
+    {
+        if (argv[k][0] != '-' || argv[k][1] == '\0')
+        {
+            fprintf(stderr, "[ERROR]: Unrecognized argument \"%s\"!\n", argv[k]);
+            return 126;
+        }
+
+        if (argv[k][1] == 'h')
+        {
+            usage();
+            return 0;
+        }
+
+        if (k + 1 >= argc)
+        {
+            fprintf(stderr, "[ERROR]: Flag \"%s\" requires a value!\n", argv[k]);
+            return 127;
+        }
+
+        switch (argv[k][1])
+        {
+            case 'f': ifile = argv[k+1]; break;
+            case 'o': ofile = argv[k+1]; break;
+            case 'i': nrep = atoi(argv[k+1]); break;
+            case 'm': exe = argv[k+1]; break;
+            case 'u': flags = atoi(argv[k+1]) ? SMR_IO_URING : 0; break;
+            case 'c': check_only = atoi(argv[k+1]); break;
+            case 's': cfg.size_mb = atof(argv[k+1]); break;
+            case 'n': cfg.nchannel = atoi(argv[k+1]); break;
+            case 'b': cfg.block_size = atoi(argv[k+1]); break;
+            case 'p': cfg.npt = atoi(argv[k+1]); break;
+            case 'r': cfg.wave_rate = atof(argv[k+1]); break;
+            case 'e': cfg.event_rate = atof(argv[k+1]); break;
+            case 'S': cfg.seed = (unsigned int) atoi(argv[k+1]); break;
+            case 'k':
+                if (synth_parse_kinds(&cfg, argv[k+1]) != 0)
+                {
+                    fprintf(stderr, "[ERROR]: invalid channel kind list \"%s\"\n", argv[k+1]);
+                    return 126;
+                }
+                break;
+            default:
+                fprintf(stderr, "[ERROR]: Unrecognized flag!\n");
+                return 126;
+        }
+        ++k;
+    }
+
+    if (nrep < 1 || nrep > BENCH_MAX_REP)
+    {
+        fprintf(stderr, "[ERROR]: repetitions must be in [1, %d]\n", BENCH_MAX_REP);
+        return 126;
+    }
+
+    if (ifile == NULL)
+    {
+        double t0 = bench_now();
+        if (write_synthetic_smr(ofile, &cfg) != 0)
+        {
+            return 1;
+        }
+        printf("generated %s (%.0f MB, %d channels) in %.3f s\n\n", ofile,
+            cfg.size_mb, cfg.nchannel, bench_now() - t0);
+
+        if ((nfail = check_readers(ofile, &cfg)) != 0)
+        {
+            fprintf(stderr, "[ERROR]: %d reader checks failed\n", nfail);
+        }
+        else
+        {
+            printf("all readers match the generated data\n\n");
+        }
+
+        if (nfail != 0 || check_only)
+        {
+            char idx_file[4096];
+            snprintf(idx_file, sizeof(idx_file), "%s%s", ofile, INDEX_EXT);
+            remove(idx_file);
+            remove(ofile);
+
+            return nfail != 0 ? 1 : 0;
+        }
+    }
+    else if (check_only)
+    {
+        fprintf(stderr, "[ERROR]: only generated files can be checked\n");
+        return 126;
+    }
+
+    printf("%-24s %10s %10s\n", "", "min ms", "median ms");
+    bench_open(ifile != NULL ? ifile : ofile, nrep);
+    if (exe != NULL)
+    {
+        bench_smr2mda(exe, ifile != NULL ? ifile : ofile, nrep);
+    }
+    printf("\n");
+
+    bench_readers(ifile != NULL ? ifile : ofile, nrep, flags);
+
+    if (ifile == NULL)
+    {
+        char idx_file[4096];
+        snprintf(idx_file, sizeof(idx_file), "%s%s", ofile, INDEX_EXT);
+        remove(idx_file);
+        remove(ofile);
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
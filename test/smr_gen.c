@@ -0,0 +1,89 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include "smr_synth.h"
+
+/* -------------------------------------------------------------------------- */
+void usage()
+{
+    printf(
+        "\nUsage:\n"
+        "smr_gen [options] <smrfile>\n"
+        "\n"
+        "Options:\n"
+        "    -s [mb]    - approximate size of the data in MB (default 64)\n"
+        "    -n [n]     - number of channels (default 8)\n"
+        "    -k [list]  - comma separated list of channel kinds, assigned to\n"
+        "                 channels round-robin (default \"1,2,4,5,6,7,8,9\")\n"
+        "    -b [bytes] - data bytes per block (default 8192)\n"
+        "    -p [npt]   - points per wavemark (default 32)\n"
+        "    -r [hz]    - sampling rate of waveform channels (default 25000)\n"
+        "    -e [hz]    - mean event rate of event channels (default 100)\n"
+        "    -S [seed]  - random seed (default 1)\n"
+        "    -h         - print documentation\n"
+        "\n"
+        "Examples:\n"
+        "    #64 continuous channels, ~1GB\n"
+        "    smr_gen -s 1024 -n 64 -k 1 ./probe.smr\n"
+        "\n"
+    );
+}
+/* -------------------------------------------------------------------------- */
+int main(int argc, char const *argv[])
+{
+    struct SynthConfig cfg;
+    int k;
+
+    synth_default_config(&cfg);
+
+    for (k = 1; k < argc - 1; k += 2)
+    {
+        if (argv[k][0] != '-')
+        {
+            break;
+        }
+
+        switch (argv[k][1])
+        {
+            case 's': cfg.size_mb = atof(argv[k+1]); break;
+            case 'n': cfg.nchannel = atoi(argv[k+1]); break;
+            case 'b': cfg.block_size = atoi(argv[k+1]); break;
+            case 'p': cfg.npt = atoi(argv[k+1]); break;
+            case 'r': cfg.wave_rate = atof(argv[k+1]); break;
+            case 'e': cfg.event_rate = atof(argv[k+1]); break;
+            case 'S': cfg.seed = (unsigned int) atoi(argv[k+1]); break;
+            case 'k':
+                if (synth_parse_kinds(&cfg, argv[k+1]) != 0)
+                {
+                    fprintf(stderr, "[ERROR]: invalid channel kind list \"%s\"\n", argv[k+1]);
+                    return 126;
+                }
+                break;
+            case 'h':
+                usage();
+                return 0;
+            default:
+                fprintf(stderr, "[ERROR]: Unrecognized flag!\n");
+                return 126;
+        }
+    }
+
+    if (argc < 2 || k != argc - 1 || argv[k][0] == '-')
+    {
+        if (argc > 1 && argv[argc-1][0] == '-' && argv[argc-1][1] == 'h')
+        {
+            usage();
+            return 0;
+        }
+
+        fprintf(stderr, "[ERROR]: Not enough input arguments!\n");
+        return 127;
+    }
+
+    if (write_synthetic_smr(argv[k], &cfg) != 0)
+    {
+        return 1;
+    }
+
+    return 0;
+}
+/* -------------------------------------------------------------------------- */
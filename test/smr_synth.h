@@ -0,0 +1,658 @@
+#ifndef _SMR_SYNTH_H
+#define _SMR_SYNTH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+/* =============================================================================
+Synthetic SMR (SON v6) file writer used by smr_gen and smr_bench
+
+Channels are assigned kinds round-robin from <kinds>, waveform channels
+(continuous and real wave) are sampled at <wave_rate> and all other channels
+carry events at an average rate of <event_rate>. The recording duration is
+chosen so that the data blocks add up to roughly <size_mb>. Blocks are written
+interleaved across channels (one block per channel per round) like a real
+recording, with every block but the last of each channel full.
+synth_channel_records() regenerates the same records in memory so that the
+readers can be checked against what was written.
+
+NOTE: the 32-bit SMR format limits files to 2GB and channels to 65535 blocks,
+      larger requests fail with an error message
+============================================================================= */
+#define SYNTH_MAX_KIND 16
+
+#define SYNTH_HEADER_SIZE 512
+#define SYNTH_CHANNEL_SIZE 140
+#define SYNTH_BLOCK_HEADER_SIZE 20
+
+/* ========================================================================== */
+struct SynthConfig
+{
+    double size_mb;      /*approximate size of all data blocks*/
+    int nchannel;
+    int nkind;
+    uint8_t kinds[SYNTH_MAX_KIND];
+    int block_size;      /*bytes of data per block*/
+    int npt;             /*int16 points per wavemark*/
+    int nreal;           /*floats per real marker*/
+    int ntext;           /*characters per text marker*/
+    double wave_rate;    /*Hz*/
+    double event_rate;   /*Hz*/
+    unsigned int seed;
+};
+/* -------------------------------------------------------------------------- */
+struct SynthChannel
+{
+    uint8_t kind;
+    int16_t nextra;
+    int32_t l_chan_dvd;
+    size_t record_size;
+    uint64_t per_block;  /*records per full block*/
+    uint64_t nrecord;
+    uint64_t nblock;
+    int32_t *offset;     /*file offset of each block*/
+
+    /*generator state*/
+    int32_t time;
+    uint64_t written;
+};
+/* -------------------------------------------------------------------------- */
+/*expected content of one channel, see synth_channel_records*/
+struct SynthRecords
+{
+    uint8_t kind;
+    size_t record_size;  /*bytes per record as stored in the file*/
+    int16_t nextra;      /*bytes of marker data after the time and codes*/
+    uint64_t nrecord;
+    int32_t maxtime;     /*ticks*/
+    uint8_t *data;       /*all records of the channel back to back*/
+};
+/* ========================================================================== */
+void synth_default_config(struct SynthConfig *cfg)
+{
+    cfg->size_mb = 64.0;
+    cfg->nchannel = 8;
+    cfg->nkind = 8;
+    cfg->kinds[0] = 1;
+    cfg->kinds[1] = 2;
+    cfg->kinds[2] = 4;
+    cfg->kinds[3] = 5;
+    cfg->kinds[4] = 6;
+    cfg->kinds[5] = 7;
+    cfg->kinds[6] = 8;
+    cfg->kinds[7] = 9;
+    cfg->block_size = 8192;
+    cfg->npt = 32;
+    cfg->nreal = 4;
+    cfg->ntext = 16;
+    cfg->wave_rate = 25000.0;
+    cfg->event_rate = 100.0;
+    cfg->seed = 1;
+}
+/* -------------------------------------------------------------------------- */
+/*parse a comma separated list of channel kinds (e.g. "1,6") into <cfg>*/
+int synth_parse_kinds(struct SynthConfig *cfg, const char *list)
+{
+    const char *ptr = list;
+
+    cfg->nkind = 0;
+
+    while (*ptr != '\0' && cfg->nkind < SYNTH_MAX_KIND)
+    {
+        int kind = atoi(ptr);
+
+        if (kind < 1 || kind > 9)
+        {
+            return -1;
+        }
+
+        cfg->kinds[cfg->nkind++] = (uint8_t) kind;
+
+        while (*ptr != '\0' && *ptr != ',') { ++ptr; }
+        if (*ptr == ',') { ++ptr; }
+    }
+
+    return cfg->nkind > 0 ? 0 : -1;
+}
+/* -------------------------------------------------------------------------- */
+static int synth_is_wave(uint8_t kind)
+{
+    return kind == 1 || kind == 9;
+}
+/* -------------------------------------------------------------------------- */
+static size_t synth_record_size(struct SynthConfig *cfg, uint8_t kind,
+    int16_t *nextra)
+{
+    *nextra = 0;
+
+    switch (kind)
+    {
+        case 1: return sizeof (int16_t);
+        case 9: return sizeof (float);
+        case 2:
+        case 3:
+        case 4: return sizeof (int32_t);
+        case 5: return 8;
+        case 6: *nextra = (int16_t) (cfg->npt * sizeof (int16_t)); break;
+        case 7: *nextra = (int16_t) (cfg->nreal * sizeof (float)); break;
+        case 8: *nextra = (int16_t) cfg->ntext; break;
+    }
+
+    return 8 + (size_t) *nextra;
+}
+/* -------------------------------------------------------------------------- */
+static uint32_t synth_rand(uint32_t *state)
+{
+    /*xorshift32, deterministic across platforms unlike rand()*/
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state;
+}
+/* -------------------------------------------------------------------------- */
+static void synth_write_string(FILE *fp, const char *str, int pad)
+{
+    uint8_t n = (uint8_t) strlen(str);
+    int k;
+
+    fwrite(&n, 1, 1, fp);
+    fwrite(str, 1, n, fp);
+
+    for (k = n; k < pad; ++k) { fputc(0, fp); }
+}
+/* -------------------------------------------------------------------------- */
+static void synth_write_file_header(FILE *fp, int16_t nchannel,
+    int16_t uspertime, int32_t maxtime)
+{
+    int16_t system_id = 6;
+    int16_t timeperadc = 1;
+    int16_t filestate = 0;
+    int32_t firstdata = SYNTH_HEADER_SIZE + (SYNTH_CHANNEL_SIZE * nchannel);
+    int16_t chansize = SYNTH_CHANNEL_SIZE;
+    int16_t zero = 0;
+    double dtimebase = 1e-6;
+    uint8_t pad[60];
+    int k;
+
+    memset(pad, 0, sizeof (pad));
+
+    fwrite(&system_id, 2, 1, fp);
+    fwrite("(C) CED 87", 1, 10, fp);
+    fwrite("SMRSYNTH", 1, 8, fp);
+    fwrite(&uspertime, 2, 1, fp);
+    fwrite(&timeperadc, 2, 1, fp);
+    fwrite(&filestate, 2, 1, fp);
+    fwrite(&firstdata, 4, 1, fp);
+    fwrite(&nchannel, 2, 1, fp);
+    fwrite(&chansize, 2, 1, fp);
+    fwrite(&zero, 2, 1, fp);        /*extra_data*/
+    fwrite(&zero, 2, 1, fp);        /*buffersize*/
+    fwrite(&zero, 2, 1, fp);        /*osformat*/
+    fwrite(&maxtime, 4, 1, fp);
+    fwrite(&dtimebase, 8, 1, fp);
+    fwrite(pad, 1, 6, fp);          /*time_detail*/
+    fwrite(pad, 1, 2, fp);          /*time_year*/
+    fwrite(pad, 1, 52, fp);
+
+    for (k = 0; k < 5; ++k)
+    {
+        synth_write_string(fp, "", 79);
+    }
+}
+/* -------------------------------------------------------------------------- */
+static void synth_write_channel_header(FILE *fp, struct SynthChannel *ch,
+    int idx, int32_t maxtime, double rate)
+{
+    int16_t zero16 = 0;
+    int32_t none = -1;
+    uint16_t nblock = (uint16_t) ch->nblock;
+    int16_t phy_chan = (int16_t) (idx - 1);
+    int32_t first = ch->nblock > 0 ? ch->offset[0] : -1;
+    int32_t last = ch->nblock > 0 ? ch->offset[ch->nblock-1] : -1;
+    float ideal_rate = (float) rate;
+    float scale = 1.0f;
+    float offset = 0.0f;
+    float fmin = -5.0f;
+    float fmax = 5.0f;
+    int16_t one = 1;
+    int8_t pad = 0;
+    char title[16];
+    long start = ftell(fp);
+
+    sprintf(title, "Ch%d", idx);
+
+    fwrite(&zero16, 2, 1, fp);      /*del_size*/
+    fwrite(&none, 4, 1, fp);        /*next_del_block*/
+    fwrite(&first, 4, 1, fp);
+    fwrite(&last, 4, 1, fp);
+    fwrite(&nblock, 2, 1, fp);
+    fwrite(&ch->nextra, 2, 1, fp);
+    fwrite(&zero16, 2, 1, fp);      /*pre_trig*/
+    fwrite(&zero16, 2, 1, fp);      /*free_0*/
+    fwrite(&zero16, 2, 1, fp);      /*phy_sz*/
+    fwrite(&zero16, 2, 1, fp);      /*max_data*/
+    synth_write_string(fp, "synthetic", 71);
+    fwrite(&maxtime, 4, 1, fp);
+    fwrite(&ch->l_chan_dvd, 4, 1, fp);
+    fwrite(&phy_chan, 2, 1, fp);
+    synth_write_string(fp, title, 9);
+    fwrite(&ideal_rate, 4, 1, fp);
+    fwrite(&ch->kind, 1, 1, fp);
+    fwrite(&pad, 1, 1, fp);
+
+    switch (ch->kind)
+    {
+        case 1:
+        case 6:
+            fwrite(&scale, 4, 1, fp);
+            fwrite(&offset, 4, 1, fp);
+            synth_write_string(fp, "mV", 5);
+            fwrite(&one, 2, 1, fp);
+            break;
+
+        case 7:
+        case 9:
+            fwrite(&fmin, 4, 1, fp);
+            fwrite(&fmax, 4, 1, fp);
+            synth_write_string(fp, "mV", 5);
+            fwrite(&one, 2, 1, fp);
+            break;
+
+        case 4:
+            fputc(1, fp);           /*init_low*/
+            fputc(0, fp);           /*next_low*/
+            break;
+    }
+
+    while (ftell(fp) < start + SYNTH_CHANNEL_SIZE) { fputc(0, fp); }
+}
+/* -------------------------------------------------------------------------- */
+/*write one record of an event type channel into <buf>, returns its time*/
+static int32_t synth_event_record(struct SynthChannel *ch, uint8_t *buf,
+    uint32_t *state, int32_t mean_interval)
+{
+    int32_t time;
+    uint8_t markers[4];
+    size_t k;
+
+    ch->time += 1 + (int32_t) (synth_rand(state) % (uint32_t) (2 * mean_interval));
+    time = ch->time;
+
+    memcpy(buf, &time, 4);
+
+    if (ch->kind < 5)
+    {
+        return time;
+    }
+
+    markers[0] = (uint8_t) (synth_rand(state) % 8);
+    markers[1] = 0;
+    markers[2] = 0;
+    markers[3] = 0;
+
+    memcpy(buf + 4, markers, 4);
+
+    if (ch->kind == 6)
+    {
+        size_t npt = (size_t) ch->nextra / sizeof (int16_t);
+
+        for (k = 0; k < npt; ++k)
+        {
+            int16_t x = (int16_t) (4000.0 * sin(6.283185307 * (double) k / (double) npt));
+            x += (int16_t) (synth_rand(state) % 200) - 100;
+            memcpy(buf + 8 + (k * sizeof (int16_t)), &x, sizeof (int16_t));
+        }
+    }
+    else if (ch->kind == 7)
+    {
+        for (k = 0; k < (size_t) ch->nextra / sizeof (float); ++k)
+        {
+            float x = (float) (synth_rand(state) % 10000) / 1000.0f;
+            memcpy(buf + 8 + (k * sizeof (float)), &x, sizeof (float));
+        }
+    }
+    else if (ch->kind == 8)
+    {
+        char text[16];
+        size_t len;
+
+        sprintf(text, "%u", (unsigned int) (time % 100000));
+        len = strlen(text);
+
+        /*always leave room for a terminating '\0'*/
+        if (len >= (size_t) ch->nextra) { len = (size_t) ch->nextra - 1; }
+
+        memset(buf + 8, 0, (size_t) ch->nextra);
+        memcpy(buf + 8, text, len);
+    }
+
+    return time;
+}
+/* -------------------------------------------------------------------------- */
+/*channel layout of the file described by <cfg>, NULL if it can't be written
+  as SMR. the remaining arguments receive the file-wide timing parameters*/
+static struct SynthChannel *synth_plan(struct SynthConfig *cfg,
+    int16_t *uspertime, int32_t *maxtime, int32_t *mean_interval,
+    uint64_t *max_block)
+{
+    struct SynthChannel *ch;
+
+    double bytes_per_second = 0.0;
+    double duration;
+    double total;
+    uint64_t r;
+    int32_t offset;
+    int k;
+    int err = 0;
+
+    ch = calloc((size_t) cfg->nchannel, sizeof (struct SynthChannel));
+
+    for (k = 0; k < cfg->nchannel; ++k)
+    {
+        ch[k].kind = cfg->kinds[k % cfg->nkind];
+        ch[k].record_size = synth_record_size(cfg, ch[k].kind, &ch[k].nextra);
+
+        bytes_per_second += (double) ch[k].record_size *
+            (synth_is_wave(ch[k].kind) ? cfg->wave_rate : cfg->event_rate);
+    }
+
+    duration = (cfg->size_mb * 1024.0 * 1024.0) / bytes_per_second;
+
+    /*ticks are uspertime microseconds, pick the smallest that keeps the
+      recording within the int32 time range*/
+    *uspertime = (int16_t) ceil((duration * 1e6) / 2.0e9);
+    if (*uspertime < 1) { *uspertime = 1; }
+
+    *maxtime = (int32_t) ((duration * 1e6) / (double) *uspertime);
+    *mean_interval = (int32_t) (1e6 / (cfg->event_rate * (double) *uspertime));
+    if (*mean_interval < 1) { *mean_interval = 1; }
+
+    *max_block = 0;
+
+    total = SYNTH_HEADER_SIZE + (double) (SYNTH_CHANNEL_SIZE * cfg->nchannel);
+
+    for (k = 0; k < cfg->nchannel; ++k)
+    {
+        double rate = synth_is_wave(ch[k].kind) ? cfg->wave_rate : cfg->event_rate;
+
+        ch[k].l_chan_dvd = (int32_t) floor((1e6 / (cfg->wave_rate * (double) *uspertime)) + 0.5);
+        ch[k].per_block = (uint64_t) cfg->block_size / ch[k].record_size;
+        ch[k].nrecord = (uint64_t) (duration * rate);
+
+        if (ch[k].per_block < 1 || ch[k].per_block > 32767 || ch[k].l_chan_dvd < 1)
+        {
+            fprintf(stderr, "[ERROR]: invalid block size or sampling rate\n");
+            err = 1;
+        }
+        else
+        {
+            ch[k].nblock = (ch[k].nrecord + ch[k].per_block - 1) / ch[k].per_block;
+        }
+
+        if (ch[k].nblock > 65535)
+        {
+            fprintf(stderr, "[ERROR]: channel %d needs %lu blocks (max 65535), increase the block size\n",
+                k+1, (unsigned long) ch[k].nblock);
+            err = 1;
+        }
+
+        total += (double) ch[k].nrecord * (double) ch[k].record_size +
+            (double) (ch[k].nblock * SYNTH_BLOCK_HEADER_SIZE);
+
+        if (ch[k].nblock > *max_block) { *max_block = ch[k].nblock; }
+    }
+
+    if (total >= 2147483647.0)
+    {
+        fprintf(stderr, "[ERROR]: requested file exceeds the 2GB limit of the SMR format\n");
+        err = 1;
+    }
+
+    if (err)
+    {
+        free(ch);
+        return NULL;
+    }
+
+    /*block layout is fully determined by the record counts, so compute all
+      offsets up front to be able to write the block chain in one pass*/
+    offset = SYNTH_HEADER_SIZE + (SYNTH_CHANNEL_SIZE * cfg->nchannel);
+
+    for (k = 0; k < cfg->nchannel; ++k)
+    {
+        ch[k].offset = malloc(sizeof (int32_t) * (ch[k].nblock + 1));
+    }
+
+    for (r = 0; r < *max_block; ++r)
+    {
+        for (k = 0; k < cfg->nchannel; ++k)
+        {
+            if (r < ch[k].nblock)
+            {
+                uint64_t nitem = ch[k].nrecord - (r * ch[k].per_block);
+                if (nitem > ch[k].per_block) { nitem = ch[k].per_block; }
+
+                ch[k].offset[r] = offset;
+                offset += SYNTH_BLOCK_HEADER_SIZE + (int32_t) (nitem * ch[k].record_size);
+            }
+        }
+    }
+
+    return ch;
+}
+/* -------------------------------------------------------------------------- */
+static void synth_free_plan(struct SynthChannel *ch, int nchannel)
+{
+    int k;
+
+    for (k = 0; k < nchannel; ++k) { free(ch[k].offset); }
+    free(ch);
+}
+/* -------------------------------------------------------------------------- */
+/*generate the <nitem> records of the next block of <ch> into <buf>. blocks
+  must be generated in file order as they share the random <state>*/
+static void synth_fill_block(struct SynthConfig *cfg, struct SynthChannel *ch,
+    uint64_t nitem, uint8_t *buf, uint32_t *state, int32_t mean_interval,
+    int32_t *start_time, int32_t *end_time)
+{
+    uint64_t j;
+
+    if (synth_is_wave(ch->kind))
+    {
+        for (j = 0; j < nitem; ++j)
+        {
+            double t = (double) (ch->written + j) / cfg->wave_rate;
+            double x = sin(6.283185307 * 7.0 * t) +
+                (0.1 * ((double) (synth_rand(state) % 2000) / 1000.0 - 1.0));
+
+            if (ch->kind == 1)
+            {
+                int16_t v = (int16_t) (x * 8000.0);
+                memcpy(buf + (j * sizeof (int16_t)), &v, sizeof (int16_t));
+            }
+            else
+            {
+                float v = (float) x;
+                memcpy(buf + (j * sizeof (float)), &v, sizeof (float));
+            }
+        }
+
+        *start_time = (int32_t) (ch->written * (uint64_t) ch->l_chan_dvd);
+        *end_time = *start_time + (int32_t) ((nitem - 1) * (uint64_t) ch->l_chan_dvd);
+    }
+    else
+    {
+        *start_time = 0;
+        *end_time = 0;
+
+        for (j = 0; j < nitem; ++j)
+        {
+            *end_time = synth_event_record(ch, buf + (j * ch->record_size),
+                state, mean_interval);
+
+            if (j == 0) { *start_time = *end_time; }
+        }
+    }
+
+    ch->written += nitem;
+}
+/* -------------------------------------------------------------------------- */
+/*returns 0 on success*/
+int write_synthetic_smr(const char *ofile, struct SynthConfig *cfg)
+{
+    struct SynthChannel *ch;
+    FILE *fp;
+
+    int16_t uspertime;
+    int32_t maxtime;
+    int32_t mean_interval;
+    uint64_t max_block;
+    uint64_t r;
+    uint32_t state = cfg->seed ? cfg->seed : 1;
+    int k;
+    int err = 0;
+
+    uint8_t *buf;
+
+    ch = synth_plan(cfg, &uspertime, &maxtime, &mean_interval, &max_block);
+
+    if (ch == NULL)
+    {
+        return -1;
+    }
+
+    if ((fp = fopen(ofile, "wb")) == NULL)
+    {
+        fprintf(stderr, "[ERROR]: failed to open file for writing - %s\n", ofile);
+        synth_free_plan(ch, cfg->nchannel);
+
+        return -1;
+    }
+
+    synth_write_file_header(fp, (int16_t) cfg->nchannel, uspertime, maxtime);
+
+    for (k = 0; k < cfg->nchannel; ++k)
+    {
+        synth_write_channel_header(fp, ch + k, k+1, maxtime,
+            synth_is_wave(ch[k].kind) ? cfg->wave_rate : cfg->event_rate);
+    }
+
+    buf = malloc((size_t) cfg->block_size + 64);
+
+    for (r = 0; r < max_block; ++r)
+    {
+        for (k = 0; k < cfg->nchannel; ++k)
+        {
+            int32_t pred, succ, start_time, end_time;
+            int16_t chan = (int16_t) (k+1);
+            int16_t nitem16;
+            uint64_t nitem;
+
+            if (r >= ch[k].nblock) { continue; }
+
+            nitem = ch[k].nrecord - (r * ch[k].per_block);
+            if (nitem > ch[k].per_block) { nitem = ch[k].per_block; }
+
+            synth_fill_block(cfg, ch + k, nitem, buf, &state, mean_interval,
+                &start_time, &end_time);
+
+            pred = r > 0 ? ch[k].offset[r-1] : -1;
+            succ = r + 1 < ch[k].nblock ? ch[k].offset[r+1] : -1;
+            nitem16 = (int16_t) nitem;
+
+            fwrite(&pred, 4, 1, fp);
+            fwrite(&succ, 4, 1, fp);
+            fwrite(&start_time, 4, 1, fp);
+            fwrite(&end_time, 4, 1, fp);
+            fwrite(&chan, 2, 1, fp);
+            fwrite(&nitem16, 2, 1, fp);
+            fwrite(buf, ch[k].record_size, nitem, fp);
+        }
+    }
+
+    if (fclose(fp) != 0)
+    {
+        err = 1;
+    }
+
+    free(buf);
+    synth_free_plan(ch, cfg->nchannel);
+
+    return err ? -1 : 0;
+}
+/* -------------------------------------------------------------------------- */
+/*the records write_synthetic_smr(<cfg>) stores in each channel, regenerated
+  in memory. returns an array of cfg->nchannel entries (free with
+  synth_free_records) or NULL. <*uspertime> receives the file's tick length
+  in microseconds so record times can be converted to seconds*/
+struct SynthRecords *synth_channel_records(struct SynthConfig *cfg,
+    int16_t *uspertime)
+{
+    struct SynthChannel *ch;
+    struct SynthRecords *rec;
+
+    int32_t maxtime;
+    int32_t mean_interval;
+    int32_t start_time, end_time;
+    uint64_t max_block;
+    uint64_t nitem;
+    uint64_t r;
+    uint32_t state = cfg->seed ? cfg->seed : 1;
+    int k;
+
+    ch = synth_plan(cfg, uspertime, &maxtime, &mean_interval, &max_block);
+
+    if (ch == NULL)
+    {
+        return NULL;
+    }
+
+    rec = calloc((size_t) cfg->nchannel, sizeof (struct SynthRecords));
+
+    for (k = 0; k < cfg->nchannel; ++k)
+    {
+        rec[k].kind = ch[k].kind;
+        rec[k].record_size = ch[k].record_size;
+        rec[k].nextra = ch[k].nextra;
+        rec[k].nrecord = ch[k].nrecord;
+        rec[k].maxtime = maxtime;
+        rec[k].data = malloc(ch[k].record_size * ch[k].nrecord + 1);
+    }
+
+    /*same block order as the writer so the random state matches*/
+    for (r = 0; r < max_block; ++r)
+    {
+        for (k = 0; k < cfg->nchannel; ++k)
+        {
+            if (r >= ch[k].nblock) { continue; }
+
+            nitem = ch[k].nrecord - (r * ch[k].per_block);
+            if (nitem > ch[k].per_block) { nitem = ch[k].per_block; }
+
+            synth_fill_block(cfg, ch + k, nitem,
+                rec[k].data + (ch[k].written * ch[k].record_size), &state,
+                mean_interval, &start_time, &end_time);
+        }
+    }
+
+    synth_free_plan(ch, cfg->nchannel);
+
+    return rec;
+}
+/* -------------------------------------------------------------------------- */
+void synth_free_records(struct SynthRecords *rec, int nchannel)
+{
+    int k;
+
+    if (rec)
+    {
+        for (k = 0; k < nchannel; ++k) { free(rec[k].data); }
+        free(rec);
+    }
+}
+/* ========================================================================== */
+#endif